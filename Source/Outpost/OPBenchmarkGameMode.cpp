@@ -0,0 +1,370 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OPBenchmarkGameMode.h"
+#include "Outpost.h"
+#include "OPProfiling.h"
+#include "Characters/OPEnemy.h"
+#include "Items/OPWeapon.h"
+#include "Subsystems/OPEnemyPoolSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/StaticMeshActor.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Sets default values
+AOPBenchmarkGameMode::AOPBenchmarkGameMode()
+{
+	// Set this game mode to call Tick() every frame. The shooters are driven from here.
+	PrimaryActorTick.bCanEverTick = true;
+
+	//Nobody plays during a benchmark, so no pawn is put in the way of the shooters.
+	bStartPlayersAsSpectators = true;
+}
+
+// Called when the game starts or when spawned
+void AOPBenchmarkGameMode::BeginPlay()
+{
+	Super::BeginPlay();
+
+	EnemyPool = GetWorld()->GetSubsystem<UOPEnemyPoolSubsystem>();
+
+	if (!ReadSettings() || !IsValid(EnemyPool))
+	{
+		UE_LOG(LogOutpost, Error, TEXT("The combat benchmark could not start. Check that its target, shooter and weapon classes are set."));
+
+		Phase = EBenchmarkPhase::Finished;
+
+		if (FApp::IsUnattended()) FPlatformMisc::RequestExitWithStatus(false, 1);
+		return;
+	}
+
+	PrepareArena();
+	SpawnShooters();
+
+	//Enough targets are pre-spawned to fill every spot twice over, since the bodies of dead targets take a few seconds to return to the pool.
+	EnemyPool->PrewarmPool(TargetClass.Get(), TargetCount * 2);
+
+	Phase = EBenchmarkPhase::Prewarming;
+}
+
+// Called every frame
+void AOPBenchmarkGameMode::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Phase == EBenchmarkPhase::Prewarming)
+	{
+		//The wave doesn't start until the pool has finished pre-spawning, so that none of that spawning is measured.
+		if (!EnemyPool->IsPrewarmComplete()) return;
+
+		RefillTargets();
+
+		Phase = EBenchmarkPhase::WarmingUp;
+		PhaseEndTime = GetWorld()->GetTimeSeconds() + WarmupSeconds;
+		return;
+	}
+
+	if (Phase != EBenchmarkPhase::WarmingUp && Phase != EBenchmarkPhase::Running) return;
+
+	if (Phase == EBenchmarkPhase::Running)
+	{
+		//Frames are timed by the wall clock, since the game itself may be running with a fixed time step.
+		const double CurrentWallTime = FPlatformTime::Seconds();
+
+		LongestFrameSeconds = FMath::Max(LongestFrameSeconds, CurrentWallTime - LastFrameWallTime);
+		LastFrameWallTime = CurrentWallTime;
+		FramesMeasured++;
+
+		//Reading the memory stats isn't free, so it's only done a few times a second.
+		if (CurrentWallTime >= NextMemorySampleWallTime)
+		{
+			PeakUsedPhysicalDuringRun = FMath::Max(PeakUsedPhysicalDuringRun, FPlatformMemory::GetStats().UsedPhysical);
+			NextMemorySampleWallTime = CurrentWallTime + 0.25;
+		}
+
+		if (GetWorld()->GetTimeSeconds() >= PhaseEndTime)
+		{
+			FinishBenchmark();
+			return;
+		}
+	}
+	else if (GetWorld()->GetTimeSeconds() >= PhaseEndTime)
+	{
+		StartMeasuring();
+	}
+
+	RefillTargets();
+	FireShooters();
+}
+
+bool AOPBenchmarkGameMode::ReadSettings()
+{
+	TargetCount = FMath::Max(UGameplayStatics::GetIntOption(OptionsString, TEXT("Targets"), TargetCount), 1);
+	ShooterCount = FMath::Max(UGameplayStatics::GetIntOption(OptionsString, TEXT("Shooters"), ShooterCount), 1);
+
+	if (UGameplayStatics::HasOption(OptionsString, TEXT("Seconds"))) BenchmarkSeconds = FCString::Atof(*UGameplayStatics::ParseOption(OptionsString, TEXT("Seconds")));
+	if (UGameplayStatics::HasOption(OptionsString, TEXT("Warmup"))) WarmupSeconds = FCString::Atof(*UGameplayStatics::ParseOption(OptionsString, TEXT("Warmup")));
+
+	BenchmarkSeconds = FMath::Max(BenchmarkSeconds, 1.f);
+	WarmupSeconds = FMath::Max(WarmupSeconds, 0.f);
+
+	//Class options are full class paths, such as "/Game/OPAssets/Items/Weapons/AK47/BP_AK47.BP_AK47_C".
+	if (UGameplayStatics::HasOption(OptionsString, TEXT("TargetClass"))) TargetClass = TSoftClassPtr<AOPEnemy>(FSoftObjectPath(UGameplayStatics::ParseOption(OptionsString, TEXT("TargetClass"))));
+	if (UGameplayStatics::HasOption(OptionsString, TEXT("ShooterClass"))) ShooterClass = TSoftClassPtr<AOPEnemy>(FSoftObjectPath(UGameplayStatics::ParseOption(OptionsString, TEXT("ShooterClass"))));
+	if (UGameplayStatics::HasOption(OptionsString, TEXT("WeaponClass"))) WeaponClass = TSoftClassPtr<AOPWeapon>(FSoftObjectPath(UGameplayStatics::ParseOption(OptionsString, TEXT("WeaponClass"))));
+
+	//Nothing is being measured yet, so the classes can be loaded synchronously.
+	return IsValid(TargetClass.LoadSynchronous()) && IsValid(ShooterClass.LoadSynchronous()) && IsValid(WeaponClass.LoadSynchronous());
+}
+
+void AOPBenchmarkGameMode::PrepareArena()
+{
+	TObjectPtr<AActor> PlayerStart = FindPlayerStart(nullptr);
+
+	ArenaOrigin = IsValid(PlayerStart) ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+
+	//Targets are laid out in a square field, in front of a single row of shooters.
+	const int32 Columns = FMath::CeilToInt(FMath::Sqrt((float)TargetCount));
+	const int32 Rows = FMath::DivideAndRoundUp(TargetCount, Columns);
+
+	FHitResult GroundHit;
+
+	if (GetWorld()->LineTraceSingleByChannel(GroundHit, ArenaOrigin + FVector(0.f, 0.f, 500.f), ArenaOrigin - FVector(0.f, 0.f, 5000.f), ECC_Visibility))
+	{
+		ArenaOrigin = GroundHit.ImpactPoint;
+	}
+	//If there's nothing to stand on, a stretched cube is put down as a floor, with its top at the arena's origin.
+	else
+	{
+		const float FloorSize = 2.f * FMath::Max(TargetDistance + Rows * Spacing, FMath::Max(ShooterCount, Columns) * Spacing);
+
+		TObjectPtr<UStaticMesh> FloorMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+		TObjectPtr<AStaticMeshActor> Floor = GetWorld()->SpawnActor<AStaticMeshActor>(ArenaOrigin - FVector(0.f, 0.f, 50.f), FRotator::ZeroRotator);
+
+		if (IsValid(Floor) && IsValid(FloorMesh))
+		{
+			//The floor is spawned after play has begun, so its mesh can only be set while it's movable.
+			Floor->SetMobility(EComponentMobility::Movable);
+			Floor->GetStaticMeshComponent()->SetStaticMesh(FloorMesh);
+			Floor->SetActorScale3D(FVector(FloorSize / 100.f, FloorSize / 100.f, 1.f));
+		}
+	}
+
+	const float TargetHalfHeight = GetDefault<AOPEnemy>(TargetClass.Get())->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	TargetTransforms.Reset(TargetCount);
+
+	for (int32 i = 0; i < TargetCount; i++)
+	{
+		const FVector TargetOffset(TargetDistance + (i / Columns) * Spacing, ((i % Columns) - (Columns - 1) * 0.5f) * Spacing, TargetHalfHeight);
+
+		//Targets face back towards the shooters.
+		TargetTransforms.Emplace(FRotator(0.f, 180.f, 0.f), ArenaOrigin + TargetOffset);
+	}
+
+	Targets.SetNum(TargetCount);
+}
+
+void AOPBenchmarkGameMode::SpawnShooters()
+{
+	const float ShooterHalfHeight = GetDefault<AOPEnemy>(ShooterClass.Get())->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	for (int32 i = 0; i < ShooterCount; i++)
+	{
+		const FTransform SpawnTransform(FRotator::ZeroRotator, ArenaOrigin + FVector(0.f, (i - (ShooterCount - 1) * 0.5f) * Spacing, ShooterHalfHeight));
+
+		//Shooters are never possessed by AI, so that they only fire when the benchmark tells them to.
+		TObjectPtr<AOPEnemy> Shooter = GetWorld()->SpawnActorDeferred<AOPEnemy>(ShooterClass.Get(), SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+
+		if (!IsValid(Shooter)) continue;
+
+		Shooter->AutoPossessAI = EAutoPossessAI::Disabled;
+		Shooter->FinishSpawning(SpawnTransform);
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = Shooter;
+		SpawnParams.Instigator = Shooter;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TObjectPtr<AOPWeapon> Weapon = GetWorld()->SpawnActor<AOPWeapon>(WeaponClass.Get(), SpawnTransform, SpawnParams);
+
+		if (!IsValid(Weapon))
+		{
+			Shooter->Destroy();
+			continue;
+		}
+
+		Weapon->AttachToComponent(Shooter->GetMesh(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, Weapon->AttachToSocket);
+
+		Shooters.Emplace(Shooter);
+		ShooterWeapons.Emplace(Weapon);
+		NextFireTimes.Emplace(0.f);
+	}
+}
+
+void AOPBenchmarkGameMode::RefillTargets()
+{
+	for (int32 i = 0; i < Targets.Num(); i++)
+	{
+		TObjectPtr<AOPEnemy> Target = Targets[i];
+
+		//Dead targets are left to ragdoll and return to the pool by themselves, while a new one takes their spot straight away.
+		if (IsValid(Target) && !Target->IsCharacterDead() && !Target->IsDormant()) continue;
+
+		Targets[i] = EnemyPool->AcquireEnemy(TargetClass.Get(), TargetTransforms[i]);
+
+		if (IsValid(Targets[i]) && Phase == EBenchmarkPhase::Running) TargetsSpawned++;
+	}
+}
+
+void AOPBenchmarkGameMode::FireShooters()
+{
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = 0; i < Shooters.Num(); i++)
+	{
+		if (NextFireTimes[i] > CurrentTime) continue;
+
+		TObjectPtr<AOPWeapon> Weapon = ShooterWeapons[i];
+		TObjectPtr<AOPEnemy> Target = FindTarget(i);
+
+		if (!IsValid(Weapon) || !IsValid(Target)) continue;
+
+		//Shooters keep track of their own fire rate and reloads, the same way that turrets do.
+		if (Weapon->FireFromMuzzle(Target->GetActorLocation(), ShooterSpreadMultiplier))
+		{
+			NextFireTimes[i] = CurrentTime + Weapon->Stats.FireRate;
+
+			if (Phase == EBenchmarkPhase::Running) ShotsFired++;
+		}
+		else
+		{
+			Weapon->ResetWeaponState();
+			NextFireTimes[i] = CurrentTime + ReloadTime;
+		}
+	}
+}
+
+AOPEnemy* AOPBenchmarkGameMode::FindTarget(int32 ShooterIndex) const
+{
+	if (Targets.IsEmpty()) return nullptr;
+
+	//Each shooter starts looking from a different spot, so that their fire is spread over the whole field.
+	const int32 FirstIndex = ShooterIndex * Targets.Num() / FMath::Max(Shooters.Num(), 1);
+
+	for (int32 i = 0; i < Targets.Num(); i++)
+	{
+		TObjectPtr<AOPEnemy> Target = Targets[(FirstIndex + i) % Targets.Num()];
+
+		if (IsValid(Target) && !Target->IsCharacterDead()) return Target;
+	}
+
+	return nullptr;
+}
+
+void AOPBenchmarkGameMode::StartMeasuring()
+{
+#if OP_PROFILING_ENABLED
+	FOPProfiler::Reset();
+	FOPProfiler::SetTimingEnabled(true);
+#endif
+
+	ShotsFired = 0;
+	TargetsSpawned = 0;
+	PoolMissesAtStart = EnemyPool->PoolMisses;
+
+	RunStartWallTime = FPlatformTime::Seconds();
+	RunStartGameTime = GetWorld()->GetTimeSeconds();
+	LastFrameWallTime = RunStartWallTime;
+	LongestFrameSeconds = 0.0;
+	NextMemorySampleWallTime = RunStartWallTime;
+	FramesMeasured = 0;
+	PeakUsedPhysicalDuringRun = 0;
+
+	Phase = EBenchmarkPhase::Running;
+	PhaseEndTime = RunStartGameTime + BenchmarkSeconds;
+
+	UE_LOG(LogOutpost, Display, TEXT("Combat benchmark started with %d targets and %d shooters, for %.1f seconds."), TargetCount, Shooters.Num(), BenchmarkSeconds);
+}
+
+void AOPBenchmarkGameMode::FinishBenchmark()
+{
+	const double WallSeconds = FPlatformTime::Seconds() - RunStartWallTime;
+	const float GameSeconds = GetWorld()->GetTimeSeconds() - RunStartGameTime;
+
+#if OP_PROFILING_ENABLED
+	FOPProfiler::SetTimingEnabled(false);
+#endif
+
+	Phase = EBenchmarkPhase::Finished;
+
+	const FString Report = BuildReport(WallSeconds, GameSeconds);
+
+	FString ReportPath = UGameplayStatics::ParseOption(OptionsString, TEXT("Report"));
+
+	if (ReportPath.IsEmpty()) ReportPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), FString::Printf(TEXT("Combat_%s.json"), *FDateTime::Now().ToString()));
+
+	UE_LOG(LogOutpost, Display, TEXT("Combat benchmark finished.\n%s"), *Report);
+
+	if (FFileHelper::SaveStringToFile(Report, *ReportPath))
+	{
+		UE_LOG(LogOutpost, Display, TEXT("Combat benchmark report written to %s."), *ReportPath);
+	}
+	else
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Combat benchmark report could not be written to %s."), *ReportPath);
+	}
+
+	if (FApp::IsUnattended()) FPlatformMisc::RequestExit(false);
+}
+
+FString AOPBenchmarkGameMode::BuildReport(double WallSeconds, float GameSeconds) const
+{
+	//Throughput is measured against the wall clock, since that's what gets slower when the game does.
+	const auto PerSecond = [WallSeconds](double Count) { return WallSeconds > 0.0 ? Count / WallSeconds : 0.0; };
+
+	int64 Traces = 0;
+	int64 DamageEvents = 0;
+	int64 Deaths = 0;
+
+#if OP_PROFILING_ENABLED
+	Traces = FOPProfiler::GetCallCount(EOPProfiledSystem::WeaponTrace);
+	DamageEvents = FOPProfiler::GetCallCount(EOPProfiledSystem::TakePointDamage);
+	Deaths = FOPProfiler::GetCallCount(EOPProfiledSystem::CharacterDeath);
+#endif
+
+	const double BytesPerMB = 1024.0 * 1024.0;
+
+	FString Report = TEXT("{\n");
+
+	Report += FString::Printf(TEXT("\t\"Targets\": %d,\n\t\"Shooters\": %d,\n"), TargetCount, Shooters.Num());
+	Report += FString::Printf(TEXT("\t\"GameSeconds\": %.3f,\n\t\"WallSeconds\": %.3f,\n"), GameSeconds, WallSeconds);
+	Report += FString::Printf(TEXT("\t\"Frames\": %d,\n\t\"AverageFrameMs\": %.3f,\n\t\"LongestFrameMs\": %.3f,\n"), FramesMeasured, FramesMeasured > 0 ? WallSeconds * 1000.0 / FramesMeasured : 0.0, LongestFrameSeconds * 1000.0);
+	Report += FString::Printf(TEXT("\t\"Shots\": %d,\n\t\"ShotsPerSecond\": %.2f,\n"), ShotsFired, PerSecond(ShotsFired));
+	Report += FString::Printf(TEXT("\t\"Traces\": %lld,\n\t\"TracesPerSecond\": %.2f,\n"), Traces, PerSecond(Traces));
+	Report += FString::Printf(TEXT("\t\"DamageEvents\": %lld,\n\t\"DamageEventsPerSecond\": %.2f,\n"), DamageEvents, PerSecond(DamageEvents));
+	Report += FString::Printf(TEXT("\t\"Deaths\": %lld,\n\t\"DeathsPerSecond\": %.2f,\n"), Deaths, PerSecond(Deaths));
+	Report += FString::Printf(TEXT("\t\"Spawns\": %d,\n\t\"SpawnsPerSecond\": %.2f,\n\t\"PoolMisses\": %d,\n"), TargetsSpawned, PerSecond(TargetsSpawned), EnemyPool->PoolMisses - PoolMissesAtStart);
+	Report += FString::Printf(TEXT("\t\"PeakUsedPhysicalMB\": %.1f,\n\t\"ProcessPeakUsedPhysicalMB\": %.1f,\n"), PeakUsedPhysicalDuringRun / BytesPerMB, FPlatformMemory::GetStats().PeakUsedPhysical / BytesPerMB);
+
+	Report += TEXT("\t\"Systems\": {");
+
+#if OP_PROFILING_ENABLED
+	for (int32 i = 0; i < (int32)EOPProfiledSystem::Count; i++)
+	{
+		const EOPProfiledSystem System = (EOPProfiledSystem)i;
+		const int64 Calls = FOPProfiler::GetCallCount(System);
+		const double TotalSeconds = FOPProfiler::GetTotalSeconds(System);
+
+		Report += FString::Printf(TEXT("%s\n\t\t\"%s\": { \"Calls\": %lld, \"TotalMs\": %.3f, \"AverageUs\": %.3f, \"MaxUs\": %.3f }"), i > 0 ? TEXT(",") : TEXT(""), FOPProfiler::GetSystemName(System), Calls, TotalSeconds * 1000.0, Calls > 0 ? TotalSeconds * 1000000.0 / Calls : 0.0, FOPProfiler::GetMaxSeconds(System) * 1000000.0);
+	}
+
+	Report += TEXT("\n\t");
+#endif
+
+	Report += TEXT("}\n}");
+
+	return Report;
+}
\ No newline at end of file
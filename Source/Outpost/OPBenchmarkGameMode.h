@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "OPEnums.h"
+#include "OPBenchmarkGameMode.generated.h"
+
+//Forward declarations.
+class AOPEnemy;
+class AOPWeapon;
+class UOPEnemyPoolSubsystem;
+
+/**
+ * Runs a scripted combat wave with no player and no rendering, and reports how quickly the game got through it.
+ * A row of armed shooters fires at a field of target enemies for a set amount of time. Every shot goes through the same trace, damage and death pipeline as real gameplay,
+ * and targets that die are replaced from the enemy pool straight away.
+ * Selected with the "Benchmark" game mode alias, and works on any map. If the map has no ground, a floor is put down first. For example:
+ * "UnrealEditor Outpost.uproject /Engine/Maps/Entry?game=Benchmark?Targets=64?Shooters=16?Seconds=30 -game -nullrhi -benchmark -fps=30 -unattended"
+ * The report is written as JSON to Saved/Benchmarks (or the "Report" URL option), and the game quits once it's written if it was started with "-unattended".
+ * Per-system timings, and the trace, damage and death counts, come from OPProfiling.h, so they are only reported outside of shipping builds.
+ */
+UCLASS(Config = Game)
+class OUTPOST_API AOPBenchmarkGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this game mode's properties
+	AOPBenchmarkGameMode();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	UFUNCTION(BlueprintPure, Category = "OPBenchmarkGameMode")
+		FORCEINLINE EBenchmarkPhase GetPhase() const { return Phase; }
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	/* Combatants */
+
+	//The enemy that is shot at. Can be overridden with the "TargetClass" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		TSoftClassPtr<AOPEnemy> TargetClass;
+
+	//The enemy that does the shooting. Shooters aren't possessed by AI, and only ever fire when the benchmark tells them to. Can be overridden with the "ShooterClass" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		TSoftClassPtr<AOPEnemy> ShooterClass;
+
+	//The weapon that every shooter is given. Can be overridden with the "WeaponClass" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		TSoftClassPtr<AOPWeapon> WeaponClass;
+
+	//How many targets are kept alive at once. Can be overridden with the "Targets" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		int32 TargetCount = 64;
+
+	//Can be overridden with the "Shooters" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		int32 ShooterCount = 16;
+
+	//Multiplies the spread of every shooter's weapon. Higher values make more shots miss.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		float ShooterSpreadMultiplier = 1.f;
+
+	//How long a shooter waits after emptying its magazine, before it fires again.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Combatants")
+		float ReloadTime = 1.5f;
+
+	/* Layout */
+
+	//How far the field of targets starts in front of the row of shooters.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Layout")
+		float TargetDistance = 1500.f;
+
+	//The space between neighbouring shooters, and between neighbouring targets.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Layout")
+		float Spacing = 200.f;
+
+	/* Timing */
+
+	//How long the wave runs before anything is measured, so that the first kills and pool refills aren't counted. Can be overridden with the "Warmup" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Timing")
+		float WarmupSeconds = 2.f;
+
+	//How long the wave is measured for, in game time. Can be overridden with the "Seconds" URL option.
+	UPROPERTY(Config, EditDefaultsOnly, BlueprintReadOnly, Category = "OPBenchmarkGameMode|Timing")
+		float BenchmarkSeconds = 30.f;
+
+	/* Stats */
+
+	UPROPERTY(BlueprintReadOnly, Category = "OPBenchmarkGameMode|Stats")
+		int32 ShotsFired;
+
+	//The number of targets that were brought into play to replace ones that died.
+	UPROPERTY(BlueprintReadOnly, Category = "OPBenchmarkGameMode|Stats")
+		int32 TargetsSpawned;
+
+	UPROPERTY()
+		TObjectPtr<UOPEnemyPoolSubsystem> EnemyPool;
+
+	UPROPERTY()
+		TArray<TObjectPtr<AOPEnemy>> Shooters;
+
+	//The weapon held by each shooter, indexed the same way as Shooters.
+	UPROPERTY()
+		TArray<TObjectPtr<AOPWeapon>> ShooterWeapons;
+
+	//The target standing in each spot of the target field. Empty, or dead, until the spot is refilled.
+	UPROPERTY()
+		TArray<TObjectPtr<AOPEnemy>> Targets;
+
+	//Where each spot of the target field is.
+	TArray<FTransform> TargetTransforms;
+
+	//The time at which each shooter is next allowed to fire.
+	TArray<float> NextFireTimes;
+
+	EBenchmarkPhase Phase = EBenchmarkPhase::Idle;
+
+	//The game time at which the current phase ends.
+	float PhaseEndTime;
+
+	//Where the shooters and targets are laid out from.
+	FVector ArenaOrigin;
+
+	/* Measurements */
+
+	double RunStartWallTime;
+	double LastFrameWallTime;
+	double LongestFrameSeconds;
+	double NextMemorySampleWallTime;
+	float RunStartGameTime;
+	int32 FramesMeasured;
+	int32 PoolMissesAtStart;
+	uint64 PeakUsedPhysicalDuringRun;
+
+	//Reads every URL option that overrides a default, and loads the combatant classes.
+	bool ReadSettings();
+
+	//Works out where every shooter and target stands, and puts down a floor if the map doesn't have any ground there.
+	void PrepareArena();
+
+	void SpawnShooters();
+
+	//Brings a new target into every spot whose target has died or was never spawned.
+	void RefillTargets();
+
+	//Fires every shooter that is ready at a living target.
+	void FireShooters();
+
+	//Returns a living target for a shooter to aim at, or nothing if every target is dead.
+	AOPEnemy* FindTarget(int32 ShooterIndex) const;
+
+	void StartMeasuring();
+	void FinishBenchmark();
+
+	//Builds the JSON report from everything that was measured.
+	FString BuildReport(double WallSeconds, float GameSeconds) const;
+};
\ No newline at end of file
@@ -3,4 +3,6 @@
 #include "Outpost.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogOutpost);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Outpost, "Outpost" );
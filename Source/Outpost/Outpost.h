@@ -2,4 +2,6 @@
 
 #pragma once
 
-#include "CoreMinimal.h"
\ No newline at end of file
+#include "CoreMinimal.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogOutpost, Log, All);
\ No newline at end of file
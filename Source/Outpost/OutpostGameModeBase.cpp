@@ -2,4 +2,598 @@
 
 
 #include "OutpostGameModeBase.h"
+#include "Outpost.h"
+#include "Data/OPWaveDefinition.h"
+#include "Characters/OPEnemy.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Subsystems/OPEnemyPoolSubsystem.h"
+#include "Subsystems/OPSpawnQuerySubsystem.h"
+#include "Subsystems/OPFlowFieldSubsystem.h"
+#include "Subsystems/OPCrowdSubsystem.h"
+#include "Subsystems/OPLootSubsystem.h"
+#include "Subsystems/OPEconomySubsystem.h"
+#include "Subsystems/OPShopSubsystem.h"
+#include "Subsystems/OPGenerationSubsystem.h"
+#include "Subsystems/OPNavBuildSubsystem.h"
+#include "Subsystems/OPAreaStreamingSubsystem.h"
+#include "Subsystems/OPSaveSubsystem.h"
+#include "Subsystems/OPReplaySubsystem.h"
+#include "Data/OPSaveGame.h"
+#include "Data/OPCheckpoint.h"
+#include "Characters/OPPlayer.h"
+#include "Items/OPWeapon.h"
+#include "GameFramework/Character.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/AssetManager.h"
+#include "Kismet/GameplayStatics.h"
 
+// Sets default values
+AOutpostGameModeBase::AOutpostGameModeBase()
+{
+	// Set this game mode to call Tick() every frame. Spawning for each wave is spread across frames here.
+	PrimaryActorTick.bCanEverTick = true;
+
+}
+
+// Called when the game starts or when spawned
+void AOutpostGameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Get references to every subsystem that the wave director uses.
+	WorldSubsystem = GetWorld()->GetSubsystem<UOPWorldSubsystem>();
+	EnemyPool = GetWorld()->GetSubsystem<UOPEnemyPoolSubsystem>();
+	SpawnQuery = GetWorld()->GetSubsystem<UOPSpawnQuerySubsystem>();
+	FlowField = GetWorld()->GetSubsystem<UOPFlowFieldSubsystem>();
+	Crowd = GetWorld()->GetSubsystem<UOPCrowdSubsystem>();
+	Loot = GetWorld()->GetSubsystem<UOPLootSubsystem>();
+	Economy = GetWorld()->GetSubsystem<UOPEconomySubsystem>();
+	Generation = GetWorld()->GetSubsystem<UOPGenerationSubsystem>();
+	NavBuild = GetWorld()->GetSubsystem<UOPNavBuildSubsystem>();
+	SaveSubsystem = GetGameInstance()->GetSubsystem<UOPSaveSubsystem>();
+	Replay = GetWorld()->GetSubsystem<UOPReplaySubsystem>();
+
+	//Let every other system know where the outpost is.
+	TArray<AActor*> OutpostActors;
+	UGameplayStatics::GetAllActorsWithTag(this, OutpostTag, OutpostActors);
+
+	if (IsValid(WorldSubsystem) && OutpostActors.Num() > 0) WorldSubsystem->OutpostLocation = OutpostActors[0]->GetActorLocation();
+
+	//Give the shop its catalog.
+	TObjectPtr<UOPShopSubsystem> ShopSubsystem = GetWorld()->GetSubsystem<UOPShopSubsystem>();
+
+	if (IsValid(ShopSubsystem)) ShopSubsystem->SetCatalog(ShopCatalog);
+
+	//Bind a callback function to OnEnemyUpdate delegate.
+	if (IsValid(WorldSubsystem)) WorldSubsystem->OnEnemyUpdate.AddDynamic(this, &AOutpostGameModeBase::UpdateEnemiesAlive);
+
+	if (IsValid(Replay))
+	{
+		const FString ReplaySlotName = UGameplayStatics::ParseOption(OptionsString, TEXT("Replay"));
+
+		//A replay decides which area is generated, so nothing else starts until it has been read.
+		if (!ReplaySlotName.IsEmpty() && Replay->LoadReplay(ReplaySlotName))
+		{
+			Replay->OnReplayLoaded.AddDynamic(this, &AOutpostGameModeBase::OnReplayLoaded);
+			return;
+		}
+
+		const FString RecordingSlotName = UGameplayStatics::HasOption(OptionsString, TEXT("Record")) ? UGameplayStatics::ParseOption(OptionsString, TEXT("Record")) : RecordSlotName;
+
+		if (!RecordingSlotName.IsEmpty()) Replay->StartRecording(RecordingSlotName);
+	}
+
+	StartArea();
+}
+
+void AOutpostGameModeBase::StartArea()
+{
+	//If the area is being generated, the first wave waits until it has finished.
+	if (IsValid(GenerationSettings) && IsValid(Generation))
+	{
+		int32 Seed = UGameplayStatics::GetIntOption(OptionsString, TEXT("Seed"), GenerationSeed);
+
+		//A loaded save game always continues in the area that it was saved in, and a replay always plays back in the area that it was recorded in.
+		if (IsValid(SaveSubsystem) && IsValid(SaveSubsystem->GetLoadedSave()) && SaveSubsystem->GetLoadedSave()->Seed != 0) Seed = SaveSubsystem->GetLoadedSave()->Seed;
+		if (IsValid(Replay) && Replay->GetReplaySeed() != 0) Seed = Replay->GetReplaySeed();
+
+		if (Seed == 0) Seed = FMath::Rand();
+
+		if (IsValid(Replay)) Replay->SetSeed(Seed);
+
+		TObjectPtr<AActor> PlayerStart = FindPlayerStart(nullptr);
+
+		Generation->OnGenerationComplete.AddDynamic(this, &AOutpostGameModeBase::OnAreaGenerated);
+
+		//The navmesh is held back until everything has been placed, and then rebuilt around the player first.
+		if (IsValid(NavBuild)) NavBuild->DeferNavigationBuild();
+
+		if (Generation->StartGeneration(GenerationSettings, Seed, IsValid(PlayerStart) ? PlayerStart->GetActorLocation() : FVector::ZeroVector)) return;
+
+		//Generation never started, so BuildArea will never be called to lift the lock.
+		if (IsValid(NavBuild)) NavBuild->EndDeferredBuild();
+	}
+
+	StartFirstWave();
+}
+
+// Called every frame
+void AOutpostGameModeBase::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bIsWaveInProgress && !bWaitingForPlacements && NextSpawnQueueIndex < SpawnQueue.Num()) ProcessSpawnQueue();
+}
+
+void AOutpostGameModeBase::OnReplayLoaded(const FString& SlotName, bool bSuccess)
+{
+	Replay->OnReplayLoaded.RemoveDynamic(this, &AOutpostGameModeBase::OnReplayLoaded);
+
+	StartArea();
+}
+
+void AOutpostGameModeBase::OnAreaGenerated()
+{
+	const FOPGeneratedLayout& Layout = Generation->GetGeneratedLayout();
+
+	if (IsValid(WorldSubsystem)) WorldSubsystem->OutpostLocation = Layout.OutpostLocation;
+
+	//The player is moved onto the ground at the generated start, with their capsule sitting on top of it.
+	TObjectPtr<ACharacter> PlayerCharacter = UGameplayStatics::GetPlayerCharacter(this, 0);
+
+	if (IsValid(PlayerCharacter)) PlayerCharacter->TeleportTo(Layout.PlayerStart + FVector(0.f, 0.f, PlayerCharacter->GetCapsuleComponent()->GetScaledCapsuleHalfHeight()), PlayerCharacter->GetActorRotation());
+
+	//Spawn locations and the flow field both need the navmesh, so the first wave waits for it.
+	if (IsValid(NavBuild))
+	{
+		NavBuild->OnNavBuildComplete.AddDynamic(this, &AOutpostGameModeBase::OnAreaNavigationBuilt);
+		NavBuild->BuildArea(Generation->GetAreaBounds());
+
+		if (NavBuild->IsBuilding()) return;
+	}
+
+	OnAreaNavigationBuilt();
+}
+
+void AOutpostGameModeBase::OnAreaNavigationBuilt()
+{
+	if (IsValid(NavBuild)) NavBuild->OnNavBuildComplete.RemoveDynamic(this, &AOutpostGameModeBase::OnAreaNavigationBuilt);
+
+	StartFirstWave();
+}
+
+void AOutpostGameModeBase::RetryArea()
+{
+	FString Options;
+
+	if (IsValid(Generation) && (Generation->IsGenerating() || Generation->IsGenerationComplete())) Options = FString::Printf(TEXT("Seed=%d"), Generation->GetGeneratedLayout().Seed);
+
+	UGameplayStatics::OpenLevel(this, FName(UGameplayStatics::GetCurrentLevelName(this)), true, Options);
+}
+
+void AOutpostGameModeBase::WriteToSaveGame(UOPSaveGame* SaveGame) const
+{
+	if (!IsValid(SaveGame)) return;
+
+	SaveGame->Seed = IsValid(Generation) && Generation->IsGenerationComplete() ? Generation->GetGeneratedLayout().Seed : 0;
+
+	//A wave that was saved partway through is fought again from the start.
+	SaveGame->WaveIndex = FMath::Max(CurrentWaveIndex, LastClearedWaveIndex + 1);
+}
+
+void AOutpostGameModeBase::WriteToCheckpoint(FOPCheckpoint& Checkpoint) const
+{
+	Checkpoint.WaveIndex = CurrentWaveIndex;
+	Checkpoint.WaveTime = GetWorld()->GetTimeSeconds() - WaveStartTime;
+	Checkpoint.WaveTelemetry = WaveTelemetry;
+	Checkpoint.SpawnSeed = SpawnStream.GetCurrentSeed();
+	Checkpoint.SpawnZoneLocations = SpawnZoneLocations;
+	Checkpoint.NextSpawnZoneIndex = NextSpawnZoneIndex;
+
+	//Only the enemies that haven't spawned yet are kept.
+	for (int32 i = NextSpawnQueueIndex; i < SpawnQueue.Num(); i++)
+	{
+		Checkpoint.SpawnQueue.Emplace(Checkpoint.FindOrAddAsset(SpawnQueue[i]));
+	}
+}
+
+bool AOutpostGameModeBase::CanRestoreCheckpoint(const FOPCheckpoint& Checkpoint) const
+{
+	//The wave's assets are what keep its enemy classes loaded, so a checkpoint can only be restored into the wave that it was taken in.
+	return Checkpoint.WaveIndex == CurrentWaveIndex && IsValid(CurrentWave) && bWaveAssetsLoaded;
+}
+
+void AOutpostGameModeBase::ReadFromCheckpoint(const FOPCheckpoint& Checkpoint)
+{
+	if (!CanRestoreCheckpoint(Checkpoint)) return;
+
+	//A checkpoint that was loaded from disk is restored during its wave's prep time, which sends the wave in right away.
+	const bool bWasWaveInProgress = bIsWaveInProgress;
+
+	GetWorldTimerManager().ClearTimer(PrepHandle);
+
+	bIsWaveInProgress = true;
+	bStartWaveWhenLoaded = false;
+
+	WaveTelemetry = Checkpoint.WaveTelemetry;
+	WaveTelemetry.WaveIndex = CurrentWaveIndex;
+	WaveStartTime = GetWorld()->GetTimeSeconds() - Checkpoint.WaveTime;
+
+	SpawnStream.Initialize(Checkpoint.SpawnSeed);
+	SpawnZoneLocations = Checkpoint.SpawnZoneLocations;
+	NextSpawnZoneIndex = SpawnZoneLocations.IsValidIndex(Checkpoint.NextSpawnZoneIndex) ? Checkpoint.NextSpawnZoneIndex : 0;
+
+	SpawnQueue.Reset();
+	NextSpawnQueueIndex = 0;
+
+	for (const int32 Index : Checkpoint.SpawnQueue)
+	{
+		TSubclassOf<AOPEnemy> EnemyClass = Cast<UClass>(Checkpoint.LoadAsset(Index));
+
+		if (IsValid(EnemyClass)) SpawnQueue.Emplace(EnemyClass);
+	}
+
+	//The economy's log was rolled back along with the player, so anything earned from here on belongs to this wave again.
+	if (IsValid(Economy)) Economy->RecordWaveStarted(CurrentWaveIndex);
+
+	if (!bWasWaveInProgress) OnWaveStarted.Broadcast(CurrentWaveIndex);
+}
+
+void AOutpostGameModeBase::SetWaveHeld(bool bNewHeld)
+{
+	bIsWaveHeld = bNewHeld;
+
+	//Once the wave is let go of, it's checked straight away in case it was cleared in the meantime.
+	if (!bIsWaveHeld) UpdateEnemiesAlive();
+}
+
+void AOutpostGameModeBase::StartFirstWave()
+{
+	int32 FirstWaveIndex = 0;
+
+	//A save game that was loaded before the level opened is applied once the area is ready, and then forgotten about so that it's only applied once.
+	TObjectPtr<UOPSaveGame> LoadedSave = IsValid(SaveSubsystem) ? SaveSubsystem->GetLoadedSave() : nullptr;
+
+	//The save game's weapons are loaded in the background first, while the loading screen is still up.
+	if (IsValid(LoadedSave) && !bSaveAssetsRequested)
+	{
+		TArray<FSoftObjectPath> WeaponPaths;
+
+		for (const FSavedWeapon& Index : LoadedSave->Weapons)
+		{
+			if (!Index.WeaponClass.IsNull()) WeaponPaths.AddUnique(Index.WeaponClass.ToSoftObjectPath());
+		}
+
+		if (!WeaponPaths.IsEmpty())
+		{
+			bSaveAssetsRequested = true;
+			SaveAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(WeaponPaths, FStreamableDelegate::CreateUObject(this, &AOutpostGameModeBase::OnSaveAssetsLoaded));
+			return;
+		}
+	}
+
+	if (IsValid(LoadedSave))
+	{
+		TObjectPtr<AOPPlayer> Player = Cast<AOPPlayer>(UGameplayStatics::GetPlayerCharacter(this, 0));
+
+		TArray<TSubclassOf<AOPWeapon>> WeaponClasses;
+		WeaponClasses.Reserve(LoadedSave->Weapons.Num());
+
+		for (const FSavedWeapon& Index : LoadedSave->Weapons)
+		{
+			WeaponClasses.Emplace(Index.WeaponClass.Get());
+		}
+
+		if (IsValid(Player)) Player->ReadFromSaveGame(LoadedSave, WeaponClasses);
+
+		if (IsValid(Economy)) Economy->RestoreFromLog(LoadedSave->TransactionLog);
+
+		//Crates that were looted and barricades that were damaged are put back the way they were.
+		TObjectPtr<UOPAreaStreamingSubsystem> AreaStreaming = GetWorld()->GetSubsystem<UOPAreaStreamingSubsystem>();
+
+		if (IsValid(AreaStreaming)) AreaStreaming->ReadFromSaveGame(LoadedSave);
+
+		FirstWaveIndex = LoadedSave->WaveIndex;
+		LastClearedWaveIndex = FirstWaveIndex - 1;
+
+		SaveSubsystem->ClearLoadedSave();
+	}
+
+	//The player now holds the weapons, so they stay loaded without the handle.
+	if (SaveAssetsHandle.IsValid())
+	{
+		SaveAssetsHandle->ReleaseHandle();
+		SaveAssetsHandle.Reset();
+	}
+
+	//Recording and replaying only start now, once everything that takes a different number of frames on every machine has finished.
+	if (IsValid(Replay)) Replay->StartSession();
+
+	if (bStartWavesAutomatically) StartWavePrep(FirstWaveIndex);
+}
+
+void AOutpostGameModeBase::OnSaveAssetsLoaded()
+{
+	StartFirstWave();
+}
+
+void AOutpostGameModeBase::StartWavePrep(int32 WaveIndex)
+{
+	if (!Waves.IsValidIndex(WaveIndex) || bIsWaveInProgress) return;
+
+	CurrentWaveIndex = WaveIndex;
+	CurrentWave = nullptr;
+	bWaveAssetsLoaded = false;
+	bStartWaveWhenLoaded = false;
+
+	//The wave definition itself is loaded first, since it determines which other assets the wave will need.
+	WaveAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Waves[WaveIndex].ToSoftObjectPath(), FStreamableDelegate::CreateUObject(this, &AOutpostGameModeBase::OnWaveDefinitionLoaded));
+}
+
+void AOutpostGameModeBase::OnWaveDefinitionLoaded()
+{
+	CurrentWave = Waves[CurrentWaveIndex].Get();
+
+	if (!IsValid(CurrentWave))
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Wave %d could not be loaded."), CurrentWaveIndex);
+		return;
+	}
+
+	//Every enemy class in the wave is loaded in the background, while the player is preparing.
+	TArray<FSoftObjectPath> AssetsToLoad;
+
+	for (const FWaveEnemyGroup& Index : CurrentWave->EnemyGroups)
+	{
+		if (!Index.EnemyClass.IsNull()) AssetsToLoad.AddUnique(Index.EnemyClass.ToSoftObjectPath());
+	}
+
+	WaveAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate::CreateUObject(this, &AOutpostGameModeBase::OnWaveAssetsLoaded));
+
+	//If there was nothing to load, then the streamable manager won't call back.
+	if (!WaveAssetsHandle.IsValid()) OnWaveAssetsLoaded();
+
+	//Set a timer for when the prep time will end, and the wave will approach.
+	GetWorldTimerManager().SetTimer(PrepHandle, this, &AOutpostGameModeBase::StartWave, FMath::Max(CurrentWave->PrepTime, KINDA_SMALL_NUMBER), false);
+
+	OnWavePrepStarted.Broadcast(CurrentWaveIndex, CurrentWave->PrepTime);
+}
+
+void AOutpostGameModeBase::OnWaveAssetsLoaded()
+{
+	if (!IsValid(CurrentWave)) return;
+
+	bWaveAssetsLoaded = true;
+
+	//Now that the enemy classes are loaded, pre-spawn enough dormant enemies for the whole wave.
+	if (IsValid(EnemyPool))
+	{
+		TMap<TSubclassOf<AOPEnemy>, int32> CountPerClass;
+
+		for (const FWaveEnemyGroup& Index : CurrentWave->EnemyGroups)
+		{
+			if (IsValid(Index.EnemyClass.Get())) CountPerClass.FindOrAdd(Index.EnemyClass.Get()) += Index.Count;
+		}
+
+		//Most of a large wave approaches as crowd entities, so only enough real enemies for the crowd's promotion limit are needed.
+		for (const TPair<TSubclassOf<AOPEnemy>, int32>& Index : CountPerClass)
+		{
+			const bool bUsesCrowd = IsValid(Crowd) && IsValid(Index.Key.GetDefaultObject()->GetCrowdProxyMesh());
+
+			EnemyPool->PrewarmPool(Index.Key, bUsesCrowd ? FMath::Min(Index.Value, Crowd->MaxPromotedEnemies) : Index.Value);
+		}
+	}
+
+	//If the prep time already ended, then the wave was only waiting on its assets.
+	if (bStartWaveWhenLoaded) StartWave();
+}
+
+void AOutpostGameModeBase::StartWave()
+{
+	if (bIsWaveInProgress || !IsValid(CurrentWave)) return;
+
+	GetWorldTimerManager().ClearTimer(PrepHandle);
+
+	//The wave can't approach until its assets are resident, otherwise spawning would hitch.
+	if (!bWaveAssetsLoaded)
+	{
+		bStartWaveWhenLoaded = true;
+		return;
+	}
+
+	bIsWaveInProgress = true;
+	bStartWaveWhenLoaded = false;
+
+	WaveTelemetry = FWaveTelemetry();
+	WaveTelemetry.WaveIndex = CurrentWaveIndex;
+	WaveStartTime = GetWorld()->GetTimeSeconds();
+
+	//Each wave's spawn locations are random, but always the same for the same wave.
+	SpawnStream.Initialize(CurrentWaveIndex);
+
+	//Loot is rolled from its own stream, so that how many enemies have spawned never changes what they drop. It differs between areas, but is the same for the same wave.
+	const int32 AreaSeed = IsValid(Generation) && Generation->IsGenerationComplete() ? Generation->GetGeneratedLayout().Seed : GenerationSeed;
+
+	if (IsValid(Loot)) Loot->SetSeed(static_cast<int32>(HashCombine(GetTypeHash(AreaSeed), GetTypeHash(CurrentWaveIndex))));
+
+	BuildSpawnQueue();
+
+	if (IsValid(Economy)) Economy->RecordWaveStarted(CurrentWaveIndex);
+
+	//Spawning waits until the best spawn locations for this wave have been found, which only takes a frame or two.
+	if (IsValid(SpawnQuery))
+	{
+		//If nothing else has set a spawn area, then the area around the level's spawn zones is used.
+		if (!SpawnQuery->HasSpawnArea() && SpawnZoneLocations.Num() > 0) SpawnQuery->SetSpawnArea(FBox(SpawnZoneLocations).ExpandBy(CurrentWave->SpawnZoneRadius));
+
+		//The flow field needs to cover every spawn location, as well as the outpost itself.
+		if (IsValid(FlowField) && !FlowField->HasFieldArea() && SpawnQuery->HasSpawnArea() && IsValid(WorldSubsystem)) FlowField->SetFieldArea(SpawnQuery->GetSpawnArea() + WorldSubsystem->OutpostLocation);
+
+		if (SpawnQuery->HasSpawnArea())
+		{
+			bWaitingForPlacements = true;
+			SpawnQuery->RequestPlacements(CurrentWaveIndex, FMath::Clamp(SpawnQueue.Num(), 1, SpawnPlacementsPerWave), FOPSpawnPlacementsDelegate::CreateUObject(this, &AOutpostGameModeBase::OnSpawnPlacementsReady));
+		}
+	}
+
+	OnWaveStarted.Broadcast(CurrentWaveIndex);
+
+	//A wave with nothing to spawn, such as one whose enemy classes all failed to load, would otherwise never see an enemy die and never clear.
+	if (SpawnQueue.Num() <= 0) UpdateEnemiesAlive();
+}
+
+void AOutpostGameModeBase::BuildSpawnQueue()
+{
+	SpawnQueue.Reset();
+	SpawnZoneLocations.Reset();
+	NextSpawnQueueIndex = 0;
+	NextSpawnZoneIndex = 0;
+
+	//Find every spawn zone in the level that the current wave uses.
+	for (const FName& Tag : CurrentWave->SpawnZoneTags)
+	{
+		TArray<AActor*> ZoneActors;
+		UGameplayStatics::GetAllActorsWithTag(this, Tag, ZoneActors);
+
+		for (AActor* Index : ZoneActors)
+		{
+			SpawnZoneLocations.Emplace(Index->GetActorLocation());
+		}
+	}
+
+	//Generated spawn zones are used by every wave.
+	if (IsValid(Generation) && Generation->IsGenerationComplete()) SpawnZoneLocations.Append(Generation->GetGeneratedLayout().SpawnZones);
+
+	if (SpawnZoneLocations.Num() <= 0) UE_LOG(LogOutpost, Warning, TEXT("Wave %d has no spawn zones in this level. Enemies will spawn at the world origin."), CurrentWaveIndex);
+
+	//Enemy groups are interleaved, so that the wave arrives mixed rather than one group at a time.
+	TArray<int32> RemainingPerGroup;
+
+	for (const FWaveEnemyGroup& Index : CurrentWave->EnemyGroups)
+	{
+		RemainingPerGroup.Emplace(IsValid(Index.EnemyClass.Get()) ? FMath::Max(Index.Count, 0) : 0);
+	}
+
+	bool bAnyRemaining = true;
+
+	while (bAnyRemaining)
+	{
+		bAnyRemaining = false;
+
+		for (int32 i = 0; i < RemainingPerGroup.Num(); i++)
+		{
+			if (RemainingPerGroup[i] <= 0) continue;
+
+			SpawnQueue.Emplace(CurrentWave->EnemyGroups[i].EnemyClass.Get());
+			RemainingPerGroup[i]--;
+			bAnyRemaining = true;
+		}
+	}
+}
+
+void AOutpostGameModeBase::ProcessSpawnQueue()
+{
+	const double FrameStartTime = FPlatformTime::Seconds();
+	double ElapsedMs = 0.0;
+	int32 SpawnedThisFrame = 0;
+
+	while (NextSpawnQueueIndex < SpawnQueue.Num())
+	{
+		//At least one enemy spawns every frame, so that the wave always makes progress. After that, stop before the budget would be exceeded.
+		if (SpawnedThisFrame > 0 && ElapsedMs + AverageSpawnMs > SpawnBudgetMs) break;
+
+		const double SpawnStartTime = FPlatformTime::Seconds();
+
+		TSubclassOf<AOPEnemy> EnemyClass = SpawnQueue[NextSpawnQueueIndex++];
+		FTransform SpawnTransform = GetNextSpawnTransform();
+
+		//Enemies are placed so that their capsule sits on top of the spawn zone.
+		SpawnTransform.AddToTranslation(FVector(0.f, 0.f, EnemyClass.GetDefaultObject()->GetCapsuleComponent()->GetScaledCapsuleHalfHeight()));
+
+		if (IsValid(Crowd))
+		{
+			Crowd->SpawnEnemy(EnemyClass, SpawnTransform);
+		}
+		else if (IsValid(EnemyPool))
+		{
+			EnemyPool->AcquireEnemy(EnemyClass, SpawnTransform);
+		}
+		else
+		{
+			GetWorld()->SpawnActor<AOPEnemy>(EnemyClass, SpawnTransform);
+		}
+
+		const double SpawnMs = (FPlatformTime::Seconds() - SpawnStartTime) * 1000.0;
+		AverageSpawnMs = AverageSpawnMs <= 0.0 ? SpawnMs : FMath::Lerp(AverageSpawnMs, SpawnMs, 0.1);
+
+		ElapsedMs = (FPlatformTime::Seconds() - FrameStartTime) * 1000.0;
+		SpawnedThisFrame++;
+		WaveTelemetry.EnemiesSpawned++;
+	}
+
+	WaveTelemetry.SpawnFrames++;
+	WaveTelemetry.PeakSpawnFrameMs = FMath::Max(WaveTelemetry.PeakSpawnFrameMs, static_cast<float>(ElapsedMs));
+
+	//Once every enemy has been spawned, record how long the wave took to fully arrive.
+	if (NextSpawnQueueIndex >= SpawnQueue.Num())
+	{
+		WaveTelemetry.SpawnLatency = GetWorld()->GetTimeSeconds() - WaveStartTime;
+		SpawnQueue.Reset();
+		NextSpawnQueueIndex = 0;
+	}
+
+	UpdateEnemiesAlive();
+}
+
+void AOutpostGameModeBase::OnSpawnPlacementsReady(const TArray<FVector>& Placements)
+{
+	bWaitingForPlacements = false;
+
+	//If no good spawn locations could be found, then the level's spawn zones are used as they are.
+	if (Placements.Num() <= 0) return;
+
+	SpawnZoneLocations = Placements;
+	NextSpawnZoneIndex = 0;
+}
+
+FTransform AOutpostGameModeBase::GetNextSpawnTransform()
+{
+	if (SpawnZoneLocations.Num() <= 0) return FTransform::Identity;
+
+	//Spawn zones are used in turn, and each enemy is scattered randomly within the zone's radius.
+	const FVector ZoneLocation = SpawnZoneLocations[NextSpawnZoneIndex];
+	NextSpawnZoneIndex = (NextSpawnZoneIndex + 1) % SpawnZoneLocations.Num();
+
+	const float Angle = SpawnStream.FRandRange(0.f, 2.f * PI);
+	const float Distance = CurrentWave->SpawnZoneRadius * FMath::Sqrt(SpawnStream.FRand());
+
+	return FTransform(FVector(ZoneLocation.X + FMath::Cos(Angle) * Distance, ZoneLocation.Y + FMath::Sin(Angle) * Distance, ZoneLocation.Z));
+}
+
+void AOutpostGameModeBase::UpdateEnemiesAlive()
+{
+	//Crowd entities that haven't been promoted yet still count as alive.
+	if (IsValid(WorldSubsystem)) WaveTelemetry.EnemiesAlive = WorldSubsystem->EnemyArray.Num() + (IsValid(Crowd) ? Crowd->GetEntityCount() : 0);
+
+	CheckWaveCleared();
+}
+
+void AOutpostGameModeBase::CheckWaveCleared()
+{
+	//A wave is only cleared once all of its enemies have spawned, and every enemy in the level is dead.
+	if (!bIsWaveInProgress || bIsWaveHeld || SpawnQueue.Num() > 0 || WaveTelemetry.EnemiesAlive > 0) return;
+
+	bIsWaveInProgress = false;
+	LastClearedWaveIndex = CurrentWaveIndex;
+	WaveTelemetry.TimeToClear = GetWorld()->GetTimeSeconds() - WaveStartTime;
+
+	if (IsValid(Economy)) Economy->RecordWaveCleared(CurrentWaveIndex);
+
+	OnWaveCleared.Broadcast(CurrentWaveIndex, WaveTelemetry);
+
+	//Start preparing for the next wave, if there is one.
+	if (Waves.IsValidIndex(CurrentWaveIndex + 1)) StartWavePrep(CurrentWaveIndex + 1);
+
+	//The game is saved between waves. Only packing the save happens on this frame; it's compressed and written in the background.
+	if (IsValid(SaveSubsystem) && !AutosaveSlotName.IsEmpty()) SaveSubsystem->SaveGame(AutosaveSlotName);
+}
\ No newline at end of file
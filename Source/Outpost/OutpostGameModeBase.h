@@ -4,14 +4,261 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "OPStructs.h"
 #include "OutpostGameModeBase.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FWavePrepDelegate, int32, WaveIndex, float, PrepTime);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWaveDelegate, int32, WaveIndex);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FWaveClearedDelegate, int32, WaveIndex, FWaveTelemetry, Telemetry);
+
+//Forward declarations.
+class UOPWaveDefinition;
+class UOPWorldSubsystem;
+class UOPEnemyPoolSubsystem;
+class UOPSpawnQuerySubsystem;
+class UOPFlowFieldSubsystem;
+class UOPCrowdSubsystem;
+class UOPLootSubsystem;
+class UOPEconomySubsystem;
+class UOPShopCatalog;
+class UOPGenerationSettings;
+class UOPGenerationSubsystem;
+class UOPNavBuildSubsystem;
+class UOPSaveSubsystem;
+class UOPReplaySubsystem;
+class UOPSaveGame;
+struct FOPCheckpoint;
+struct FStreamableHandle;
+
 /**
- * 
+ *
  */
 UCLASS()
 class OUTPOST_API AOutpostGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
-};
+
+public:
+	// Sets default values for this game mode's properties
+	AOutpostGameModeBase();
+
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+	/* Waves */
+
+	/*
+	Starts the prep time before a wave. The assets and enemies that the wave needs are loaded and pre-spawned during this time.
+	@param	WaveIndex	The index of the wave in the Waves array that should be prepared.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OutpostGameModeBase|Waves")
+		void StartWavePrep(int32 WaveIndex);
+
+	//Ends the prep time early, and sends in the current wave.
+	UFUNCTION(BlueprintCallable, Category = "OutpostGameModeBase|Waves")
+		void StartWave();
+
+	//Returns the index of the wave that is currently being prepared or fought.
+	UFUNCTION(BlueprintPure, Category = "OutpostGameModeBase|Waves")
+		FORCEINLINE int32 GetCurrentWaveIndex() { return CurrentWaveIndex; }
+
+	//Returns "true" if a wave is currently being fought.
+	UFUNCTION(BlueprintPure, Category = "OutpostGameModeBase|Waves")
+		FORCEINLINE bool IsWaveInProgress() { return bIsWaveInProgress; }
+
+	//Returns performance and progress information about the current wave.
+	UFUNCTION(BlueprintPure, Category = "OutpostGameModeBase|Waves")
+		FORCEINLINE FWaveTelemetry GetWaveTelemetry() { return WaveTelemetry; }
+
+	/* Generation */
+
+	//Reloads the level with the same seed. The generated area is read back from the cache, so only its assets need to be streamed in again.
+	UFUNCTION(BlueprintCallable, Category = "OutpostGameModeBase|Generation")
+		void RetryArea();
+
+	/* Saving */
+
+	//Writes the area's seed and the next wave to a save game.
+	void WriteToSaveGame(UOPSaveGame* SaveGame) const;
+
+	//Writes the current wave's progress to a checkpoint: how long it has been going, and which enemies are still waiting to spawn.
+	void WriteToCheckpoint(FOPCheckpoint& Checkpoint) const;
+
+	//Returns "true" if a checkpoint was taken during the wave that is currently being prepared or fought, and that wave's assets are loaded.
+	bool CanRestoreCheckpoint(const FOPCheckpoint& Checkpoint) const;
+
+	//Puts the current wave back to how it was when a checkpoint was taken. If the wave was still being prepared, it's sent in straight away.
+	void ReadFromCheckpoint(const FOPCheckpoint& Checkpoint);
+
+	//While held, the current wave can't be cleared. Used while the level is being reset to a checkpoint, when every enemy is briefly gone.
+	void SetWaveHeld(bool bNewHeld);
+
+	/* Delegates */
+
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OutpostGameModeBase|Delegates")
+		FWavePrepDelegate OnWavePrepStarted;
+
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OutpostGameModeBase|Delegates")
+		FWaveDelegate OnWaveStarted;
+
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OutpostGameModeBase|Delegates")
+		FWaveClearedDelegate OnWaveCleared;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	/* Waves */
+
+	//Every wave of enemy reinforcements, in the order that they approach.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Waves")
+		TArray<TSoftObjectPtr<UOPWaveDefinition>> Waves;
+
+	//Determines whether the first wave's prep time starts as soon as the game does, or not.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Waves")
+		bool bStartWavesAutomatically = true;
+
+	//The most time, in milliseconds, that spawning enemies is allowed to take in a single frame.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Waves|Spawning")
+		float SpawnBudgetMs = 1.f;
+
+	//The maximum number of spawn locations that are found for each wave. Enemies are shared out between them.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Waves|Spawning")
+		int32 SpawnPlacementsPerWave = 12;
+
+	//The tag of the actor that marks where the outpost is. Spawn locations are kept a safe distance away from it.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Waves|Spawning")
+		FName OutpostTag = "Outpost";
+
+	/* Generation */
+
+	//If set, the area around the player is generated from these settings when the game starts. Waves don't start until it has finished.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Generation")
+		TObjectPtr<UOPGenerationSettings> GenerationSettings;
+
+	//The seed that the area is generated from. If 0, a random seed is picked. Can be overridden with the "Seed" URL option.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Generation")
+		int32 GenerationSeed;
+
+	/* Saving */
+
+	//The save slot that the game is written to after every wave is cleared. If empty, the game is never saved automatically.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Saving")
+		FString AutosaveSlotName = "Autosave";
+
+	/* Replays */
+
+	//The save slot that the run's input is recorded to, for replaying later. Can be set with the "Record" URL option. If empty, nothing is recorded.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Replays")
+		FString RecordSlotName;
+
+	/* Shop */
+
+	//Everything that the player can buy between waves. Only holds soft references, so nothing in it is loaded until the player hovers it.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OutpostGameModeBase|Shop")
+		TObjectPtr<UOPShopCatalog> ShopCatalog;
+
+	//The wave definition that is currently being prepared or fought.
+	UPROPERTY(BlueprintReadOnly, Category = "OutpostGameModeBase|Waves")
+		TObjectPtr<UOPWaveDefinition> CurrentWave;
+
+	UPROPERTY(BlueprintReadOnly, Category = "OutpostGameModeBase|Waves")
+		FWaveTelemetry WaveTelemetry;
+
+	UPROPERTY()
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+
+	UPROPERTY()
+		TObjectPtr<UOPEnemyPoolSubsystem> EnemyPool;
+
+	UPROPERTY()
+		TObjectPtr<UOPSpawnQuerySubsystem> SpawnQuery;
+
+	UPROPERTY()
+		TObjectPtr<UOPFlowFieldSubsystem> FlowField;
+
+	UPROPERTY()
+		TObjectPtr<UOPCrowdSubsystem> Crowd;
+
+	UPROPERTY()
+		TObjectPtr<UOPLootSubsystem> Loot;
+
+	UPROPERTY()
+		TObjectPtr<UOPEconomySubsystem> Economy;
+
+	UPROPERTY()
+		TObjectPtr<UOPGenerationSubsystem> Generation;
+
+	UPROPERTY()
+		TObjectPtr<UOPNavBuildSubsystem> NavBuild;
+
+	UPROPERTY()
+		TObjectPtr<UOPSaveSubsystem> SaveSubsystem;
+
+	UPROPERTY()
+		TObjectPtr<UOPReplaySubsystem> Replay;
+
+	UFUNCTION()
+		void UpdateEnemiesAlive();
+
+	//Generates the area if needed, and then starts the first wave. Waits for a replay to load first, if one was asked for with the "Replay" URL option.
+	void StartArea();
+
+	//Starts the area once the replay has been read, whether or not it could be.
+	UFUNCTION()
+		void OnReplayLoaded(const FString& SlotName, bool bSuccess);
+
+	//Moves the player and the outpost into the generated area, and starts rebuilding the navmesh around them.
+	UFUNCTION()
+		void OnAreaGenerated();
+
+	//Starts the first wave if needed, once the generated area's navmesh has been built.
+	UFUNCTION()
+		void OnAreaNavigationBuilt();
+
+	//Restores the loaded save game if there is one, and then starts preparing for the first wave if needed.
+	void StartFirstWave();
+
+	//Called once the loaded save game's weapon classes are in memory.
+	void OnSaveAssetsLoaded();
+
+	void OnWaveDefinitionLoaded();
+	void OnWaveAssetsLoaded();
+	void BuildSpawnQueue();
+	void ProcessSpawnQueue();
+	void OnSpawnPlacementsReady(const TArray<FVector>& Placements);
+	void CheckWaveCleared();
+	FTransform GetNextSpawnTransform();
+
+	//The enemy classes that are still waiting to be spawned for the current wave, in spawn order.
+	TArray<TSubclassOf<AOPEnemy>> SpawnQueue;
+
+	//The locations of every spawn zone that the current wave is using.
+	TArray<FVector> SpawnZoneLocations;
+
+	TSharedPtr<FStreamableHandle> WaveAssetsHandle;
+
+	//Keeps the loaded save game's weapon classes in memory until they've been given to the player.
+	TSharedPtr<FStreamableHandle> SaveAssetsHandle;
+
+	FTimerHandle PrepHandle;
+
+	FRandomStream SpawnStream;
+
+	int32 CurrentWaveIndex = INDEX_NONE;
+	int32 LastClearedWaveIndex = INDEX_NONE;
+	int32 NextSpawnQueueIndex;
+	int32 NextSpawnZoneIndex;
+
+	//A running average of how long a single enemy takes to spawn, used for staying within the spawn budget.
+	double AverageSpawnMs;
+
+	float WaveStartTime;
+
+	bool bIsWaveInProgress;
+	bool bWaveAssetsLoaded;
+	bool bStartWaveWhenLoaded;
+	bool bWaitingForPlacements;
+	bool bIsWaveHeld;
+	bool bSaveAssetsRequested;
+};
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Characters/OPCharacterBase.h"
 #include "Components/CapsuleComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "OPProfiling.h"
 
 // Sets default values
 AOPCharacterBase::AOPCharacterBase(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -61,6 +62,8 @@ void AOPCharacterBase::CharacterDeath()
 
 void AOPCharacterBase::ProcessMeleeHitOnTargets_Implementation()
 {
+	OP_PROFILE_SCOPE(MeleeHit);
+
 	for (FHitResult Index : MeleeHitResults)
 	{
 		if (IsValid(Index.GetActor()))
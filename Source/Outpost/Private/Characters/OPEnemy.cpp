@@ -3,6 +3,13 @@
 #include "Characters/OPEnemy.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "UASAimAssistTargetComponent.h"
+#include "Subsystems/OPCorpseSubsystem.h"
+#include "Subsystems/OPEnemyPoolSubsystem.h"
+#include "Subsystems/OPLootSubsystem.h"
+#include "Subsystems/OPEconomySubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "OPProfiling.h"
 
 // Sets default values
 AOPEnemy::AOPEnemy(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -11,6 +18,9 @@ AOPEnemy::AOPEnemy(const FObjectInitializer& ObjectInitializer) : Super(ObjectIn
 	PrimaryActorTick.bCanEverTick = true;
 
 	AimAssistTargetComponent = CreateDefaultSubobject<UUASAimAssistTargetComponent>("Aim Assist Target Component");
+
+	//Enemies taken out of the enemy pool need an AI controller, just like the ones placed in the level.
+	AutoPossessAI = EAutoPossessAI::PlacedInWorldOrSpawned;
 }
 
 // Called when the game starts or when spawned
@@ -18,14 +28,37 @@ void AOPEnemy::BeginPlay()
 {
 	Super::BeginPlay();
 
-	//Add the enemy to the global enemy array, as soon as they spawn.
-	if (IsValid(WorldSubsystem)) WorldSubsystem->EnemyArray.Emplace(this);
+	//Remember how the enemy's mesh and capsule were set up, so that pooled enemies can be restored after ragdolling.
+	DefaultMeshRelativeTransform = GetMesh()->GetRelativeTransform();
+	DefaultMeshCollisionProfile = GetMesh()->GetCollisionProfileName();
+	DefaultCapsuleCollisionProfile = GetCapsuleComponent()->GetCollisionProfileName();
 
 	//Bind a callback function to OnTakePointDamage delegate.
 	OnTakePointDamage.AddDynamic(this, &AOPEnemy::TakePointDamage);
 
 	//Initialize the enemy as an aim assist target.
 	AimAssistTargetComponent->Init(GetMesh());
+
+	//Enemies pre-spawned by the enemy pool are parked right away...
+	if (bSpawnDormant)
+	{
+		DeactivateForPool(GetActorLocation());
+	}
+	//...Otherwise, add the enemy to the global enemy array, as soon as they spawn.
+	else if (IsValid(WorldSubsystem))
+	{
+		WorldSubsystem->RegisterEnemy(this);
+	}
+}
+
+void AOPEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//Enemies that are destroyed while they are still ragdolling stop counting as ragdolls.
+	if (GetWorldTimerManager().IsTimerActive(SettleHandle)) OP_ADJUST_RAGDOLLS(-1);
+
+	GetWorldTimerManager().ClearTimer(SettleHandle);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
@@ -39,33 +72,66 @@ void AOPEnemy::CharacterDeath()
 {
 	if (bIsCharacterDead) return;
 
+	OP_PROFILE_SCOPE(CharacterDeath);
+
 	Super::CharacterDeath();
 
 	//Remove the enemy from the global enemy array once they die, and update enemy information.
-	if (IsValid(WorldSubsystem))
-	{
-		WorldSubsystem->EnemyArray.Remove(this);
-		WorldSubsystem->OnEnemyUpdate.Broadcast();
-	}
+	if (IsValid(WorldSubsystem)) WorldSubsystem->UnregisterEnemy(this);
+
+	//Roll the enemy's loot table. The drops themselves are placed over the next few frames.
+	TObjectPtr<UOPLootSubsystem> LootSubsystem = GetWorld()->GetSubsystem<UOPLootSubsystem>();
+
+	if (IsValid(LootSubsystem)) LootSubsystem->DropLoot(LootTable, GetActorLocation(), IsValid(CurrentWeapon) ? CurrentWeapon->GetClass() : nullptr);
 
 	//The enemy goes into a ragdoll state.
 	GetMesh()->SetSimulatePhysics(true);
 	GetMesh()->SetCollisionProfileName("Ragdoll");
+	OP_ADJUST_RAGDOLLS(1);
+
+	//Check the enemy's body on a looping timer, until it has come to rest.
+	TimeSpentRagdolling = 0.f;
+	GetWorldTimerManager().SetTimer(SettleHandle, this, &AOPEnemy::CheckRagdollSettled, SettleCheckInterval, true);
+}
+
+void AOPEnemy::CheckRagdollSettled()
+{
+	TimeSpentRagdolling += SettleCheckInterval;
+
+	//Keep waiting, if the enemy's body is still moving.
+	if (GetMesh()->GetPhysicsLinearVelocity().Size() > SettleSpeedThreshold && TimeSpentRagdolling < MaxSettleTime) return;
+
+	GetWorldTimerManager().ClearTimer(SettleHandle);
+	OP_ADJUST_RAGDOLLS(-1);
 
-	//Set a timer for when the enemy's body will be cleared from the level.
-	GetWorldTimerManager().SetTimer(ClearHandle, this, &AOPEnemy::ClearEnemy, ClearTimer);
+	//Once the body is at rest, its pose gets baked into a corpse and the enemy can be cleared right away...
+	TObjectPtr<UOPCorpseSubsystem> CorpseSubsystem = GetWorld()->GetSubsystem<UOPCorpseSubsystem>();
+
+	if (IsValid(CorpseSubsystem) && CorpseSubsystem->BakeCorpse(GetMesh()))
+	{
+		ClearEnemy();
+	}
+	//...Otherwise, set a timer for when the enemy's body will be cleared from the level.
+	else
+	{
+		GetWorldTimerManager().SetTimer(ClearHandle, this, &AOPEnemy::ClearEnemy, ClearTimer);
+	}
 }
 
 void AOPEnemy::TakePointDamage(AActor* DamagedActor, float Damage, AController* InstigatedBy, FVector HitLocation, UPrimitiveComponent* FHitComponent, FName BoneName, FVector ShotFromDirection, const UDamageType* DamageType, AActor* DamageCauser)
 {
+	OP_PROFILE_SCOPE(TakePointDamage);
+
 	int32 FinalDamage;
 	
 	//Damage dealt to the enemy will be determined by the type of physical material that was hit. 
-	if (LastHitMaterial == DamageMaterials.HeadMaterial)
+	const EHitZone HitZone = GetHitZone();
+
+	if (HitZone == EHitZone::Head)
 	{
 		FinalDamage = Damage * 2;
 	}
-	else if (LastHitMaterial == DamageMaterials.LimbMaterial)
+	else if (HitZone == EHitZone::Limb)
 	{
 		FinalDamage = Damage * 0.8;
 	}
@@ -80,14 +146,116 @@ void AOPEnemy::TakePointDamage(AActor* DamagedActor, float Damage, AController*
 	//If the character has run out of health, then they die.
 	if (CurrentHealth <= 0)
 	{
+		//Only the player's killing blow is rewarded.
+		if (!bIsCharacterDead && IsValid(InstigatedBy) && InstigatedBy->IsPlayerController())
+		{
+			TObjectPtr<UOPEconomySubsystem> Economy = GetWorld()->GetSubsystem<UOPEconomySubsystem>();
+
+			if (IsValid(Economy)) Economy->RecordKill(DamageCauser, HitZone);
+		}
+
 		CharacterDeath();
 	}
 }
 
+EHitZone AOPEnemy::GetHitZone() const
+{
+	if (LastHitMaterial == DamageMaterials.HeadMaterial) return EHitZone::Head;
+	if (LastHitMaterial == DamageMaterials.LimbMaterial) return EHitZone::Limb;
+
+	return EHitZone::Body;
+}
+
 void AOPEnemy::ClearEnemy()
 {
-	//The enemy's body is cleared from the level, after a specified amount of time.
-	Destroy();
+	//The enemy's body is cleared from the level, and the enemy is returned to the pool so that a later wave can reuse it.
+	TObjectPtr<UOPEnemyPoolSubsystem> EnemyPool = GetWorld()->GetSubsystem<UOPEnemyPoolSubsystem>();
+
+	if (IsValid(EnemyPool))
+	{
+		EnemyPool->ReleaseEnemy(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void AOPEnemy::ActivateFromPool(const FTransform& SpawnTransform)
+{
+	ResetEnemyState();
+
+	SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+
+	//Bring the enemy back into play.
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	GetMesh()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetComponentTickEnabled(true);
+	GetCharacterMovement()->SetDefaultMovementMode();
+	AimAssistTargetComponent->SetActive(true);
+
+	if (IsValid(GetController())) GetController()->SetActorTickEnabled(true);
+
+	bIsDormant = false;
+
+	if (IsValid(WorldSubsystem)) WorldSubsystem->RegisterEnemy(this);
+}
+
+void AOPEnemy::DeactivateForPool(const FVector& ParkingLocation)
+{
+	//Enemies that are returned to the pool alive still need to leave the global enemy array.
+	if (IsValid(WorldSubsystem)) WorldSubsystem->UnregisterEnemy(this);
+
+	//Enemies that are pulled out of play while they are still ragdolling stop counting as ragdolls.
+	if (GetWorldTimerManager().IsTimerActive(SettleHandle)) OP_ADJUST_RAGDOLLS(-1);
+
+	GetWorldTimerManager().ClearTimer(ClearHandle);
+	GetWorldTimerManager().ClearTimer(SettleHandle);
+
+	//Stop the ragdoll before moving the enemy, so that its bodies don't get dragged along.
+	GetMesh()->SetSimulatePhysics(false);
+
+	//Dormant enemies don't tick, collide, move, or render.
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	GetMesh()->SetComponentTickEnabled(false);
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+	GetCharacterMovement()->SetComponentTickEnabled(false);
+	AimAssistTargetComponent->SetActive(false);
+
+	SetActorLocation(ParkingLocation, false, nullptr, ETeleportType::ResetPhysics);
+
+	//Enemies that died lost their controller, so they get a new one now instead of when the next wave starts.
+	if (!IsValid(GetController())) SpawnDefaultController();
+	if (IsValid(GetController())) GetController()->SetActorTickEnabled(false);
+
+	bIsDormant = true;
+}
+
+void AOPEnemy::ResetEnemyState()
+{
+	bIsCharacterDead = false;
+	LastHitMaterial = nullptr;
+	TimeSpentRagdolling = 0.f;
+
+	SetCurrentHealth(MaxHealth);
+
+	//Undo everything that happened to the enemy's mesh and capsule when they went into a ragdoll state.
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetCollisionProfileName(DefaultMeshCollisionProfile);
+	GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::KeepRelativeTransform);
+	GetMesh()->SetRelativeTransform(DefaultMeshRelativeTransform);
+	GetCapsuleComponent()->SetCollisionProfileName(DefaultCapsuleCollisionProfile);
+	GetCapsuleComponent()->SetEnableGravity(true);
+
+	for (TObjectPtr<AOPWeapon> Index : WeaponArray)
+	{
+		if (IsValid(Index)) Index->ResetWeaponState();
+	}
 }
 
 void AOPEnemy::UpdateLastHitMaterial_Implementation(UPhysicalMaterial* MaterialHit)
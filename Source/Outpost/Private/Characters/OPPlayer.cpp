@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Characters/OPPlayer.h"
+#include "Outpost.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
 #include "InputMappingContext.h"
@@ -9,6 +10,10 @@
 #include "Kismet/KismetSystemLibrary.h"
 #include "Interfaces/OPInteractInterface.h"
 #include "Kismet/GameplayStatics.h"
+#include "Subsystems/OPLootSubsystem.h"
+#include "Subsystems/OPEconomySubsystem.h"
+#include "Data/OPSaveGame.h"
+#include "OPProfiling.h"
 
 // Sets default values
 AOPPlayer::AOPPlayer(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
@@ -172,6 +177,113 @@ void AOPPlayer::PawnClientRestart()
 	}
 }
 
+void AOPPlayer::WriteToSaveGame(UOPSaveGame* SaveGame) const
+{
+	if (!IsValid(SaveGame)) return;
+
+	SaveGame->CurrentHealth = CurrentHealth;
+
+	SaveGame->ReserveAmmo.Emplace(EWeaponType::Pistol, PistolAmmo);
+	SaveGame->ReserveAmmo.Emplace(EWeaponType::Rifle, RifleAmmo);
+	SaveGame->ReserveAmmo.Emplace(EWeaponType::Shotgun, ShotgunAmmo);
+	SaveGame->ReserveAmmo.Emplace(EWeaponType::Sniper, SniperAmmo);
+
+	SaveGame->Weapons.Reset();
+	SaveGame->CurrentWeaponIndex = INDEX_NONE;
+
+	//The first weapon is always the dummy "weapon", so it's never saved.
+	for (int32 i = 1; i < WeaponArray.Num(); i++)
+	{
+		TObjectPtr<AOPWeapon> Weapon = WeaponArray[i];
+
+		if (!IsValid(Weapon)) continue;
+
+		if (Weapon == CurrentWeapon) SaveGame->CurrentWeaponIndex = SaveGame->Weapons.Num();
+
+		FSavedWeapon& SavedWeapon = SaveGame->Weapons.AddDefaulted_GetRef();
+		SavedWeapon.WeaponClass = Weapon->GetClass();
+		SavedWeapon.CurrentMagazine = Weapon->Stats.CurrentMagazine;
+		SavedWeapon.CurrentFireMode = Weapon->Stats.CurrentFireMode;
+	}
+}
+
+void AOPPlayer::ReadFromSaveGame(const UOPSaveGame* SaveGame, const TArray<TSubclassOf<AOPWeapon>>& WeaponClasses)
+{
+	if (!IsValid(SaveGame)) return;
+
+	if (SaveGame->CurrentHealth > 0) SetCurrentHealth(SaveGame->CurrentHealth);
+
+	PistolAmmo = FMath::Clamp(SaveGame->ReserveAmmo.FindRef(EWeaponType::Pistol), 0, MaxReserveAmmo);
+	RifleAmmo = FMath::Clamp(SaveGame->ReserveAmmo.FindRef(EWeaponType::Rifle), 0, MaxReserveAmmo);
+	ShotgunAmmo = FMath::Clamp(SaveGame->ReserveAmmo.FindRef(EWeaponType::Shotgun), 0, MaxReserveAmmo);
+	SniperAmmo = FMath::Clamp(SaveGame->ReserveAmmo.FindRef(EWeaponType::Sniper), 0, MaxReserveAmmo);
+
+	//Without a class for every saved weapon, the player keeps the weapons they're carrying rather than losing the ones that are missing.
+	if (WeaponClasses.Num() != SaveGame->Weapons.Num())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Expected %d weapon classes for the player's saved weapons, but got %d. Their weapons were not restored."), SaveGame->Weapons.Num(), WeaponClasses.Num());
+		return;
+	}
+
+	//Any weapon that was picked up after the save game was written is taken away again. The first weapon is always the dummy "weapon", so it's kept.
+	for (int32 i = WeaponArray.Num() - 1; i >= 1; i--)
+	{
+		TObjectPtr<AOPWeapon> Weapon = WeaponArray[i];
+
+		if (IsValid(Weapon) && WeaponClasses.Contains(Weapon->GetClass())) continue;
+
+		WeaponArray.RemoveAt(i);
+
+		if (Weapon == CurrentWeapon) CurrentWeapon = WeaponArray[0];
+
+		if (IsValid(Weapon)) Weapon->Destroy();
+	}
+
+	TObjectPtr<AOPWeapon> EquippedWeapon;
+
+	for (int32 i = 0; i < SaveGame->Weapons.Num(); i++)
+	{
+		const FSavedWeapon& SavedWeapon = SaveGame->Weapons[i];
+		TSubclassOf<AOPWeapon> WeaponClass = WeaponClasses[i];
+
+		if (!IsValid(WeaponClass)) continue;
+
+		//The player may already be carrying the weapon, such as their starting weapon.
+		TObjectPtr<AOPWeapon> Weapon;
+
+		for (int32 j = 1; j < WeaponArray.Num(); j++)
+		{
+			if (IsValid(WeaponArray[j]) && WeaponArray[j]->GetClass() == WeaponClass)
+			{
+				Weapon = WeaponArray[j];
+				break;
+			}
+		}
+
+		if (!IsValid(Weapon))
+		{
+			Weapon = GetWorld()->SpawnActor<AOPWeapon>(WeaponClass);
+
+			if (!IsValid(Weapon)) continue;
+
+			PickUpWeapon_Implementation(Weapon);
+		}
+
+		Weapon->Stats.CurrentMagazine = FMath::Clamp(SavedWeapon.CurrentMagazine, 0, Weapon->Stats.MaxMagazine);
+		Weapon->Stats.CurrentFireMode = SavedWeapon.CurrentFireMode;
+
+		if (i == SaveGame->CurrentWeaponIndex) EquippedWeapon = Weapon;
+	}
+
+	//If the weapon the player had equipped was taken away, then they fall back to whichever weapon they're still carrying.
+	if (!IsValid(EquippedWeapon) && CurrentWeapon == WeaponArray[0] && WeaponArray.Num() > 1) EquippedWeapon = WeaponArray[1];
+
+	if (IsValid(EquippedWeapon)) HideAllUnequippedWeapons(EquippedWeapon);
+
+	//Update the weapon info in the player's HUD.
+	OnWeaponUpdate.Broadcast();
+}
+
 void AOPPlayer::MoveForward(const FInputActionValue& Value)
 {
 	if (Value.GetMagnitude() != 0.f) AddMovementInput(GetActorForwardVector(), Value[1]);
@@ -807,6 +919,8 @@ void AOPPlayer::Interact()
 
 void AOPPlayer::InteractLineTrace()
 {
+	OP_PROFILE_SCOPE(InteractTrace);
+
 	if (IsValid(GetController()))
 	{
 		//Store the player camera's location and rotation in a pair of out parameters.
@@ -815,6 +929,8 @@ void AOPPlayer::InteractLineTrace()
 		//The player's interact radius determines where the line trace will end.
 		FVector EndLocation = CameraLocation + CameraRotation.Vector() * InteractRadius;
 
+		OP_COUNT_TRACE();
+
 		//Interact line traces should always ignore the player themselves.
 		TArray<TObjectPtr<AActor>> ActorsToIgnore;
 		ActorsToIgnore.Emplace(this);
@@ -835,6 +951,8 @@ void AOPPlayer::InteractLineTrace()
 
 void AOPPlayer::CheckForInteractableObjects()
 {
+	OP_PROFILE_SCOPE(CheckInteractables);
+
 	TObjectPtr<AActor> HitActor = InteractHitResult.GetActor();
 
 	if (IsValid(HitActor))
@@ -900,7 +1018,11 @@ void AOPPlayer::CharacterDeath()
 
 	Super::CharacterDeath();
 
-	//LOGIC FOR MAKING THE PLAYER DROP THEIR CURRENT WEAPON GOES HERE
+	//The player drops a copy of their current weapon.
+	TObjectPtr<UOPLootSubsystem> LootSubsystem = GetWorld()->GetSubsystem<UOPLootSubsystem>();
+
+	if (IsValid(LootSubsystem) && IsValid(CurrentWeapon)) LootSubsystem->DropWeapon(CurrentWeapon->GetClass(), GetActorLocation());
+
 	//LOGIC FOR STARTING THE "GAME OVER" SEQUENCE GOES HERE
 }
 
@@ -934,6 +1056,11 @@ void AOPPlayer::TakePointDamage(AActor* DamagedActor, float Damage, AController*
 	//The character cannot have a health value below 0.
 	CurrentHealth = FMath::Clamp((CurrentHealth - Damage), 0, MaxHealth);
 
+	//Taking damage forfeits the current wave's no-damage bonus.
+	TObjectPtr<UOPEconomySubsystem> Economy = GetWorld()->GetSubsystem<UOPEconomySubsystem>();
+
+	if (IsValid(Economy)) Economy->RecordDamageTaken(Damage);
+
 	//If the character has run out of health, then they die.
 	if (CurrentHealth <= 0)
 	{
@@ -943,6 +1070,9 @@ void AOPPlayer::TakePointDamage(AActor* DamagedActor, float Damage, AController*
 
 void AOPPlayer::MeleeSphereTrace_Implementation(FVector MeleeStart, FVector MeleeEnd, float Radius)
 {
+	OP_PROFILE_SCOPE(MeleeTrace);
+	OP_COUNT_TRACE();
+
 	//The player should never be hit by their own melee attack.
 	TArray<TObjectPtr<AActor>> ActorsToIgnore;
 	ActorsToIgnore.Emplace(this);
@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Data/OPCheckpoint.h"
+#include "Data/OPSaveGame.h"
+
+void FOPCheckpoint::Serialize(FArchive& Ar, EOPCheckpointVersion Version)
+{
+	//Assets are stored by path, so that checkpoints don't depend on the order that classes happen to be loaded in.
+	int32 AssetCount = AssetPaths.Num();
+	Ar << AssetCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, AssetCount, sizeof(int32))) return;
+
+	if (Ar.IsLoading())
+	{
+		AssetPaths.SetNum(AssetCount);
+		AssetIndices.Reset();
+		LoadedAssets.Reset();
+	}
+
+	for (FSoftObjectPath& Index : AssetPaths)
+	{
+		FString AssetPath = Index.ToString();
+		Ar << AssetPath;
+
+		if (Ar.IsLoading()) Index = FSoftObjectPath(AssetPath);
+	}
+
+	/* Wave */
+
+	Ar << WaveIndex << WaveTime << SpawnSeed << NextSpawnZoneIndex;
+	Ar << WaveTelemetry.EnemiesSpawned << WaveTelemetry.EnemiesAlive << WaveTelemetry.SpawnLatency << WaveTelemetry.PeakSpawnFrameMs << WaveTelemetry.SpawnFrames;
+
+	if (Ar.IsLoading()) WaveTelemetry.WaveIndex = WaveIndex;
+
+	int32 SpawnZoneCount = SpawnZoneLocations.Num();
+	Ar << SpawnZoneCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, SpawnZoneCount, sizeof(FVector))) return;
+
+	UOPSaveGame::SerializeColumn(Ar, SpawnZoneLocations, SpawnZoneCount);
+
+	int32 SpawnQueueCount = SpawnQueue.Num();
+	Ar << SpawnQueueCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, SpawnQueueCount, sizeof(int32))) return;
+
+	UOPSaveGame::SerializeColumn(Ar, SpawnQueue, SpawnQueueCount);
+
+	/* Player */
+
+	Ar << PlayerLocation << PlayerRotation << PlayerSaveVersion;
+
+	int32 PlayerSaveSize = PlayerSave.Num();
+	Ar << PlayerSaveSize;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, PlayerSaveSize, sizeof(uint8))) return;
+
+	if (Ar.IsLoading()) PlayerSave.SetNumUninitialized(PlayerSaveSize);
+
+	Ar.Serialize(PlayerSave.GetData(), PlayerSaveSize);
+
+	/* Enemies */
+
+	int32 EnemyCount = EnemyClasses.Num();
+	Ar << EnemyCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, EnemyCount, sizeof(int32) * 3 + sizeof(float) * 2 + sizeof(FVector) * 3)) return;
+
+	UOPSaveGame::SerializeColumn(Ar, EnemyClasses, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyLocations, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyYaws, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyVelocities, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyHealth, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyMagazines, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyLastKnownPlayerLocations, EnemyCount);
+	UOPSaveGame::SerializeColumn(Ar, EnemyTimesSinceSeen, EnemyCount);
+
+	/* Crowd entities */
+
+	int32 CrowdCount = CrowdClasses.Num();
+	Ar << CrowdCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, CrowdCount, sizeof(int32) * 2 + sizeof(FVector) * 2)) return;
+
+	UOPSaveGame::SerializeColumn(Ar, CrowdClasses, CrowdCount);
+	UOPSaveGame::SerializeColumn(Ar, CrowdLocations, CrowdCount);
+	UOPSaveGame::SerializeColumn(Ar, CrowdDirections, CrowdCount);
+	UOPSaveGame::SerializeColumn(Ar, CrowdHealth, CrowdCount);
+
+	/* Loot */
+
+	int32 LootCount = LootLocations.Num();
+	Ar << LootCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, LootCount, sizeof(int32) * 3 + sizeof(uint8) + sizeof(FVector))) return;
+
+	UOPSaveGame::SerializeColumn(Ar, LootLocations, LootCount);
+	UOPSaveGame::SerializeColumn(Ar, LootWeaponClasses, LootCount);
+	UOPSaveGame::SerializeColumn(Ar, LootAmounts, LootCount);
+	UOPSaveGame::SerializeColumn(Ar, LootMeshes, LootCount);
+
+	if (Ar.IsLoading()) LootAmmoTypes.SetNumUninitialized(LootCount);
+
+	for (EWeaponType& Index : LootAmmoTypes)
+	{
+		uint8 AmmoType = static_cast<uint8>(Index);
+		Ar << AmmoType;
+
+		if (Ar.IsLoading()) Index = static_cast<EWeaponType>(AmmoType);
+	}
+
+	if (Version < EOPCheckpointVersion::LootSeed) return;
+
+	Ar << LootSeed;
+}
+
+void FOPCheckpoint::Reset()
+{
+	AssetPaths.Reset();
+	AssetIndices.Reset();
+	LoadedAssets.Reset();
+
+	WaveIndex = INDEX_NONE;
+	WaveTime = 0.f;
+	WaveTelemetry = FWaveTelemetry();
+	SpawnSeed = 0;
+	SpawnZoneLocations.Reset();
+	NextSpawnZoneIndex = 0;
+	SpawnQueue.Reset();
+
+	PlayerLocation = FVector::ZeroVector;
+	PlayerRotation = FRotator::ZeroRotator;
+	PlayerSave.Reset();
+	PlayerSaveVersion = 0;
+
+	EnemyClasses.Reset();
+	EnemyLocations.Reset();
+	EnemyYaws.Reset();
+	EnemyVelocities.Reset();
+	EnemyHealth.Reset();
+	EnemyMagazines.Reset();
+	EnemyLastKnownPlayerLocations.Reset();
+	EnemyTimesSinceSeen.Reset();
+
+	CrowdClasses.Reset();
+	CrowdLocations.Reset();
+	CrowdDirections.Reset();
+	CrowdHealth.Reset();
+
+	LootLocations.Reset();
+	LootWeaponClasses.Reset();
+	LootAmmoTypes.Reset();
+	LootAmounts.Reset();
+	LootMeshes.Reset();
+	LootSeed = 0;
+}
+
+int32 FOPCheckpoint::FindOrAddAsset(const UObject* Asset)
+{
+	if (!IsValid(Asset)) return INDEX_NONE;
+
+	const TObjectKey<UObject> AssetKey(Asset);
+	const int32* AssetIndex = AssetIndices.Find(AssetKey);
+
+	if (AssetIndex) return *AssetIndex;
+
+	const int32 NewIndex = AssetPaths.Emplace(Asset);
+	AssetIndices.Emplace(AssetKey, NewIndex);
+
+	return NewIndex;
+}
+
+int32 FOPCheckpoint::FindAsset(const FSoftObjectPath& AssetPath) const
+{
+	return AssetPath.IsNull() ? INDEX_NONE : AssetPaths.Find(AssetPath);
+}
+
+UObject* FOPCheckpoint::LoadAsset(int32 AssetIndex) const
+{
+	if (!AssetPaths.IsValidIndex(AssetIndex)) return nullptr;
+
+	if (LoadedAssets.Num() != AssetPaths.Num()) LoadedAssets.SetNum(AssetPaths.Num());
+
+	//Checkpoints are restored while their wave's assets are loaded, so this almost never has to load anything.
+	if (!LoadedAssets[AssetIndex].IsValid()) LoadedAssets[AssetIndex] = AssetPaths[AssetIndex].TryLoad();
+
+	return LoadedAssets[AssetIndex].Get();
+}
\ No newline at end of file
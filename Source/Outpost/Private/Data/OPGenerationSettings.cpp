@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Data/OPGenerationSettings.h"
+
+const TArray<FGenerationRule>& UOPGenerationSettings::GetStageRules(EGenerationStage Stage) const
+{
+	switch (Stage)
+	{
+	case EGenerationStage::Terrain:
+		return TerrainFeatures;
+	case EGenerationStage::Cover:
+		return Cover;
+	case EGenerationStage::Foliage:
+		return Foliage;
+	case EGenerationStage::Loot:
+		return Loot;
+	default:
+		return OutpostLayout;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Data/OPReplay.h"
+#include "Data/OPSaveGame.h"
+#include "InputAction.h"
+
+void FOPReplay::Serialize(FArchive& Ar, EOPReplayVersion Version)
+{
+	Ar << Seed << RandomSeed;
+
+	/* Frames */
+
+	int32 FrameCount = FrameDeltaTimes.Num();
+	Ar << FrameCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, FrameCount, sizeof(float))) return;
+
+	UOPSaveGame::SerializeColumn(Ar, FrameDeltaTimes, FrameCount);
+
+	/* Actions */
+
+	//Actions are stored by path, so that replays don't depend on the order that the player's bindings happen to be set up in.
+	int32 ActionCount = ActionPaths.Num();
+	Ar << ActionCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, ActionCount, sizeof(int32) + sizeof(uint8))) return;
+
+	//Events store their action in a single byte.
+	if (ActionCount > MAX_uint8 + 1)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	if (Ar.IsLoading())
+	{
+		ActionPaths.SetNum(ActionCount);
+		ActionValueTypes.SetNum(ActionCount);
+		ActionIndices.Reset();
+		LoadedActions.Reset();
+	}
+
+	for (int32 i = 0; i < ActionCount; i++)
+	{
+		FString ActionPath = ActionPaths[i].ToString();
+		uint8 ValueType = static_cast<uint8>(ActionValueTypes[i]);
+
+		Ar << ActionPath << ValueType;
+
+		if (Ar.IsLoading())
+		{
+			ActionPaths[i] = FSoftObjectPath(ActionPath);
+			ActionValueTypes[i] = static_cast<EInputActionValueType>(ValueType);
+		}
+	}
+
+	/* Events */
+
+	int32 EventCount = EventFrames.Num();
+	Ar << EventCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, EventCount, sizeof(int32) + sizeof(uint8) * 2)) return;
+
+	UOPSaveGame::SerializeColumn(Ar, EventFrames, EventCount);
+	UOPSaveGame::SerializeColumn(Ar, EventActions, EventCount);
+
+	if (Ar.IsLoading()) EventTriggers.SetNumUninitialized(EventCount);
+
+	for (ETriggerEvent& Index : EventTriggers)
+	{
+		uint8 TriggerEvent = static_cast<uint8>(Index);
+		Ar << TriggerEvent;
+
+		if (Ar.IsLoading()) Index = static_cast<ETriggerEvent>(TriggerEvent);
+	}
+
+	int32 ValueCount = EventValues.Num();
+	Ar << ValueCount;
+
+	if (!UOPSaveGame::HasRoomFor(Ar, ValueCount, sizeof(float))) return;
+
+	UOPSaveGame::SerializeColumn(Ar, EventValues, ValueCount);
+
+	if (!Ar.IsLoading()) return;
+
+	//The offsets are rebuilt from each event's action. Events that refer to an action that doesn't exist, or that run past the end of the values, mean the replay is corrupted.
+	EventValueOffsets.SetNumUninitialized(EventCount);
+
+	int32 ValueOffset = 0;
+
+	for (int32 i = 0; i < EventCount; i++)
+	{
+		if (!ActionValueTypes.IsValidIndex(EventActions[i]))
+		{
+			Ar.SetError();
+			return;
+		}
+
+		EventValueOffsets[i] = ValueOffset;
+		ValueOffset += GetValueCount(ActionValueTypes[EventActions[i]]);
+	}
+
+	if (ValueOffset != ValueCount) Ar.SetError();
+}
+
+void FOPReplay::Reset()
+{
+	Seed = 0;
+	RandomSeed = 0;
+
+	FrameDeltaTimes.Reset();
+	ActionPaths.Reset();
+	ActionValueTypes.Reset();
+	EventFrames.Reset();
+	EventActions.Reset();
+	EventTriggers.Reset();
+	EventValues.Reset();
+
+	ActionIndices.Reset();
+	EventValueOffsets.Reset();
+	LoadedActions.Reset();
+}
+
+int32 FOPReplay::FindOrAddAction(const UInputAction* Action)
+{
+	if (!IsValid(Action)) return INDEX_NONE;
+
+	if (const int32* Existing = ActionIndices.Find(Action)) return *Existing;
+
+	//Events store their action in a single byte.
+	if (ActionPaths.Num() > MAX_uint8) return INDEX_NONE;
+
+	const int32 NewIndex = ActionPaths.Emplace(Action);
+	ActionValueTypes.Emplace(Action->ValueType);
+	ActionIndices.Emplace(Action, NewIndex);
+
+	return NewIndex;
+}
+
+const UInputAction* FOPReplay::LoadAction(int32 ActionIndex) const
+{
+	if (!ActionPaths.IsValidIndex(ActionIndex)) return nullptr;
+
+	if (LoadedActions.Num() != ActionPaths.Num()) LoadedActions.SetNum(ActionPaths.Num());
+
+	if (!LoadedActions[ActionIndex].IsValid()) LoadedActions[ActionIndex] = Cast<UInputAction>(ActionPaths[ActionIndex].TryLoad());
+
+	return LoadedActions[ActionIndex].Get();
+}
+
+void FOPReplay::AddEvent(int32 Frame, int32 ActionIndex, ETriggerEvent TriggerEvent, const FInputActionValue& Value)
+{
+	if (!ActionValueTypes.IsValidIndex(ActionIndex)) return;
+
+	EventFrames.Emplace(Frame);
+	EventActions.Emplace(static_cast<uint8>(ActionIndex));
+	EventTriggers.Emplace(TriggerEvent);
+	EventValueOffsets.Emplace(EventValues.Num());
+
+	const FVector Axis = Value.Get<FVector>();
+	const int32 ValueCount = GetValueCount(ActionValueTypes[ActionIndex]);
+
+	for (int32 i = 0; i < ValueCount; i++)
+	{
+		EventValues.Emplace(Axis[i]);
+	}
+}
+
+FInputActionValue FOPReplay::GetEventValue(int32 EventIndex) const
+{
+	if (!EventValueOffsets.IsValidIndex(EventIndex)) return FInputActionValue();
+
+	const EInputActionValueType ValueType = ActionValueTypes[EventActions[EventIndex]];
+	const int32 ValueOffset = EventValueOffsets[EventIndex];
+
+	FVector Axis = FVector::ZeroVector;
+
+	for (int32 i = 0; i < GetValueCount(ValueType); i++)
+	{
+		Axis[i] = EventValues[ValueOffset + i];
+	}
+
+	return FInputActionValue(ValueType, Axis);
+}
+
+int32 FOPReplay::GetValueCount(EInputActionValueType ValueType)
+{
+	switch (ValueType)
+	{
+	case EInputActionValueType::Axis2D:
+		return 2;
+	case EInputActionValueType::Axis3D:
+		return 3;
+	default:
+		return 1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Data/OPSaveGame.h"
+
+bool UOPSaveGame::HasRoomFor(FArchive& Ar, int32 Count, int64 EntrySize)
+{
+	if (!Ar.IsLoading()) return true;
+
+	if (Count < 0 || Count * EntrySize > Ar.TotalSize() - Ar.Tell())
+	{
+		Ar.SetError();
+		return false;
+	}
+
+	return true;
+}
+
+void UOPSaveGame::SerializeSaveData(FArchive& Ar, EOPSaveVersion Version)
+{
+	if (Ar.IsLoading()) SaveVersion = static_cast<int32>(Version);
+
+	int64 SaveTicks = SaveTime.GetTicks();
+
+	Ar << SaveTicks << Seed << WaveIndex << CurrentHealth << CurrentWeaponIndex;
+
+	if (Ar.IsLoading()) SaveTime = FDateTime(SaveTicks);
+
+	//Only the ammo types that the player actually has are written.
+	int32 AmmoCount = ReserveAmmo.Num();
+	Ar << AmmoCount;
+
+	if (!HasRoomFor(Ar, AmmoCount, sizeof(uint8) + sizeof(int32))) return;
+
+	if (Ar.IsLoading())
+	{
+		ReserveAmmo.Reset();
+
+		for (int32 i = 0; i < AmmoCount; i++)
+		{
+			uint8 AmmoType = 0;
+			int32 Amount = 0;
+			Ar << AmmoType << Amount;
+
+			ReserveAmmo.Emplace(static_cast<EWeaponType>(AmmoType), Amount);
+		}
+	}
+	else
+	{
+		for (TPair<EWeaponType, int32>& Index : ReserveAmmo)
+		{
+			uint8 AmmoType = static_cast<uint8>(Index.Key);
+			Ar << AmmoType << Index.Value;
+		}
+	}
+
+	//Weapons are stored by the path of their class, so that saves don't depend on the order that classes happen to be loaded in.
+	int32 WeaponCount = Weapons.Num();
+	Ar << WeaponCount;
+
+	if (!HasRoomFor(Ar, WeaponCount, sizeof(int32) * 2 + sizeof(uint8))) return;
+
+	if (Ar.IsLoading()) Weapons.SetNum(WeaponCount);
+
+	for (FSavedWeapon& Index : Weapons)
+	{
+		FString ClassPath = Index.WeaponClass.ToString();
+		uint8 FireMode = static_cast<uint8>(Index.CurrentFireMode);
+
+		Ar << ClassPath << Index.CurrentMagazine << FireMode;
+
+		if (Ar.IsLoading())
+		{
+			Index.WeaponClass = TSoftClassPtr<AOPWeapon>(FSoftObjectPath(ClassPath));
+			Index.CurrentFireMode = static_cast<EFireMode>(FireMode);
+		}
+	}
+
+	//Each transaction's sequence number is its position in the log, so it's never written. Deltas only hold the end of the log, so they store where their part of it starts.
+	if (Version >= EOPSaveVersion::Journal) Ar << FirstTransaction;
+
+	int32 TransactionCount = TransactionLog.Num();
+	Ar << TransactionCount;
+
+	if (!HasRoomFor(Ar, TransactionCount, sizeof(int32) * 5 + sizeof(uint8))) return;
+
+	if (Ar.IsLoading()) TransactionLog.SetNum(TransactionCount);
+
+	for (int32 i = 0; i < TransactionLog.Num(); i++)
+	{
+		FEconomyTransaction& Transaction = TransactionLog[i];
+		uint8 Event = static_cast<uint8>(Transaction.Event);
+
+		Ar << Transaction.WaveIndex << Event << Transaction.Count << Transaction.Headshots << Transaction.Amount << Transaction.BalanceAfter;
+
+		if (Ar.IsLoading())
+		{
+			Transaction.Sequence = FirstTransaction + i;
+			Transaction.Event = static_cast<EEconomyEvent>(Event);
+		}
+	}
+
+	if (Version < EOPSaveVersion::Journal) return;
+
+	Ar << BaseId << DeltaIndex;
+
+	int32 CellActorCount = CellActors.Num();
+	Ar << CellActorCount;
+
+	if (!HasRoomFor(Ar, CellActorCount, sizeof(int32) * 4 + sizeof(uint8))) return;
+
+	if (Ar.IsLoading()) CellActors.SetNum(CellActorCount);
+
+	for (FSavedCellActor& Index : CellActors)
+	{
+		Ar << Index.Cell << Index.RecordIndex << Index.bIsConsumed << Index.ChunkHealth;
+	}
+}
+
+bool UOPSaveGame::ApplyDelta(const UOPSaveGame* Delta)
+{
+	if (!IsValid(Delta) || Delta->BaseId != BaseId || Delta->DeltaIndex != DeltaIndex + 1) return false;
+
+	//A delta can't start past the end of the log, or some transactions would be missing.
+	if (Delta->FirstTransaction < 0 || Delta->FirstTransaction > TransactionLog.Num()) return false;
+
+	SaveTime = Delta->SaveTime;
+	Seed = Delta->Seed;
+	WaveIndex = Delta->WaveIndex;
+	DeltaIndex = Delta->DeltaIndex;
+
+	//The player's inventory is small enough that every delta holds all of it.
+	CurrentHealth = Delta->CurrentHealth;
+	ReserveAmmo = Delta->ReserveAmmo;
+	Weapons = Delta->Weapons;
+	CurrentWeaponIndex = Delta->CurrentWeaponIndex;
+
+	TransactionLog.SetNum(Delta->FirstTransaction);
+	TransactionLog.Append(Delta->TransactionLog);
+
+	//Objects that changed again replace what was saved for them before.
+	for (const FSavedCellActor& Index : Delta->CellActors)
+	{
+		FSavedCellActor* Existing = CellActors.FindByPredicate([&Index](const FSavedCellActor& Other) { return Other.Cell == Index.Cell && Other.RecordIndex == Index.RecordIndex; });
+
+		if (Existing)
+		{
+			*Existing = Index;
+		}
+		else
+		{
+			CellActors.Emplace(Index);
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Data/OPWaveDefinition.h"
+
+int32 UOPWaveDefinition::GetTotalEnemyCount() const
+{
+	int32 Total = 0;
+
+	for (const FWaveEnemyGroup& Index : EnemyGroups)
+	{
+		Total += FMath::Max(Index.Count, 0);
+	}
+
+	return Total;
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Items/OPBarricade.h"
+#include "Components/BoxComponent.h"
+#include "Subsystems/OPBarricadeSubsystem.h"
+#include "Subsystems/OPFlowFieldSubsystem.h"
+#include "Subsystems/OPNavBuildSubsystem.h"
+
+// Sets default values
+AOPBarricade::AOPBarricade()
+{
+	//Barricades only change when they are damaged, so they never need to tick.
+	PrimaryActorTick.bCanEverTick = false;
+
+	CollisionBox = CreateDefaultSubobject<UBoxComponent>("Collision Box");
+	RootComponent = CollisionBox;
+	CollisionBox->SetBoxExtent(FVector(25.f, 200.f, 100.f));
+	CollisionBox->SetCollisionProfileName("BlockAll");
+	CollisionBox->SetGenerateOverlapEvents(false);
+	CollisionBox->SetCanEverAffectNavigation(true);
+}
+
+// Called when the game starts or when spawned
+void AOPBarricade::BeginPlay()
+{
+	Super::BeginPlay();
+
+	BarricadeSubsystem = GetWorld()->GetSubsystem<UOPBarricadeSubsystem>();
+	FlowField = GetWorld()->GetSubsystem<UOPFlowFieldSubsystem>();
+	NavBuild = GetWorld()->GetSubsystem<UOPNavBuildSubsystem>();
+
+	//Bind a callback function to OnTakePointDamage delegate.
+	OnTakePointDamage.AddDynamic(this, &AOPBarricade::TakePointDamage);
+
+	ChunkHealth.Init(ChunkMaxHealth, ChunkCount);
+	ChunkStates.Init(0, ChunkCount);
+	ChunkInstances.Init(INDEX_NONE, ChunkCount);
+
+	for (int32 i = 0; i < ChunkCount; i++)
+	{
+		if (IsValid(BarricadeSubsystem) && DamageStateMeshes.IsValidIndex(0)) ChunkInstances[i] = BarricadeSubsystem->AddChunkInstance(DamageStateMeshes[0], GetChunkTransform(i));
+	}
+
+	DestroyedChunks = 0;
+	bIsBreached = true;
+	SetBreached(false);
+}
+
+void AOPBarricade::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//Give the barricade's chunk instances and flow field cells back, if it's removed while the level keeps playing.
+	for (int32 i = 0; i < ChunkInstances.Num(); i++)
+	{
+		SetChunkState(i, GetDamageState(0));
+	}
+
+	if (bIsBlockingFlowField && IsValid(FlowField)) FlowField->SetRegionBlocked(CollisionBox->Bounds.GetBox(), false);
+	bIsBlockingFlowField = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 AOPBarricade::GetTotalHealth() const
+{
+	int32 TotalHealth = 0;
+
+	for (int32 Index : ChunkHealth)
+	{
+		TotalHealth += Index;
+	}
+
+	return TotalHealth;
+}
+
+void AOPBarricade::RepairBarricade()
+{
+	for (int32 i = 0; i < ChunkHealth.Num(); i++)
+	{
+		ChunkHealth[i] = ChunkMaxHealth;
+		SetChunkState(i, 0);
+	}
+
+	DestroyedChunks = 0;
+	SetBreached(false);
+}
+
+void AOPBarricade::GetPackedChunkHealth(TArray<uint8>& OutChunkHealth) const
+{
+	OutChunkHealth.SetNumUninitialized(ChunkHealth.Num());
+
+	for (int32 i = 0; i < ChunkHealth.Num(); i++)
+	{
+		OutChunkHealth[i] = static_cast<uint8>(FMath::Clamp(FMath::CeilToInt(255.f * ChunkHealth[i] / FMath::Max(ChunkMaxHealth, 1)), 0, 255));
+	}
+}
+
+void AOPBarricade::SetPackedChunkHealth(const TArray<uint8>& PackedChunkHealth)
+{
+	DestroyedChunks = 0;
+
+	for (int32 i = 0; i < ChunkHealth.Num() && i < PackedChunkHealth.Num(); i++)
+	{
+		ChunkHealth[i] = FMath::CeilToInt(ChunkMaxHealth * PackedChunkHealth[i] / 255.f);
+
+		const int32 NewState = GetDamageState(ChunkHealth[i]);
+
+		if (NewState != ChunkStates[i]) SetChunkState(i, NewState);
+
+		if (ChunkHealth[i] <= 0) DestroyedChunks++;
+	}
+
+	SetBreached(DestroyedChunks >= FMath::Max(FMath::CeilToInt(ChunkCount * BreachFraction), 1));
+}
+
+void AOPBarricade::TakePointDamage(AActor* DamagedActor, float Damage, AController* InstigatedBy, FVector HitLocation, UPrimitiveComponent* FHitComponent, FName BoneName, FVector ShotFromDirection, const UDamageType* DamageType, AActor* DamageCauser)
+{
+	const int32 ChunkIndex = FindChunkNear(HitLocation);
+
+	if (ChunkIndex == INDEX_NONE) return;
+
+	//Only the chunk that was hit loses health. Nothing else about the barricade changes, unless the chunk's damage state does.
+	ChunkHealth[ChunkIndex] = FMath::Max(ChunkHealth[ChunkIndex] - FMath::RoundToInt(Damage), 0);
+
+	const int32 NewState = GetDamageState(ChunkHealth[ChunkIndex]);
+
+	if (NewState == ChunkStates[ChunkIndex]) return;
+
+	SetChunkState(ChunkIndex, NewState);
+
+	if (ChunkHealth[ChunkIndex] > 0) return;
+
+	//Navigation and the flow field are only updated once, when enough chunks are gone for enemies to get through.
+	DestroyedChunks++;
+
+	if (!bIsBreached && DestroyedChunks >= FMath::Max(FMath::CeilToInt(ChunkCount * BreachFraction), 1)) SetBreached(true);
+}
+
+int32 AOPBarricade::FindChunkNear(const FVector& Location) const
+{
+	if (ChunkHealth.IsEmpty()) return INDEX_NONE;
+
+	//Chunks are laid out in a row along the box's width, so the closest one can be found from the hit's position along that row.
+	const float ChunkWidth = CollisionBox->GetUnscaledBoxExtent().Y * 2.f / ChunkHealth.Num();
+	const float LocalY = GetActorTransform().InverseTransformPosition(Location).Y + CollisionBox->GetUnscaledBoxExtent().Y;
+	const int32 HitChunk = FMath::Clamp(FMath::FloorToInt(LocalY / ChunkWidth), 0, ChunkHealth.Num() - 1);
+
+	//If the chunk that was hit is already gone, the damage goes to the nearest chunk that isn't.
+	for (int32 Offset = 0; Offset < ChunkHealth.Num(); Offset++)
+	{
+		if (ChunkHealth.IsValidIndex(HitChunk - Offset) && ChunkHealth[HitChunk - Offset] > 0) return HitChunk - Offset;
+		if (ChunkHealth.IsValidIndex(HitChunk + Offset) && ChunkHealth[HitChunk + Offset] > 0) return HitChunk + Offset;
+	}
+
+	return INDEX_NONE;
+}
+
+int32 AOPBarricade::GetDamageState(int32 Health) const
+{
+	//Destroyed chunks are always one state past the most damaged mesh, even if there are no meshes at all.
+	const int32 StateCount = FMath::Max(DamageStateMeshes.Num(), 1);
+
+	if (Health <= 0) return StateCount;
+
+	const float DamageFraction = 1.f - static_cast<float>(Health) / FMath::Max(ChunkMaxHealth, 1);
+
+	return FMath::Clamp(FMath::FloorToInt(DamageFraction * StateCount), 0, StateCount - 1);
+}
+
+void AOPBarricade::SetChunkState(int32 ChunkIndex, int32 NewState)
+{
+	if (!IsValid(BarricadeSubsystem)) return;
+
+	const int32 OldState = ChunkStates[ChunkIndex];
+
+	if (DamageStateMeshes.IsValidIndex(OldState)) BarricadeSubsystem->RemoveChunkInstance(DamageStateMeshes[OldState], ChunkInstances[ChunkIndex]);
+
+	ChunkInstances[ChunkIndex] = DamageStateMeshes.IsValidIndex(NewState) ? BarricadeSubsystem->AddChunkInstance(DamageStateMeshes[NewState], GetChunkTransform(ChunkIndex)) : INDEX_NONE;
+	ChunkStates[ChunkIndex] = NewState;
+}
+
+FTransform AOPBarricade::GetChunkTransform(int32 ChunkIndex) const
+{
+	const float ChunkWidth = CollisionBox->GetUnscaledBoxExtent().Y * 2.f / FMath::Max(ChunkHealth.Num(), 1);
+	const FVector LocalOffset(0.f, (ChunkIndex + 0.5f) * ChunkWidth - CollisionBox->GetUnscaledBoxExtent().Y, -CollisionBox->GetUnscaledBoxExtent().Z);
+
+	return FTransform(LocalOffset) * GetActorTransform();
+}
+
+void AOPBarricade::SetBreached(bool bBreached)
+{
+	if (bIsBreached == bBreached) return;
+
+	bIsBreached = bBreached;
+
+	//A breached barricade stops blocking characters and shots, and no longer carves a hole in the navmesh.
+	CollisionBox->SetCollisionEnabled(bBreached ? ECollisionEnabled::NoCollision : ECollisionEnabled::QueryAndPhysics);
+	CollisionBox->SetCanEverAffectNavigation(!bBreached);
+
+	//Only the navmesh tiles under the barricade are rebuilt, ahead of any larger rebuild that might be running.
+	if (IsValid(NavBuild)) NavBuild->RebuildDirtyArea(CollisionBox->Bounds.GetBox());
+
+	//The flow field only needs to recalculate the cells under the barricade.
+	if (IsValid(FlowField) && bIsBlockingFlowField == bBreached)
+	{
+		FlowField->SetRegionBlocked(CollisionBox->Bounds.GetBox(), !bBreached);
+		bIsBlockingFlowField = !bBreached;
+	}
+}
\ No newline at end of file
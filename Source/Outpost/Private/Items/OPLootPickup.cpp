@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Items/OPLootPickup.h"
+#include "Items/OPWeapon.h"
+#include "Interfaces/OPCharacterInterface.h"
+#include "Subsystems/OPLootSubsystem.h"
+
+// Sets default values
+AOPLootPickup::AOPLootPickup()
+{
+	//Loot just sits on the ground, so it never needs to tick.
+	PrimaryActorTick.bCanEverTick = false;
+
+	PickupRoot = CreateDefaultSubobject<USceneComponent>("Pickup Root");
+	RootComponent = PickupRoot;
+
+	//Both meshes can only be hit by interact traces.
+	AmmoMesh = CreateDefaultSubobject<UStaticMeshComponent>("Ammo Mesh");
+	AmmoMesh->SetupAttachment(PickupRoot);
+	AmmoMesh->SetGenerateOverlapEvents(false);
+	AmmoMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	AmmoMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
+	AmmoMesh->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
+	AmmoMesh->SetCastShadow(false);
+
+	WeaponMesh = CreateDefaultSubobject<USkeletalMeshComponent>("Weapon Mesh");
+	WeaponMesh->SetupAttachment(PickupRoot);
+	WeaponMesh->SetGenerateOverlapEvents(false);
+	WeaponMesh->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	WeaponMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
+	WeaponMesh->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
+	WeaponMesh->SetComponentTickEnabled(false);
+	WeaponMesh->SetCastShadow(false);
+}
+
+void AOPLootPickup::ActivateAsAmmo(const FVector& Location, EWeaponType NewAmmoType, int32 Amount, UStaticMesh* Mesh)
+{
+	WeaponClass = nullptr;
+	AmmoType = NewAmmoType;
+	AmmoAmount = Amount;
+
+	AmmoMesh->SetStaticMesh(Mesh);
+	AmmoMesh->SetVisibility(true);
+	WeaponMesh->SetVisibility(false);
+
+	SetActorLocation(Location);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+}
+
+void AOPLootPickup::ActivateAsWeapon(const FVector& Location, TSubclassOf<AOPWeapon> NewWeaponClass)
+{
+	WeaponClass = NewWeaponClass;
+	AmmoAmount = 0;
+
+	//The pickup borrows the weapon's mesh, without spawning the weapon itself.
+	WeaponMesh->SetSkeletalMeshAsset(NewWeaponClass.GetDefaultObject()->WeaponMesh->GetSkeletalMeshAsset());
+	WeaponMesh->SetVisibility(true);
+	AmmoMesh->SetVisibility(false);
+
+	SetActorLocation(Location);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+}
+
+UStaticMesh* AOPLootPickup::GetAmmoMesh() const
+{
+	return IsAmmo() ? AmmoMesh->GetStaticMesh() : nullptr;
+}
+
+void AOPLootPickup::Deactivate()
+{
+	WeaponClass = nullptr;
+	AmmoAmount = 0;
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+}
+
+void AOPLootPickup::OnInteract_Implementation(AActor* CallingPlayer)
+{
+	if (!IsValid(CallingPlayer) || !CallingPlayer->Implements<UOPCharacterInterface>()) return;
+
+	//Weapons are only spawned now, when the player actually takes one...
+	if (IsValid(WeaponClass))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TObjectPtr<AOPWeapon> NewWeapon = GetWorld()->SpawnActor<AOPWeapon>(WeaponClass, GetActorTransform(), SpawnParams);
+
+		if (IsValid(NewWeapon)) IOPCharacterInterface::Execute_PickUpWeapon(CallingPlayer, NewWeapon);
+	}
+	//...Otherwise, the player takes the ammo, as long as they have room for it.
+	else
+	{
+		if (IOPCharacterInterface::Execute_IsPlayerReserveAmmoMaxedOut(CallingPlayer, AmmoType)) return;
+
+		IOPCharacterInterface::Execute_PickUpAmmo(CallingPlayer, AmmoType, AmmoAmount);
+	}
+
+	//Return the pickup to the loot subsystem, so that it can be reused.
+	TObjectPtr<UOPLootSubsystem> LootSubsystem = GetWorld()->GetSubsystem<UOPLootSubsystem>();
+
+	if (IsValid(LootSubsystem))
+	{
+		LootSubsystem->ReleasePickup(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+FText AOPLootPickup::GetInteractableObjectName_Implementation()
+{
+	if (IsValid(WeaponClass)) return WeaponClass.GetDefaultObject()->Stats.WeaponName;
+
+	return FText::Format(FText::FromString("{0} Ammo ({1})"), UEnum::GetDisplayValueAsText(AmmoType), FText::AsNumber(AmmoAmount));
+}
+
+EInteractType AOPLootPickup::GetInteractableObjectType_Implementation()
+{
+	return EInteractType::Item;
+}
\ No newline at end of file
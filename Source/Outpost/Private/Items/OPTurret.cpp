@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Items/OPTurret.h"
+#include "Items/OPWeapon.h"
+#include "Subsystems/OPTurretSubsystem.h"
+
+// Sets default values
+AOPTurret::AOPTurret()
+{
+	//Turrets are aimed and fired by the turret subsystem, so they never need to tick.
+	PrimaryActorTick.bCanEverTick = false;
+
+	BaseMesh = CreateDefaultSubobject<UStaticMeshComponent>("Base Mesh");
+	RootComponent = BaseMesh;
+
+	HeadMesh = CreateDefaultSubobject<UStaticMeshComponent>("Head Mesh");
+	HeadMesh->SetupAttachment(BaseMesh);
+	HeadMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+// Called when the game starts or when spawned
+void AOPTurret::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//The turret's weapon is owned by the turret, so its shots are credited to whoever placed the turret.
+	if (IsValid(WeaponClass))
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = this;
+		SpawnParams.Instigator = GetInstigator();
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		Weapon = GetWorld()->SpawnActor<AOPWeapon>(WeaponClass, HeadMesh->GetComponentTransform(), SpawnParams);
+
+		if (IsValid(Weapon))
+		{
+			Weapon->AttachToComponent(HeadMesh, FAttachmentTransformRules::SnapToTargetNotIncludingScale, WeaponSocket);
+			Weapon->SetActorTickEnabled(false);
+			Weapon->SetActorEnableCollision(false);
+		}
+	}
+
+	TurretSubsystem = GetWorld()->GetSubsystem<UOPTurretSubsystem>();
+
+	if (IsValid(TurretSubsystem)) TurretSubsystem->RegisterTurret(this);
+}
+
+void AOPTurret::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (IsValid(TurretSubsystem)) TurretSubsystem->UnregisterTurret(this);
+
+	if (IsValid(Weapon)) Weapon->Destroy();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AOPTurret::AimAt(const FVector& TargetLocation)
+{
+	const FVector ToTarget = TargetLocation - HeadMesh->GetComponentLocation();
+
+	HeadMesh->SetWorldRotation(FRotator(0.f, ToTarget.Rotation().Yaw, 0.f));
+}
+
+FVector AOPTurret::GetPivotLocation() const
+{
+	return HeadMesh->GetComponentLocation();
+}
\ No newline at end of file
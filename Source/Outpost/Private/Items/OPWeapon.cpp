@@ -2,11 +2,14 @@
 
 #include "Items/OPWeapon.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "DrawDebugHelpers.h"
 #include "Subsystems/OPWorldSubsystem.h"
+#include "Subsystems/OPTraceBatchSubsystem.h"
 #include "Interfaces/OPCharacterInterface.h"
 #include "Kismet/GameplayStatics.h"
 #include "NiagaraFunctionLibrary.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
+#include "OPProfiling.h"
 
 // Sets default values
 AOPWeapon::AOPWeapon()
@@ -31,8 +34,9 @@ void AOPWeapon::BeginPlay()
 {
 	Super::BeginPlay();
 
-	//Get a reference to the world subsystem.
+	//Get references to the world subsystem and the trace batch.
 	WorldSubsystem = GetWorld()->GetSubsystem<UOPWorldSubsystem>();
+	TraceBatchSubsystem = GetWorld()->GetSubsystem<UOPTraceBatchSubsystem>();
 
 	Stats.CurrentMagazine = Stats.MaxMagazine;
 
@@ -57,6 +61,8 @@ void AOPWeapon::Tick(float DeltaTime)
 
 void AOPWeapon::Shoot()
 {
+	OP_PROFILE_SCOPE(Shoot);
+
 	//The weapon cannot shoot, if its magazine is empty.
 	if (Stats.CurrentMagazine <= 0) return;
 
@@ -92,8 +98,116 @@ void AOPWeapon::Shoot()
 	if (IsValid(WorldSubsystem)) CheckInfiniteAmmoStatus();
 }
 
+void AOPWeapon::AIShoot(const FVector& TargetLocation, float AccuracyModifier)
+{
+	if (!FireFromMuzzle(TargetLocation, AccuracyModifier)) return;
+
+	bFiringCooldownActive = true;
+
+	//Set a timer for when the cooldown on firing will end.
+	GetWorldTimerManager().SetTimer(FiringCooldownHandle, this, &AOPWeapon::EndFiringCooldown, Stats.FireRate, false);
+}
+
+bool AOPWeapon::FireFromMuzzle(const FVector& TargetLocation, float AccuracyModifier)
+{
+	OP_PROFILE_SCOPE(Shoot);
+
+	//The weapon cannot shoot, if its magazine is empty.
+	if (Stats.CurrentMagazine <= 0) return false;
+
+	//AI shots come out of the weapon's muzzle, and head towards whatever the AI is aiming at.
+	const FVector MuzzleLocation = WeaponMesh->DoesSocketExist(MuzzleSocket) ? WeaponMesh->GetSocketLocation(MuzzleSocket) : WeaponMesh->GetComponentLocation();
+	const FVector AimDirection = (TargetLocation - MuzzleLocation).GetSafeNormal();
+	const float SpreadRadius = Stats.SpreadRadius * AISpreadMultiplier * FMath::Max(AccuracyModifier, 0.f);
+
+	if (IsValid(WeaponShootMontage)) WeaponMesh->PlayAnimation(WeaponShootMontage, false);
+
+	//If the weapon is a shotgun, then all of its shots will fire at once. Otherwise, only one shot will be fired.
+	const int32 ShotCount = Stats.WeaponType == EWeaponType::Shotgun ? FMath::Max(Stats.ShotAmount, 1) : 1;
+
+	for (int32 i = 0; i < ShotCount; i++)
+	{
+		QueueAIWeaponTrace(MuzzleLocation, AimDirection, SpreadRadius);
+	}
+
+	if (IsValid(WorldSubsystem)) CheckInfiniteAmmoStatus();
+
+	return true;
+}
+
+void AOPWeapon::QueueAIWeaponTrace(const FVector& MuzzleLocation, const FVector& AimDirection, float SpreadRadius)
+{
+	const FVector EndLocation = MuzzleLocation + FMath::VRandCone(AimDirection, SpreadRadius, SpreadRadius) * Stats.MaxRange;
+
+	OP_COUNT_TRACE();
+
+	//Refresh the cached owner and query parameters, if the weapon has changed hands.
+	GetOwnerController();
+
+	//If the trace batch isn't available, then the shot is traced right away instead.
+	if (!IsValid(TraceBatchSubsystem))
+	{
+		FHitResult HitResult;
+		const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(HitResult, MuzzleLocation, EndLocation, ECC_GameTraceChannel1, AITraceParams);
+
+		OnAIWeaponTraceComplete(HitResult, bBlockingHit);
+		return;
+	}
+
+	TraceBatchSubsystem->QueueLineTrace(MuzzleLocation, EndLocation, ECC_GameTraceChannel1, AITraceParams, FOPTraceBatchDelegate::CreateUObject(this, &AOPWeapon::OnAIWeaponTraceComplete));
+}
+
+void AOPWeapon::OnAIWeaponTraceComplete(const FHitResult& HitResult, bool bBlockingHit)
+{
+	OP_PROFILE_SCOPE(WeaponTrace);
+
+	WeaponHitResult = HitResult;
+
+	//Impact effects are rotated to face where the shot came from.
+	CameraRotation = (HitResult.TraceEnd - HitResult.TraceStart).Rotation();
+
+	//Show debug lines for the line trace, if they've been globally enabled.
+	if (IsValid(WorldSubsystem) && WorldSubsystem->bWeaponDebugLinesEnabled)
+	{
+		DrawDebugLine(GetWorld(), HitResult.TraceStart, bBlockingHit ? HitResult.ImpactPoint : HitResult.TraceEnd, FColor::Red, false, 2.f);
+		if (bBlockingHit) DrawDebugPoint(GetWorld(), HitResult.ImpactPoint, 16.f, FColor::Green, false, 2.f);
+	}
+
+	if (bBlockingHit) ApplyDamageToTarget();
+}
+
+AController* AOPWeapon::GetOwnerController()
+{
+	//Only look the controller up again if the weapon has a new owner, or the old controller is gone (such as when an enemy dies and is reused).
+	if (CachedOwner != GetOwner() || !IsValid(CachedController))
+	{
+		CachedOwner = GetOwner();
+		CachedController = IsValid(CachedOwner) ? CachedOwner->GetInstigatorController() : nullptr;
+
+		//Weapon line traces should always ignore the weapon itself, as well as its owner.
+		AITraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(OPWeaponAITrace), false, this);
+		AITraceParams.bReturnPhysicalMaterial = true;
+
+		if (IsValid(CachedOwner)) AITraceParams.AddIgnoredActor(CachedOwner);
+	}
+
+	return CachedController;
+}
+
+void AOPWeapon::ResetWeaponState()
+{
+	GetWorldTimerManager().ClearTimer(FiringCooldownHandle);
+	bFiringCooldownActive = false;
+	BurstCount = 0;
+
+	Stats.CurrentMagazine = Stats.MaxMagazine;
+	Stats.CurrentFireMode = Stats.DefaultFireMode;
+}
+
 void AOPWeapon::WeaponLineTrace()
 {
+	OP_PROFILE_SCOPE(WeaponTrace);
+
 	//Force-initializes the weapon hit result, so that it is unique each time.
 	WeaponHitResult = FHitResult(ForceInit);
 
@@ -103,7 +217,7 @@ void AOPWeapon::WeaponLineTrace()
 	ActorsToIgnore.Emplace(GetOwner());
 
 	//Need to get a reference to the controller of the weapon's owner.
-	TObjectPtr<AController> Controller = GetOwner()->GetInstigatorController();
+	TObjectPtr<AController> Controller = GetOwnerController();
 	
 	if (IsValid(Controller))
 	{
@@ -112,6 +226,8 @@ void AOPWeapon::WeaponLineTrace()
 
 		FVector EndLocation = CalculateWeaponSpread();
 
+		OP_COUNT_TRACE();
+
 		//Show debug lines for the line trace, if they've been globally enabled.
 		if (IsValid(WorldSubsystem) && WorldSubsystem->bWeaponDebugLinesEnabled)
 		{
@@ -146,7 +262,7 @@ void AOPWeapon::ApplyDamageToTarget()
 		//If a character was hit, then tell them which physical material on their mesh's physics asset was hit.
 		if (Target->Implements<UOPCharacterInterface>()) IOPCharacterInterface::Execute_UpdateLastHitMaterial(Target, WeaponHitResult.PhysMaterial.Get());
 		
-		UGameplayStatics::ApplyPointDamage(Target, Stats.Damage, ShotFromDirection, WeaponHitResult, GetOwner()->GetInstigatorController(), this, Stats.DamageType);
+		UGameplayStatics::ApplyPointDamage(Target, Stats.Damage, ShotFromDirection, WeaponHitResult, GetOwnerController(), this, Stats.DamageType);
 
 		SpawnParticleEffectOnTarget();
 	}
@@ -154,8 +270,12 @@ void AOPWeapon::ApplyDamageToTarget()
 
 void AOPWeapon::SpawnParticleEffectOnTarget()
 {
+	OP_PROFILE_SCOPE(ImpactEffect);
+
 	if (!IsValid(WeaponHitResult.PhysMaterial.Get())) return;
 
+	OP_COUNT_IMPACT_EFFECT();
+
 	//Based on the particle effects being used, this will cause them to spawn in a way that faces the player.
 	FRotator EnvironmentRotation = FRotator(WeaponHitResult.GetActor()->GetActorRotation().Yaw, CameraRotation.Yaw, 0.f);
 
@@ -190,10 +310,10 @@ void AOPWeapon::EndFiringCooldown()
 void AOPWeapon::CheckInfiniteAmmoStatus()
 {
 	//Need to get a reference to the controller of the weapon's owner.
-	TObjectPtr<AController> Controller = GetOwner()->GetInstigatorController();
+	TObjectPtr<AController> Controller = GetOwnerController();
 	
-	//Only the player is allowed to have infinite ammo.
-	if (IsValid(Controller) && Controller->IsPlayerController())
+	//Only the player is allowed to have infinite ammo. Weapons that belong to something the player placed, such as a turret, don't count.
+	if (IsValid(Controller) && Controller->IsPlayerController() && Controller->GetPawn() == GetOwner())
 	{
 		//If infinite ammo is enabled, then no ammo will be subtracted from the weapon's magazine.
 		if (WorldSubsystem->bInfiniteAmmoEnabled) return;
@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OPProfiling.h"
+
+#if OP_PROFILING_ENABLED
+
+DEFINE_STAT(STAT_OPShoot);
+DEFINE_STAT(STAT_OPWeaponTrace);
+DEFINE_STAT(STAT_OPImpactEffect);
+DEFINE_STAT(STAT_OPInteractTrace);
+DEFINE_STAT(STAT_OPCheckInteractables);
+DEFINE_STAT(STAT_OPTakePointDamage);
+DEFINE_STAT(STAT_OPCharacterDeath);
+DEFINE_STAT(STAT_OPMeleeTrace);
+DEFINE_STAT(STAT_OPMeleeHit);
+DEFINE_STAT(STAT_OPTraces);
+DEFINE_STAT(STAT_OPImpactEffects);
+DEFINE_STAT(STAT_OPLiveEnemies);
+DEFINE_STAT(STAT_OPRagdolls);
+
+UE_TRACE_CHANNEL_DEFINE(OutpostChannel);
+
+bool FOPProfiler::bTimingEnabled = false;
+bool FOPProfiler::bProfilingEnabled = false;
+uint64 FOPProfiler::TotalCycles[(int32)EOPProfiledSystem::Count] = {};
+uint64 FOPProfiler::MaxCycles[(int32)EOPProfiledSystem::Count] = {};
+int64 FOPProfiler::CallCounts[(int32)EOPProfiledSystem::Count] = {};
+int32 FOPProfiler::LiveEnemyCount = 0;
+int32 FOPProfiler::RagdollCount = 0;
+
+void FOPProfiler::SetTimingEnabled(bool bEnabled)
+{
+	bTimingEnabled = bEnabled;
+}
+
+void FOPProfiler::SetProfilingEnabled(bool bEnabled)
+{
+	bProfilingEnabled = bEnabled;
+
+#if UE_TRACE_ENABLED
+	UE::Trace::ToggleChannel(TEXT("Outpost"), bEnabled);
+#endif
+
+	//The counters that only change now and then are filled in straight away, instead of waiting for their next change.
+	if (bProfilingEnabled)
+	{
+		SET_DWORD_STAT(STAT_OPLiveEnemies, LiveEnemyCount);
+		SET_DWORD_STAT(STAT_OPRagdolls, RagdollCount);
+	}
+}
+
+void FOPProfiler::Reset()
+{
+	FMemory::Memzero(TotalCycles);
+	FMemory::Memzero(MaxCycles);
+	FMemory::Memzero(CallCounts);
+}
+
+void FOPProfiler::AddTime(EOPProfiledSystem System, uint64 Cycles)
+{
+	const int32 SystemIndex = (int32)System;
+
+	TotalCycles[SystemIndex] += Cycles;
+	MaxCycles[SystemIndex] = FMath::Max(MaxCycles[SystemIndex], Cycles);
+	CallCounts[SystemIndex]++;
+}
+
+double FOPProfiler::GetTotalSeconds(EOPProfiledSystem System)
+{
+	return FPlatformTime::ToSeconds64(TotalCycles[(int32)System]);
+}
+
+double FOPProfiler::GetMaxSeconds(EOPProfiledSystem System)
+{
+	return FPlatformTime::ToSeconds64(MaxCycles[(int32)System]);
+}
+
+int64 FOPProfiler::GetCallCount(EOPProfiledSystem System)
+{
+	return CallCounts[(int32)System];
+}
+
+const TCHAR* FOPProfiler::GetSystemName(EOPProfiledSystem System)
+{
+	switch (System)
+	{
+		case EOPProfiledSystem::Shoot:
+			return TEXT("Shoot");
+		case EOPProfiledSystem::WeaponTrace:
+			return TEXT("WeaponTrace");
+		case EOPProfiledSystem::ImpactEffect:
+			return TEXT("ImpactEffect");
+		case EOPProfiledSystem::InteractTrace:
+			return TEXT("InteractTrace");
+		case EOPProfiledSystem::CheckInteractables:
+			return TEXT("CheckInteractables");
+		case EOPProfiledSystem::TakePointDamage:
+			return TEXT("TakePointDamage");
+		case EOPProfiledSystem::CharacterDeath:
+			return TEXT("CharacterDeath");
+		case EOPProfiledSystem::MeleeTrace:
+			return TEXT("MeleeTrace");
+		case EOPProfiledSystem::MeleeHit:
+			return TEXT("MeleeHit");
+		default:
+			return TEXT("Unknown");
+	}
+}
+
+void FOPProfiler::SetLiveEnemyCount(int32 Count)
+{
+	LiveEnemyCount = Count;
+
+	if (bProfilingEnabled)
+	{
+		SET_DWORD_STAT(STAT_OPLiveEnemies, LiveEnemyCount);
+	}
+}
+
+void FOPProfiler::AdjustRagdollCount(int32 Delta)
+{
+	RagdollCount = FMath::Max(RagdollCount + Delta, 0);
+
+	if (bProfilingEnabled)
+	{
+		SET_DWORD_STAT(STAT_OPRagdolls, RagdollCount);
+	}
+}
+
+#endif
\ No newline at end of file
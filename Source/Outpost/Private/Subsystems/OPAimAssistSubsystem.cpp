@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPAimAssistSubsystem.h"
+#include "Subsystems/OPEnemyGridSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Characters/OPEnemy.h"
+#include "UASAimAssistTargetComponent.h"
+#include "Kismet/GameplayStatics.h"
+
+void UOPAimAssistSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	EnemyGrid = Collection.InitializeDependency<UOPEnemyGridSubsystem>();
+
+	//Aim assist targets are switched off as soon as their enemy enters play, and forgotten as soon as it leaves.
+	TObjectPtr<UOPWorldSubsystem> WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+
+	if (IsValid(WorldSubsystem))
+	{
+		WorldSubsystem->OnEnemyRegistered.AddUObject(this, &UOPAimAssistSubsystem::OnEnemyRegistered);
+		WorldSubsystem->OnEnemyUnregistered.AddUObject(this, &UOPAimAssistSubsystem::OnEnemyUnregistered);
+	}
+}
+
+void UOPAimAssistSubsystem::Deinitialize()
+{
+	EnabledTargets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPAimAssistSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TObjectPtr<APlayerController> PlayerController = UGameplayStatics::GetPlayerController(this, 0);
+
+	if (!IsValid(PlayerController) || !IsValid(EnemyGrid)) return;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const FVector ViewDirection = ViewRotation.Vector();
+	const float AssistCosine = FMath::Cos(FMath::DegreesToRadians(AssistHalfAngle));
+
+	//Only the enemies near the player are looked at, and only the ones inside of the view cone are kept.
+	TArray<AActor*> NearbyEnemies;
+	EnemyGrid->QueryRadius(ViewLocation, AssistRange, NearbyEnemies);
+
+	TArray<TPair<float, UUASAimAssistTargetComponent*>> Candidates;
+
+	for (AActor* Index : NearbyEnemies)
+	{
+		const float Alignment = FVector::DotProduct(ViewDirection, (Index->GetActorLocation() - ViewLocation).GetSafeNormal());
+
+		if (Alignment < AssistCosine) continue;
+
+		TObjectPtr<UUASAimAssistTargetComponent> Target = GetAimAssistTarget(Index);
+
+		if (IsValid(Target)) Candidates.Emplace(Alignment, Target);
+	}
+
+	//If there are too many candidates, the ones closest to the center of the player's view win.
+	if (Candidates.Num() > MaxEnabledTargets)
+	{
+		Candidates.Sort([](const TPair<float, UUASAimAssistTargetComponent*>& a, const TPair<float, UUASAimAssistTargetComponent*>& b) {return a.Key > b.Key;});
+		Candidates.SetNum(FMath::Max(MaxEnabledTargets, 0));
+	}
+
+	TArray<TObjectPtr<UUASAimAssistTargetComponent>> NewTargets;
+
+	for (const TPair<float, UUASAimAssistTargetComponent*>& Index : Candidates)
+	{
+		NewTargets.Emplace(Index.Value);
+	}
+
+	//Only targets that have entered or left the view cone are switched, so that most frames don't touch any components at all.
+	for (TObjectPtr<UUASAimAssistTargetComponent> Index : EnabledTargets)
+	{
+		if (IsValid(Index) && !NewTargets.Contains(Index)) Index->SetActive(false);
+	}
+
+	for (TObjectPtr<UUASAimAssistTargetComponent> Index : NewTargets)
+	{
+		if (!EnabledTargets.Contains(Index)) Index->SetActive(true);
+	}
+
+	EnabledTargets = MoveTemp(NewTargets);
+}
+
+TStatId UOPAimAssistSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPAimAssistSubsystem, STATGROUP_Tickables);
+}
+
+void UOPAimAssistSubsystem::OnEnemyRegistered(AActor* Enemy)
+{
+	TObjectPtr<UUASAimAssistTargetComponent> Target = GetAimAssistTarget(Enemy);
+
+	if (IsValid(Target)) Target->SetActive(false);
+}
+
+void UOPAimAssistSubsystem::OnEnemyUnregistered(AActor* Enemy)
+{
+	TObjectPtr<UUASAimAssistTargetComponent> Target = GetAimAssistTarget(Enemy);
+
+	if (IsValid(Target))
+	{
+		Target->SetActive(false);
+		EnabledTargets.Remove(Target);
+	}
+}
+
+UUASAimAssistTargetComponent* UOPAimAssistSubsystem::GetAimAssistTarget(AActor* Enemy) const
+{
+	TObjectPtr<AOPEnemy> EnemyCharacter = Cast<AOPEnemy>(Enemy);
+
+	return IsValid(EnemyCharacter) ? EnemyCharacter->GetAimAssistTargetComponent() : nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,467 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPAreaStreamingSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Items/OPBarricade.h"
+#include "Data/OPSaveGame.h"
+#include "OPStructs.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+
+void UOPAreaStreamingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+}
+
+void UOPAreaStreamingSubsystem::Deinitialize()
+{
+	ClearCells();
+
+	Super::Deinitialize();
+}
+
+void UOPAreaStreamingSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsStreaming || Cells.IsEmpty()) return;
+
+	TObjectPtr<APawn> PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+
+	if (IsValid(PlayerPawn)) UpdateCells(PlayerPawn->GetActorLocation(), true);
+}
+
+TStatId UOPAreaStreamingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPAreaStreamingSubsystem, STATGROUP_Tickables);
+}
+
+void UOPAreaStreamingSubsystem::ClearCells()
+{
+	bIsStreaming = false;
+
+	for (TPair<FIntPoint, FOPStreamingCell>& Index : Cells)
+	{
+		SetCellDetail(Index.Key, Index.Value, ECellDetail::Unloaded);
+	}
+
+	if (IsValid(CellOwner)) CellOwner->Destroy();
+
+	CellOwner = nullptr;
+	Cells.Empty();
+	ActorRecordLookup.Empty();
+	DirtyRecords.Empty();
+}
+
+void UOPAreaStreamingSubsystem::SetCellSize(float NewCellSize)
+{
+	CellSize = FMath::Max(NewCellSize, 100.f);
+}
+
+void UOPAreaStreamingSubsystem::AddInstance(const FGenerationRule& Rule, const FTransform& Transform)
+{
+	if (!IsValid(Rule.Mesh)) return;
+
+	FOPStreamingCell& Cell = FindOrAddCell(Transform.GetLocation());
+
+	//There are only ever a handful of meshes in a single cell, so a linear search is enough.
+	FOPInstanceBatch* Batch = Cell.Batches.FindByPredicate([&Rule](const FOPInstanceBatch& Index) { return Index.Mesh == Rule.Mesh && Index.Material == Rule.MaterialOverride; });
+
+	if (!Batch)
+	{
+		Batch = &Cell.Batches.AddDefaulted_GetRef();
+		Batch->Mesh = Rule.Mesh;
+		Batch->Material = Rule.MaterialOverride;
+		Batch->CullDistance = Rule.CullDistance;
+	}
+	else if (Batch->CullDistance > 0.f)
+	{
+		//Rules that share a mesh and material share a batch, so the batch is drawn as far out as any of them. A rule that is never culled keeps the whole batch from being culled.
+		Batch->CullDistance = Rule.CullDistance > 0.f ? FMath::Max(Batch->CullDistance, Rule.CullDistance) : 0.f;
+	}
+
+	Batch->Transforms.Emplace(Transform);
+	Batch->bHasCollision |= Rule.bHasCollision;
+}
+
+void UOPAreaStreamingSubsystem::AddActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+{
+	if (!IsValid(ActorClass)) return;
+
+	FOPCellActor& Record = FindOrAddCell(Transform.GetLocation()).ActorRecords.AddDefaulted_GetRef();
+	Record.ActorClass = ActorClass;
+	Record.Transform = Transform;
+}
+
+void UOPAreaStreamingSubsystem::AddSpawnZone(const FVector& Location)
+{
+	FindOrAddCell(Location).SpawnZones.Emplace(Location);
+}
+
+void UOPAreaStreamingSubsystem::StartStreaming(FVector PlayerLocation)
+{
+	bIsStreaming = true;
+
+	//The first update happens behind the loading screen, so every cell is brought in at once and the player never sees the area fill in around them.
+	UpdateCells(PlayerLocation, false);
+}
+
+void UOPAreaStreamingSubsystem::WriteToSaveGame(UOPSaveGame* SaveGame, bool bOnlyDirty)
+{
+	if (!IsValid(SaveGame)) return;
+
+	//Barricades take damage without telling anyone, so the ones that are loaded are checked for changes first.
+	for (const TPair<TObjectKey<AActor>, TPair<FIntPoint, int32>>& Index : ActorRecordLookup)
+	{
+		FOPStreamingCell* Cell = Cells.Find(Index.Value.Key);
+
+		if (Cell) UpdateRecord(Index.Value.Key, *Cell, Index.Value.Value);
+	}
+
+	if (bOnlyDirty)
+	{
+		//Dirty records are written as they are now, even if they went back to how they were generated, so that they replace whatever was saved for them before.
+		for (const TPair<FIntPoint, int32>& Index : DirtyRecords)
+		{
+			const FOPStreamingCell* Cell = Cells.Find(Index.Key);
+
+			if (!Cell || !Cell->ActorRecords.IsValidIndex(Index.Value)) continue;
+
+			FSavedCellActor& SavedActor = SaveGame->CellActors.AddDefaulted_GetRef();
+			SavedActor.Cell = Index.Key;
+			SavedActor.RecordIndex = Index.Value;
+			SavedActor.bIsConsumed = Cell->ActorRecords[Index.Value].bIsConsumed;
+			SavedActor.ChunkHealth = Cell->ActorRecords[Index.Value].ChunkHealth;
+		}
+
+		return;
+	}
+
+	//A full save only needs the objects that differ from how they were generated. Everything else is generated again from the seed.
+	for (const TPair<FIntPoint, FOPStreamingCell>& Index : Cells)
+	{
+		for (int32 i = 0; i < Index.Value.ActorRecords.Num(); i++)
+		{
+			const FOPCellActor& Record = Index.Value.ActorRecords[i];
+
+			if (!Record.bIsConsumed && Record.ChunkHealth.IsEmpty()) continue;
+
+			FSavedCellActor& SavedActor = SaveGame->CellActors.AddDefaulted_GetRef();
+			SavedActor.Cell = Index.Key;
+			SavedActor.RecordIndex = i;
+			SavedActor.bIsConsumed = Record.bIsConsumed;
+			SavedActor.ChunkHealth = Record.ChunkHealth;
+		}
+	}
+}
+
+void UOPAreaStreamingSubsystem::ReadFromSaveGame(const UOPSaveGame* SaveGame)
+{
+	if (!IsValid(SaveGame)) return;
+
+	for (const FSavedCellActor& Index : SaveGame->CellActors)
+	{
+		FOPStreamingCell* Cell = Cells.Find(Index.Cell);
+
+		if (!Cell || !Cell->ActorRecords.IsValidIndex(Index.RecordIndex)) continue;
+
+		FOPCellActor& Record = Cell->ActorRecords[Index.RecordIndex];
+		Record.bIsConsumed = Index.bIsConsumed;
+		Record.ChunkHealth = Index.ChunkHealth;
+
+		//Records only reach the world once their cell is loaded again, unless the object is already loaded.
+		if (!Cell->Actors.IsValidIndex(Index.RecordIndex) || !IsValid(Cell->Actors[Index.RecordIndex])) continue;
+
+		TObjectPtr<AActor> Actor = Cell->Actors[Index.RecordIndex];
+
+		if (Record.bIsConsumed)
+		{
+			//The object is removed the same way streaming removes it, so that it doesn't count as being used up a second time.
+			Actor->OnDestroyed.RemoveDynamic(this, &UOPAreaStreamingSubsystem::OnCellActorDestroyed);
+			ActorRecordLookup.Remove(Actor.Get());
+
+			if (IsValid(WorldSubsystem)) WorldSubsystem->UnregisterInteractable(Actor);
+
+			Actor->Destroy();
+			Cell->Actors[Index.RecordIndex] = nullptr;
+			LoadedActors--;
+			continue;
+		}
+
+		TObjectPtr<AOPBarricade> Barricade = Cast<AOPBarricade>(Actor);
+
+		if (IsValid(Barricade) && Record.ChunkHealth.Num() > 0) Barricade->SetPackedChunkHealth(Record.ChunkHealth);
+	}
+
+	//The area now matches the save game, so nothing has changed since it was written.
+	ClearDirtyRecords();
+}
+
+void UOPAreaStreamingSubsystem::ClearDirtyRecords()
+{
+	DirtyRecords.Reset();
+}
+
+ECellDetail UOPAreaStreamingSubsystem::GetCellDetail(FVector Location) const
+{
+	const FOPStreamingCell* Cell = Cells.Find(GetCellCoordinates(Location));
+
+	return Cell ? Cell->Detail : ECellDetail::Unloaded;
+}
+
+FIntPoint UOPAreaStreamingSubsystem::GetCellCoordinates(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+FOPStreamingCell& UOPAreaStreamingSubsystem::FindOrAddCell(const FVector& Location)
+{
+	const FIntPoint CellCoordinates = GetCellCoordinates(Location);
+
+	if (FOPStreamingCell* Existing = Cells.Find(CellCoordinates)) return *Existing;
+
+	FOPStreamingCell& NewCell = Cells.Emplace(CellCoordinates);
+	NewCell.Bounds = FBox2D(FVector2D(CellCoordinates) * CellSize, FVector2D(CellCoordinates + FIntPoint(1, 1)) * CellSize);
+
+	return NewCell;
+}
+
+ECellDetail UOPAreaStreamingSubsystem::GetTargetDetail(const FIntPoint& CellCoordinates, const FOPStreamingCell& Cell, const FVector& PlayerLocation, const FVector& OutpostLocation) const
+{
+	//The outpost is where the fighting happens, so its cell is always fully loaded.
+	if (CellCoordinates == GetCellCoordinates(OutpostLocation)) return ECellDetail::Full;
+
+	const float DistanceSquared = Cell.Bounds.ComputeSquaredDistanceToPoint(FVector2D(PlayerLocation));
+
+	if (DistanceSquared <= FMath::Square(FullDetailDistance)) return ECellDetail::Full;
+
+	//Enemies arrive from spawn zones, so their cells keep their collision even when they are far away.
+	if (DistanceSquared <= FMath::Square(ProxyDistance) || Cell.SpawnZones.Num() > 0) return ECellDetail::Proxy;
+
+	return ECellDetail::Unloaded;
+}
+
+void UOPAreaStreamingSubsystem::UpdateCells(const FVector& PlayerLocation, bool bUseBudget)
+{
+	if (Cells.IsEmpty()) return;
+
+	const FVector OutpostLocation = IsValid(WorldSubsystem) ? WorldSubsystem->OutpostLocation : PlayerLocation;
+
+	//There are only ever a few hundred cells, so every one of them is checked each frame. Only the ones that need to change are touched.
+	PendingChanges.Reset();
+
+	for (const TPair<FIntPoint, FOPStreamingCell>& Index : Cells)
+	{
+		const ECellDetail TargetDetail = GetTargetDetail(Index.Key, Index.Value, PlayerLocation, OutpostLocation);
+
+		if (TargetDetail != Index.Value.Detail) PendingChanges.Emplace(Index.Key, TargetDetail, Index.Value.Bounds.ComputeSquaredDistanceToPoint(FVector2D(PlayerLocation)));
+	}
+
+	if (PendingChanges.IsEmpty()) return;
+
+	//The cells closest to the player are changed first, so that whatever the player can see or touch is never waiting behind cells that are far away.
+	PendingChanges.Sort([](const TTuple<FIntPoint, ECellDetail, float>& A, const TTuple<FIntPoint, ECellDetail, float>& B) { return A.Get<2>() < B.Get<2>(); });
+
+	const double FrameStartTime = FPlatformTime::Seconds();
+
+	for (int32 i = 0; i < PendingChanges.Num(); i++)
+	{
+		//At least one cell changes every frame, so that streaming always makes progress.
+		if (bUseBudget && i > 0 && (FPlatformTime::Seconds() - FrameStartTime) * 1000.0 > StreamingBudgetMs) break;
+
+		const FIntPoint CellCoordinates = PendingChanges[i].Get<0>();
+
+		SetCellDetail(CellCoordinates, Cells[CellCoordinates], PendingChanges[i].Get<1>());
+	}
+}
+
+void UOPAreaStreamingSubsystem::SetCellDetail(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell, ECellDetail NewDetail)
+{
+	if (Cell.Detail == NewDetail) return;
+
+	if (Cell.Detail == ECellDetail::Full) FullCells--;
+	if (Cell.Detail == ECellDetail::Proxy) ProxyCells--;
+
+	switch (NewDetail)
+	{
+	case ECellDetail::Full:
+		LoadComponents(Cell);
+		LoadActors(CellCoordinates, Cell);
+		FullCells++;
+		break;
+	case ECellDetail::Proxy:
+		UnloadActors(CellCoordinates, Cell);
+		LoadComponents(Cell);
+		ProxyCells++;
+		break;
+	default:
+		UnloadActors(CellCoordinates, Cell);
+		UnloadComponents(Cell);
+		break;
+	}
+
+	Cell.Detail = NewDetail;
+
+	//Proxies are always drawn with their lowest level of detail.
+	for (int32 i = 0; i < Cell.Components.Num(); i++)
+	{
+		if (IsValid(Cell.Components[i])) Cell.Components[i]->SetForcedLodModel(NewDetail == ECellDetail::Proxy ? Cell.Batches[i].Mesh->GetNumLODs() : 0);
+	}
+}
+
+void UOPAreaStreamingSubsystem::LoadComponents(FOPStreamingCell& Cell)
+{
+	if (Cell.Components.Num() > 0) return;
+
+	TObjectPtr<AActor> Owner = GetCellOwner();
+
+	if (!IsValid(Owner)) return;
+
+	//Each batch gets its own hierarchical component, so whole cells are culled at once and the number of components only grows with the number of loaded cells.
+	for (const FOPInstanceBatch& Batch : Cell.Batches)
+	{
+		TObjectPtr<UHierarchicalInstancedStaticMeshComponent> Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner);
+		Instances->SetStaticMesh(Batch.Mesh);
+
+		if (IsValid(Batch.Material))
+		{
+			for (int32 i = 0; i < Batch.Mesh->GetStaticMaterials().Num(); i++)
+			{
+				Instances->SetMaterial(i, Batch.Material);
+			}
+		}
+
+		Instances->SetCullDistances(0, FMath::RoundToInt32(Batch.CullDistance));
+		Instances->SetCollisionEnabled(Batch.bHasCollision ? ECollisionEnabled::QueryAndPhysics : ECollisionEnabled::NoCollision);
+		Instances->SetCanEverAffectNavigation(Batch.bHasCollision);
+		Instances->SetupAttachment(Owner->GetRootComponent());
+		Instances->RegisterComponent();
+		Instances->AddInstances(Batch.Transforms, false, true);
+
+		Cell.Components.Emplace(Instances);
+	}
+
+	LoadedComponents += Cell.Components.Num();
+}
+
+void UOPAreaStreamingSubsystem::UnloadComponents(FOPStreamingCell& Cell)
+{
+	for (TObjectPtr<UHierarchicalInstancedStaticMeshComponent> Index : Cell.Components)
+	{
+		if (IsValid(Index)) Index->DestroyComponent();
+	}
+
+	LoadedComponents -= Cell.Components.Num();
+	Cell.Components.Reset();
+}
+
+void UOPAreaStreamingSubsystem::LoadActors(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell)
+{
+	if (Cell.Actors.Num() > 0) return;
+
+	Cell.Actors.SetNum(Cell.ActorRecords.Num());
+
+	for (int32 i = 0; i < Cell.ActorRecords.Num(); i++)
+	{
+		const FOPCellActor& Record = Cell.ActorRecords[i];
+
+		//Objects that were used up the last time the cell was loaded stay gone.
+		if (Record.bIsConsumed) continue;
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TObjectPtr<AActor> NewActor = GetWorld()->SpawnActor<AActor>(Record.ActorClass, Record.Transform, SpawnParams);
+
+		if (!IsValid(NewActor)) continue;
+
+		TObjectPtr<AOPBarricade> Barricade = Cast<AOPBarricade>(NewActor);
+
+		if (IsValid(Barricade) && Record.ChunkHealth.Num() > 0) Barricade->SetPackedChunkHealth(Record.ChunkHealth);
+
+		NewActor->OnDestroyed.AddDynamic(this, &UOPAreaStreamingSubsystem::OnCellActorDestroyed);
+		ActorRecordLookup.Emplace(NewActor.Get(), TPair<FIntPoint, int32>(CellCoordinates, i));
+
+		//Gameplay objects are kept separate from the batches because gameplay needs to find them.
+		if (IsValid(WorldSubsystem)) WorldSubsystem->RegisterInteractable(NewActor);
+
+		Cell.Actors[i] = NewActor;
+		LoadedActors++;
+	}
+}
+
+void UOPAreaStreamingSubsystem::UnloadActors(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell)
+{
+	for (int32 i = 0; i < Cell.Actors.Num(); i++)
+	{
+		TObjectPtr<AActor> Actor = Cell.Actors[i];
+
+		if (!IsValid(Actor)) continue;
+
+		UpdateRecord(CellCoordinates, Cell, i);
+
+		//The actor is forgotten about before it's destroyed, so that streaming it out doesn't count as it being used up.
+		Actor->OnDestroyed.RemoveDynamic(this, &UOPAreaStreamingSubsystem::OnCellActorDestroyed);
+		ActorRecordLookup.Remove(Actor.Get());
+
+		if (IsValid(WorldSubsystem)) WorldSubsystem->UnregisterInteractable(Actor);
+
+		Actor->Destroy();
+		LoadedActors--;
+	}
+
+	Cell.Actors.Reset();
+}
+
+void UOPAreaStreamingSubsystem::UpdateRecord(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell, int32 RecordIndex)
+{
+	if (!Cell.Actors.IsValidIndex(RecordIndex) || !Cell.ActorRecords.IsValidIndex(RecordIndex)) return;
+
+	//Only the little that can change about an object is recorded. Everything else comes from its class when the cell is loaded again.
+	TObjectPtr<AOPBarricade> Barricade = Cast<AOPBarricade>(Cell.Actors[RecordIndex]);
+
+	if (!IsValid(Barricade)) return;
+
+	TArray<uint8> ChunkHealth;
+	Barricade->GetPackedChunkHealth(ChunkHealth);
+
+	//A barricade at full health is recorded as intact, so that it isn't written to every save.
+	if (!ChunkHealth.ContainsByPredicate([](uint8 Health) { return Health < MAX_uint8; })) ChunkHealth.Reset();
+
+	FOPCellActor& Record = Cell.ActorRecords[RecordIndex];
+
+	if (Record.ChunkHealth == ChunkHealth) return;
+
+	Record.ChunkHealth = MoveTemp(ChunkHealth);
+	DirtyRecords.Emplace(CellCoordinates, RecordIndex);
+}
+
+void UOPAreaStreamingSubsystem::OnCellActorDestroyed(AActor* DestroyedActor)
+{
+	TPair<FIntPoint, int32> RecordLocation;
+
+	if (!ActorRecordLookup.RemoveAndCopyValue(DestroyedActor, RecordLocation)) return;
+
+	if (IsValid(WorldSubsystem)) WorldSubsystem->UnregisterInteractable(DestroyedActor);
+
+	FOPStreamingCell* Cell = Cells.Find(RecordLocation.Key);
+
+	if (!Cell || !Cell->ActorRecords.IsValidIndex(RecordLocation.Value)) return;
+
+	Cell->ActorRecords[RecordLocation.Value].bIsConsumed = true;
+	DirtyRecords.Emplace(RecordLocation);
+	Cell->Actors[RecordLocation.Value] = nullptr;
+	LoadedActors--;
+}
+
+AActor* UOPAreaStreamingSubsystem::GetCellOwner()
+{
+	if (IsValid(CellOwner)) return CellOwner;
+
+	//All cells share a single owning actor, so the actor count stays the same no matter how much of the area is loaded.
+	CellOwner = UOPWorldSubsystem::SpawnComponentOwner(GetWorld(), TEXT("OPGeneratedArea"));
+
+	return CellOwner;
+}
\ No newline at end of file
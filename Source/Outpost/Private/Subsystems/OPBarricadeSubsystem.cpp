@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPBarricadeSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+
+void UOPBarricadeSubsystem::Deinitialize()
+{
+	MeshInstances.Empty();
+	BarricadeOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+int32 UOPBarricadeSubsystem::AddChunkInstance(UStaticMesh* Mesh, const FTransform& Transform)
+{
+	FOPBarricadeMeshInstances* Instances = GetMeshInstances(Mesh);
+
+	if (!Instances) return INDEX_NONE;
+
+	//A hidden instance is reused if there is one, so the instance count only grows with the most chunks ever shown at once.
+	if (Instances->FreeInstances.Num() > 0)
+	{
+		const int32 InstanceIndex = Instances->FreeInstances.Pop(false);
+		Instances->Instances->UpdateInstanceTransform(InstanceIndex, Transform, true, true);
+
+		return InstanceIndex;
+	}
+
+	return Instances->Instances->AddInstance(Transform, true);
+}
+
+void UOPBarricadeSubsystem::RemoveChunkInstance(UStaticMesh* Mesh, int32 InstanceIndex)
+{
+	FOPBarricadeMeshInstances* Instances = MeshInstances.Find(Mesh);
+
+	if (!Instances || !IsValid(Instances->Instances) || InstanceIndex == INDEX_NONE) return;
+
+	//Instances are hidden by scaling them down to nothing, rather than removed, so that no other instance's index changes.
+	Instances->Instances->UpdateInstanceTransform(InstanceIndex, FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), true, true);
+	Instances->FreeInstances.Emplace(InstanceIndex);
+}
+
+FOPBarricadeMeshInstances* UOPBarricadeSubsystem::GetMeshInstances(UStaticMesh* Mesh)
+{
+	if (!IsValid(Mesh)) return nullptr;
+
+	if (FOPBarricadeMeshInstances* Existing = MeshInstances.Find(Mesh)) return Existing;
+
+	//All chunk meshes share a single owning actor, which is spawned the first time that it's needed.
+	if (!IsValid(BarricadeOwner)) BarricadeOwner = UOPWorldSubsystem::SpawnComponentOwner(GetWorld(), TEXT("OPBarricadeOwner"));
+
+	if (!IsValid(BarricadeOwner)) return nullptr;
+
+	//Chunks are purely visual. Each barricade handles its own collision with a single box.
+	TObjectPtr<UInstancedStaticMeshComponent> Instances = NewObject<UInstancedStaticMeshComponent>(BarricadeOwner);
+	Instances->SetStaticMesh(Mesh);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCanEverAffectNavigation(false);
+	Instances->SetupAttachment(BarricadeOwner->GetRootComponent());
+	Instances->RegisterComponent();
+
+	FOPBarricadeMeshInstances& NewMeshInstances = MeshInstances.Emplace(Mesh);
+	NewMeshInstances.Instances = Instances;
+
+	return &NewMeshInstances;
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPCheckpointSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Subsystems/OPEnemyPoolSubsystem.h"
+#include "Subsystems/OPCrowdSubsystem.h"
+#include "Subsystems/OPLootSubsystem.h"
+#include "Subsystems/OPPerceptionSubsystem.h"
+#include "Subsystems/OPEconomySubsystem.h"
+#include "Data/OPSaveGame.h"
+#include "Characters/OPEnemy.h"
+#include "Characters/OPPlayer.h"
+#include "Items/OPWeapon.h"
+#include "OutpostGameModeBase.h"
+#include "Outpost.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//"OPCP". Checkpoints are written through the save game's slots, so this keeps LoadCheckpoint from accepting a save game.
+static constexpr uint32 CheckpointMagic = 0x4F504350;
+
+void UOPCheckpointSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+	EnemyPool = Collection.InitializeDependency<UOPEnemyPoolSubsystem>();
+	Crowd = Collection.InitializeDependency<UOPCrowdSubsystem>();
+	Loot = Collection.InitializeDependency<UOPLootSubsystem>();
+	Perception = Collection.InitializeDependency<UOPPerceptionSubsystem>();
+	Economy = Collection.InitializeDependency<UOPEconomySubsystem>();
+}
+
+void UOPCheckpointSubsystem::Deinitialize()
+{
+	ClearCheckpoint();
+
+	Super::Deinitialize();
+}
+
+bool UOPCheckpointSubsystem::CaptureCheckpoint(const FString& SlotName)
+{
+	AOutpostGameModeBase* GameMode;
+	AOPPlayer* Player;
+
+	if (!GetCheckpointActors(GameMode, Player) || !GameMode->IsWaveInProgress()) return false;
+
+	const double CaptureStartTime = FPlatformTime::Seconds();
+
+	//Everything is copied into the checkpoint's arrays in one pass. The only state it changes is the economy's ledger, which is flushed so the captured balance is up to date.
+	Checkpoint.Reset();
+
+	GameMode->WriteToCheckpoint(Checkpoint);
+	WritePlayer(Player);
+	WriteEnemies();
+
+	if (IsValid(Crowd)) Crowd->WriteToCheckpoint(Checkpoint);
+	if (IsValid(Loot)) Loot->WriteToCheckpoint(Checkpoint);
+
+	bHasCheckpoint = true;
+	LastEnemyCount = Checkpoint.EnemyClasses.Num() + Checkpoint.CrowdClasses.Num();
+
+	TObjectPtr<UOPSaveSubsystem> SaveSubsystem = GetSaveSubsystem();
+
+	if (!SlotName.IsEmpty() && IsValid(SaveSubsystem))
+	{
+		FOPPendingSave PendingSave;
+		PendingSave.SlotName = SlotName;
+		PendingSave.Magic = CheckpointMagic;
+		PendingSave.Version = static_cast<int32>(EOPCheckpointVersion::Latest);
+
+		FMemoryWriter Writer(PendingSave.Bytes);
+		Checkpoint.Serialize(Writer, EOPCheckpointVersion::Latest);
+
+		LastCheckpointSize = PendingSave.Bytes.Num();
+
+		SaveSubsystem->WriteSlot(MoveTemp(PendingSave));
+	}
+
+	LastCaptureMs = (FPlatformTime::Seconds() - CaptureStartTime) * 1000.0;
+
+	return true;
+}
+
+bool UOPCheckpointSubsystem::RestoreCheckpoint()
+{
+	AOutpostGameModeBase* GameMode;
+	AOPPlayer* Player;
+
+	if (!bHasCheckpoint || !GetCheckpointActors(GameMode, Player) || !GameMode->CanRestoreCheckpoint(Checkpoint)) return false;
+
+	const double RestoreStartTime = FPlatformTime::Seconds();
+
+	//Every enemy briefly leaves play while the level is reset, which would otherwise count as clearing the wave.
+	GameMode->SetWaveHeld(true);
+
+	ReadPlayer(Player);
+	ReadEnemies();
+
+	if (IsValid(Crowd)) Crowd->ReadFromCheckpoint(Checkpoint);
+	if (IsValid(Loot)) Loot->ReadFromCheckpoint(Checkpoint);
+
+	GameMode->ReadFromCheckpoint(Checkpoint);
+	GameMode->SetWaveHeld(false);
+
+	LastRestoreMs = (FPlatformTime::Seconds() - RestoreStartTime) * 1000.0;
+
+	return true;
+}
+
+bool UOPCheckpointSubsystem::LoadCheckpoint(const FString& SlotName)
+{
+	TObjectPtr<UOPSaveSubsystem> SaveSubsystem = GetSaveSubsystem();
+
+	if (!IsValid(SaveSubsystem)) return false;
+
+	return SaveSubsystem->ReadSlot(SlotName, CheckpointMagic, static_cast<int32>(EOPCheckpointVersion::Latest), FOPSlotReadDelegate::CreateUObject(this, &UOPCheckpointSubsystem::OnCheckpointRead, SlotName));
+}
+
+void UOPCheckpointSubsystem::ClearCheckpoint()
+{
+	Checkpoint.Reset();
+	bHasCheckpoint = false;
+}
+
+UOPSaveSubsystem* UOPCheckpointSubsystem::GetSaveSubsystem() const
+{
+	const UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+
+	return IsValid(GameInstance) ? GameInstance->GetSubsystem<UOPSaveSubsystem>() : nullptr;
+}
+
+bool UOPCheckpointSubsystem::GetCheckpointActors(AOutpostGameModeBase*& OutGameMode, AOPPlayer*& OutPlayer) const
+{
+	OutGameMode = Cast<AOutpostGameModeBase>(GetWorld()->GetAuthGameMode());
+	OutPlayer = Cast<AOPPlayer>(UGameplayStatics::GetPlayerCharacter(this, 0));
+
+	return IsValid(OutGameMode) && IsValid(OutPlayer) && !OutPlayer->IsCharacterDead();
+}
+
+void UOPCheckpointSubsystem::WritePlayer(AOPPlayer* Player)
+{
+	Checkpoint.PlayerLocation = Player->GetActorLocation();
+	Checkpoint.PlayerRotation = Player->GetControlRotation();
+
+	//The player's inventory and cash are packed the same way as a save game, so that both are always restored by the same code.
+	TObjectPtr<UOPSaveSubsystem> SaveSubsystem = GetSaveSubsystem();
+	TObjectPtr<UOPSaveGame> PlayerSave = IsValid(SaveSubsystem) ? SaveSubsystem->CaptureGameState() : nullptr;
+
+	if (!IsValid(PlayerSave)) return;
+
+	//The player's weapons are added to the asset table, so that restoring them never has to load anything mid-wave.
+	for (const FSavedWeapon& Index : PlayerSave->Weapons)
+	{
+		Checkpoint.FindOrAddAsset(Index.WeaponClass.Get());
+	}
+
+	Checkpoint.PlayerSaveVersion = static_cast<int32>(EOPSaveVersion::Latest);
+
+	FMemoryWriter Writer(Checkpoint.PlayerSave);
+	PlayerSave->SerializeSaveData(Writer, EOPSaveVersion::Latest);
+}
+
+void UOPCheckpointSubsystem::WriteEnemies()
+{
+	if (!IsValid(WorldSubsystem)) return;
+
+	for (TObjectPtr<AActor> Index : WorldSubsystem->EnemyArray)
+	{
+		TObjectPtr<AOPEnemy> Enemy = Cast<AOPEnemy>(Index);
+
+		if (!IsValid(Enemy) || Enemy->IsCharacterDead()) continue;
+
+		//Enemies that have never seen the player are marked with a negative time.
+		FVector LastKnownPlayerLocation = FVector::ZeroVector;
+		float TimeSinceSeen = -1.f;
+
+		if (IsValid(Perception)) Perception->GetLastKnownPlayerLocation(Enemy, LastKnownPlayerLocation, TimeSinceSeen);
+
+		TObjectPtr<AOPWeapon> Weapon = Enemy->GetCurrentWeapon();
+
+		Checkpoint.EnemyClasses.Emplace(Checkpoint.FindOrAddAsset(Enemy->GetClass()));
+		Checkpoint.EnemyLocations.Emplace(Enemy->GetActorLocation());
+		Checkpoint.EnemyYaws.Emplace(Enemy->GetActorRotation().Yaw);
+		Checkpoint.EnemyVelocities.Emplace(Enemy->GetVelocity());
+		Checkpoint.EnemyHealth.Emplace(Enemy->GetCurrentHealth());
+		Checkpoint.EnemyMagazines.Emplace(IsValid(Weapon) ? Weapon->Stats.CurrentMagazine : INDEX_NONE);
+		Checkpoint.EnemyLastKnownPlayerLocations.Emplace(LastKnownPlayerLocation);
+		Checkpoint.EnemyTimesSinceSeen.Emplace(TimeSinceSeen);
+	}
+}
+
+void UOPCheckpointSubsystem::ReadPlayer(AOPPlayer* Player)
+{
+	Player->TeleportTo(Checkpoint.PlayerLocation, FRotator(0.f, Checkpoint.PlayerRotation.Yaw, 0.f));
+	Player->GetCharacterMovement()->StopMovementImmediately();
+
+	if (IsValid(Player->GetController())) Player->GetController()->SetControlRotation(Checkpoint.PlayerRotation);
+
+	const bool bIsValidVersion = Checkpoint.PlayerSaveVersion >= static_cast<int32>(EOPSaveVersion::Initial) && Checkpoint.PlayerSaveVersion <= static_cast<int32>(EOPSaveVersion::Latest);
+
+	if (Checkpoint.PlayerSave.IsEmpty() || !bIsValidVersion) return;
+
+	TObjectPtr<UOPSaveGame> PlayerSave = NewObject<UOPSaveGame>(this);
+
+	FMemoryReader Reader(Checkpoint.PlayerSave);
+	PlayerSave->SerializeSaveData(Reader, static_cast<EOPSaveVersion>(Checkpoint.PlayerSaveVersion));
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("The player's state in the checkpoint is corrupted, so only their location was restored."));
+		return;
+	}
+
+	TArray<TSubclassOf<AOPWeapon>> WeaponClasses;
+	WeaponClasses.Reserve(PlayerSave->Weapons.Num());
+
+	for (const FSavedWeapon& Index : PlayerSave->Weapons)
+	{
+		WeaponClasses.Emplace(Cast<UClass>(Checkpoint.LoadAsset(Checkpoint.FindAsset(Index.WeaponClass.ToSoftObjectPath()))));
+	}
+
+	Player->ReadFromSaveGame(PlayerSave, WeaponClasses);
+
+	if (IsValid(Economy)) Economy->RestoreFromLog(PlayerSave->TransactionLog);
+}
+
+void UOPCheckpointSubsystem::ReadEnemies()
+{
+	if (!IsValid(EnemyPool)) return;
+
+	//Every enemy in play goes back to the pool first, so that the enemies in the checkpoint can reuse them.
+	if (IsValid(WorldSubsystem))
+	{
+		const TArray<TObjectPtr<AActor>> LiveEnemies = WorldSubsystem->EnemyArray;
+
+		for (TObjectPtr<AActor> Index : LiveEnemies)
+		{
+			EnemyPool->ReleaseEnemy(Cast<AOPEnemy>(Index));
+		}
+	}
+
+	for (int32 i = 0; i < Checkpoint.EnemyClasses.Num(); i++)
+	{
+		TSubclassOf<AOPEnemy> EnemyClass = Cast<UClass>(Checkpoint.LoadAsset(Checkpoint.EnemyClasses[i]));
+
+		if (!IsValid(EnemyClass)) continue;
+
+		TObjectPtr<AOPEnemy> Enemy = EnemyPool->AcquireEnemy(EnemyClass, FTransform(FRotator(0.f, Checkpoint.EnemyYaws[i], 0.f), Checkpoint.EnemyLocations[i]));
+
+		if (!IsValid(Enemy)) continue;
+
+		Enemy->SetCurrentHealth(Checkpoint.EnemyHealth[i]);
+		Enemy->GetCharacterMovement()->Velocity = Checkpoint.EnemyVelocities[i];
+
+		TObjectPtr<AOPWeapon> Weapon = Enemy->GetCurrentWeapon();
+
+		if (IsValid(Weapon) && Checkpoint.EnemyMagazines[i] != INDEX_NONE) Weapon->Stats.CurrentMagazine = FMath::Clamp(Checkpoint.EnemyMagazines[i], 0, Weapon->Stats.MaxMagazine);
+
+		if (IsValid(Perception) && Checkpoint.EnemyTimesSinceSeen[i] >= 0.f) Perception->RestoreLastKnownPlayerLocation(Enemy, Checkpoint.EnemyLastKnownPlayerLocations[i], Checkpoint.EnemyTimesSinceSeen[i]);
+	}
+}
+
+void UOPCheckpointSubsystem::OnCheckpointRead(const TArray<uint8>& Bytes, int32 Version, FString SlotName)
+{
+	if (Bytes.IsEmpty())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Could not read the checkpoint %s."), *SlotName);
+
+		OnCheckpointLoaded.Broadcast(SlotName, false);
+		return;
+	}
+
+	//The checkpoint is unpacked into a copy first, so that a corrupted one never replaces the checkpoint in memory.
+	FOPCheckpoint LoadedCheckpoint;
+
+	FMemoryReader Reader(Bytes);
+	LoadedCheckpoint.Serialize(Reader, static_cast<EOPCheckpointVersion>(Version));
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("The checkpoint %s is corrupted."), *SlotName);
+
+		OnCheckpointLoaded.Broadcast(SlotName, false);
+		return;
+	}
+
+	Checkpoint = MoveTemp(LoadedCheckpoint);
+	bHasCheckpoint = true;
+
+	OnCheckpointLoaded.Broadcast(SlotName, true);
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPCorpseSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Components/PoseableMeshComponent.h"
+
+void UOPCorpseSubsystem::Deinitialize()
+{
+	CorpsePool.Empty();
+	CorpseOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UOPCorpseSubsystem::BakeCorpse(USkeletalMeshComponent* SourceMesh)
+{
+	if (!IsValid(SourceMesh) || !IsValid(SourceMesh->GetSkinnedAsset()) || MaxCorpses <= 0) return false;
+
+	TObjectPtr<UPoseableMeshComponent> Corpse = GetNextCorpseComponent();
+
+	if (!IsValid(Corpse)) return false;
+
+	//Recycled corpses only need their mesh swapped out, if the new body uses a different one.
+	if (Corpse->GetSkinnedAsset() != SourceMesh->GetSkinnedAsset()) Corpse->SetSkinnedAssetAndUpdate(SourceMesh->GetSkinnedAsset(), true);
+
+	//Copy over any material overrides, so that corpses keep their damage materials.
+	for (int32 i = 0; i < SourceMesh->GetNumMaterials(); i++)
+	{
+		Corpse->SetMaterial(i, SourceMesh->GetMaterial(i));
+	}
+
+	//The corpse is moved to where the body came to rest, and its final pose is copied over exactly once.
+	Corpse->SetWorldTransform(SourceMesh->GetComponentTransform());
+	Corpse->CopyPoseFromSkeletalComponent(SourceMesh);
+	Corpse->SetVisibility(true);
+
+	CorpseCount = FMath::Min(CorpseCount + 1, CorpsePool.Num());
+
+	return true;
+}
+
+void UOPCorpseSubsystem::ClearAllCorpses()
+{
+	for (TObjectPtr<UPoseableMeshComponent> Index : CorpsePool)
+	{
+		if (IsValid(Index)) Index->SetVisibility(false);
+	}
+
+	NextCorpseIndex = 0;
+	CorpseCount = 0;
+}
+
+UPoseableMeshComponent* UOPCorpseSubsystem::GetNextCorpseComponent()
+{
+	//All corpses share a single owning actor, which is spawned the first time that it's needed.
+	if (!IsValid(CorpseOwner)) CorpseOwner = UOPWorldSubsystem::SpawnComponentOwner(GetWorld(), TEXT("OPCorpseOwner"));
+
+	if (!IsValid(CorpseOwner)) return nullptr;
+
+	//Once the pool is full, the oldest corpse is recycled for the newest one...
+	if (CorpsePool.Num() >= MaxCorpses)
+	{
+		TObjectPtr<UPoseableMeshComponent> Corpse = CorpsePool[NextCorpseIndex % CorpsePool.Num()];
+		NextCorpseIndex = (NextCorpseIndex + 1) % CorpsePool.Num();
+
+		return Corpse;
+	}
+
+	//...Otherwise, a new corpse component is created. Corpses never tick, and are purely visual.
+	TObjectPtr<UPoseableMeshComponent> Corpse = NewObject<UPoseableMeshComponent>(CorpseOwner);
+	Corpse->SetupAttachment(CorpseOwner->GetRootComponent());
+	Corpse->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Corpse->SetGenerateOverlapEvents(false);
+	Corpse->SetCanEverAffectNavigation(false);
+	Corpse->PrimaryComponentTick.bCanEverTick = false;
+	Corpse->SetUsingAbsoluteLocation(true);
+	Corpse->SetUsingAbsoluteRotation(true);
+	Corpse->SetUsingAbsoluteScale(true);
+	Corpse->RegisterComponent();
+
+	CorpsePool.Emplace(Corpse);
+	NextCorpseIndex = CorpsePool.Num() % FMath::Max(MaxCorpses, 1);
+
+	return Corpse;
+}
\ No newline at end of file
@@ -0,0 +1,320 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPCrowdSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Subsystems/OPEnemyPoolSubsystem.h"
+#include "Subsystems/OPFlowFieldSubsystem.h"
+#include "Characters/OPEnemy.h"
+#include "Data/OPCheckpoint.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Kismet/GameplayStatics.h"
+
+void UOPCrowdSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+	EnemyPool = Collection.InitializeDependency<UOPEnemyPoolSubsystem>();
+	FlowField = Collection.InitializeDependency<UOPFlowFieldSubsystem>();
+}
+
+void UOPCrowdSubsystem::Deinitialize()
+{
+	CrowdTypes.Empty();
+	CrowdOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UOPCrowdSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TObjectPtr<APawn> PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+
+	bHasPlayerLocation = IsValid(PlayerPawn);
+	if (bHasPlayerLocation) PlayerLocation = PlayerPawn->GetActorLocation();
+
+	MoveEntities(DeltaTime);
+	PromoteEntities();
+	DemoteEnemies();
+	UpdateInstances();
+}
+
+TStatId UOPCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPCrowdSubsystem, STATGROUP_Tickables);
+}
+
+void UOPCrowdSubsystem::SpawnEnemy(TSubclassOf<AOPEnemy> EnemyClass, const FTransform& SpawnTransform)
+{
+	if (!IsValid(EnemyClass)) return;
+
+	//Enemies without a crowd mesh can't be drawn as entities, and enemies that are already within range would be promoted right away anyway.
+	const bool bSpawnAsEntity = IsValid(EnemyClass.GetDefaultObject()->GetCrowdProxyMesh()) && !IsWithinRadius(SpawnTransform.GetLocation(), PromotionRadius);
+
+	if (bSpawnAsEntity)
+	{
+		AddEntity(EnemyClass, SpawnTransform.GetLocation(), EnemyClass.GetDefaultObject()->GetMaxHealth());
+	}
+	else if (IsValid(EnemyPool))
+	{
+		EnemyPool->AcquireEnemy(EnemyClass, SpawnTransform);
+	}
+	else
+	{
+		GetWorld()->SpawnActor<AOPEnemy>(EnemyClass, SpawnTransform);
+	}
+}
+
+int32 UOPCrowdSubsystem::GetEntityCount() const
+{
+	int32 EntityCount = 0;
+
+	for (const FOPCrowdType& Index : CrowdTypes)
+	{
+		EntityCount += Index.Locations.Num();
+	}
+
+	return EntityCount;
+}
+
+void UOPCrowdSubsystem::ClearAllEntities()
+{
+	for (FOPCrowdType& Index : CrowdTypes)
+	{
+		Index.Locations.Reset();
+		Index.Directions.Reset();
+		Index.Health.Reset();
+
+		if (IsValid(Index.Instances)) Index.Instances->ClearInstances();
+	}
+}
+
+void UOPCrowdSubsystem::WriteToCheckpoint(FOPCheckpoint& Checkpoint) const
+{
+	for (const FOPCrowdType& CrowdType : CrowdTypes)
+	{
+		const int32 EntityCount = CrowdType.Locations.Num();
+
+		if (EntityCount <= 0) continue;
+
+		const int32 ClassIndex = Checkpoint.FindOrAddAsset(CrowdType.EnemyClass);
+		const int32 FirstEntity = Checkpoint.CrowdClasses.AddUninitialized(EntityCount);
+
+		for (int32 i = 0; i < EntityCount; i++)
+		{
+			Checkpoint.CrowdClasses[FirstEntity + i] = ClassIndex;
+		}
+
+		Checkpoint.CrowdLocations.Append(CrowdType.Locations);
+		Checkpoint.CrowdDirections.Append(CrowdType.Directions);
+		Checkpoint.CrowdHealth.Append(CrowdType.Health);
+	}
+}
+
+void UOPCrowdSubsystem::ReadFromCheckpoint(const FOPCheckpoint& Checkpoint)
+{
+	ClearAllEntities();
+
+	for (int32 i = 0; i < Checkpoint.CrowdClasses.Num(); i++)
+	{
+		TSubclassOf<AOPEnemy> EnemyClass = Cast<UClass>(Checkpoint.LoadAsset(Checkpoint.CrowdClasses[i]));
+
+		if (!IsValid(EnemyClass)) continue;
+
+		const int32 EntityIndex = AddEntity(EnemyClass, Checkpoint.CrowdLocations[i], Checkpoint.CrowdHealth[i]);
+
+		if (EntityIndex != INDEX_NONE) FindOrAddCrowdType(EnemyClass)->Directions[EntityIndex] = Checkpoint.CrowdDirections[i];
+	}
+}
+
+void UOPCrowdSubsystem::MoveEntities(float DeltaTime)
+{
+	const int32 OutpostGoal = IsValid(FlowField) ? FlowField->GetOutpostGoal() : INDEX_NONE;
+	const FVector OutpostLocation = IsValid(WorldSubsystem) ? WorldSubsystem->OutpostLocation : FVector::ZeroVector;
+
+	for (FOPCrowdType& CrowdType : CrowdTypes)
+	{
+		for (int32 i = 0; i < CrowdType.Locations.Num(); i++)
+		{
+			FVector& Location = CrowdType.Locations[i];
+
+			//Entities that are waiting to be promoted hold their position, rather than walking in as ghosts.
+			if (IsWithinRadius(Location, PromotionRadius)) continue;
+
+			//Every entity shares the outpost's flow field. If it has no answer, then the entity heads straight for the outpost.
+			FVector Direction = IsValid(FlowField) ? FlowField->GetFlowDirection(Location, OutpostGoal) : FVector::ZeroVector;
+
+			if (Direction.IsNearlyZero()) Direction = (OutpostLocation - Location).GetSafeNormal2D();
+
+			CrowdType.Directions[i] = Direction;
+			Location += Direction * CrowdType.MoveSpeed * DeltaTime;
+
+			//Entities stick to the navmesh height that the flow field found, instead of tracing for the ground.
+			float GroundHeight;
+
+			if (IsValid(FlowField) && FlowField->GetGroundHeight(Location, GroundHeight)) Location.Z = GroundHeight + CrowdType.HalfHeight;
+		}
+	}
+}
+
+void UOPCrowdSubsystem::PromoteEntities()
+{
+	if (!IsValid(WorldSubsystem)) return;
+
+	int32 PromotionsThisFrame = 0;
+
+	for (FOPCrowdType& CrowdType : CrowdTypes)
+	{
+		for (int32 i = CrowdType.Locations.Num() - 1; i >= 0; i--)
+		{
+			if (PromotionsThisFrame >= MaxPromotionsPerFrame || WorldSubsystem->EnemyArray.Num() >= MaxPromotedEnemies) return;
+
+			if (!IsWithinRadius(CrowdType.Locations[i], PromotionRadius)) continue;
+
+			PromoteEntity(CrowdType, i);
+			PromotionsThisFrame++;
+		}
+	}
+}
+
+void UOPCrowdSubsystem::DemoteEnemies()
+{
+	if (!IsValid(WorldSubsystem) || !IsValid(EnemyPool)) return;
+
+	int32 DemotionsThisFrame = 0;
+
+	//Demoting an enemy removes it from the enemy array, so a copy is looped over instead.
+	const TArray<TObjectPtr<AActor>> Enemies = WorldSubsystem->EnemyArray;
+
+	for (TObjectPtr<AActor> Index : Enemies)
+	{
+		if (DemotionsThisFrame >= MaxPromotionsPerFrame) return;
+
+		TObjectPtr<AOPEnemy> Enemy = Cast<AOPEnemy>(Index);
+
+		if (!IsValid(Enemy) || !Enemy->ShouldFollowFlowField() || !IsValid(Enemy->GetCrowdProxyMesh())) continue;
+		if (IsWithinRadius(Enemy->GetActorLocation(), DemotionRadius)) continue;
+
+		//The entity is added before the enemy is released, so that the wave never looks cleared in between.
+		AddEntity(Enemy->GetClass(), Enemy->GetActorLocation(), Enemy->GetCurrentHealth());
+		EnemyPool->ReleaseEnemy(Enemy);
+
+		DemotionsThisFrame++;
+		TotalDemotions++;
+	}
+}
+
+void UOPCrowdSubsystem::UpdateInstances()
+{
+	TArray<FTransform> InstanceTransforms;
+
+	for (FOPCrowdType& CrowdType : CrowdTypes)
+	{
+		if (!IsValid(CrowdType.Instances)) continue;
+
+		InstanceTransforms.Reset(CrowdType.Locations.Num());
+
+		for (int32 i = 0; i < CrowdType.Locations.Num(); i++)
+		{
+			InstanceTransforms.Emplace(FTransform(CrowdType.Directions[i].Rotation(), CrowdType.Locations[i] - FVector(0.f, 0.f, CrowdType.HalfHeight)));
+		}
+
+		//Instances are only ever added or removed at the end, so the rest can be updated in a single batch.
+		const int32 InstanceCount = CrowdType.Instances->GetInstanceCount();
+
+		if (InstanceCount > InstanceTransforms.Num())
+		{
+			TArray<int32> InstancesToRemove;
+
+			for (int32 i = InstanceTransforms.Num(); i < InstanceCount; i++)
+			{
+				InstancesToRemove.Emplace(i);
+			}
+
+			CrowdType.Instances->RemoveInstances(InstancesToRemove);
+		}
+		else if (InstanceCount < InstanceTransforms.Num())
+		{
+			CrowdType.Instances->AddInstances(TArray<FTransform>(InstanceTransforms.GetData() + InstanceCount, InstanceTransforms.Num() - InstanceCount), false, true);
+		}
+
+		if (InstanceTransforms.Num() > 0) CrowdType.Instances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+	}
+}
+
+bool UOPCrowdSubsystem::IsWithinRadius(const FVector& Location, float Radius) const
+{
+	const float RadiusSquared = FMath::Square(Radius);
+
+	if (bHasPlayerLocation && FVector::DistSquared2D(Location, PlayerLocation) <= RadiusSquared) return true;
+
+	return IsValid(WorldSubsystem) && FVector::DistSquared2D(Location, WorldSubsystem->OutpostLocation) <= RadiusSquared;
+}
+
+int32 UOPCrowdSubsystem::AddEntity(TSubclassOf<AOPEnemy> EnemyClass, const FVector& Location, int32 Health)
+{
+	FOPCrowdType* CrowdType = FindOrAddCrowdType(EnemyClass);
+
+	if (!CrowdType) return INDEX_NONE;
+
+	CrowdType->Directions.Emplace(FVector::ForwardVector);
+	CrowdType->Health.Emplace(Health);
+
+	return CrowdType->Locations.Emplace(Location);
+}
+
+AOPEnemy* UOPCrowdSubsystem::PromoteEntity(FOPCrowdType& CrowdType, int32 EntityIndex)
+{
+	const FTransform SpawnTransform = FTransform(CrowdType.Directions[EntityIndex].Rotation(), CrowdType.Locations[EntityIndex]);
+
+	TObjectPtr<AOPEnemy> Enemy = IsValid(EnemyPool) ? EnemyPool->AcquireEnemy(CrowdType.EnemyClass, SpawnTransform) : GetWorld()->SpawnActor<AOPEnemy>(CrowdType.EnemyClass, SpawnTransform);
+
+	//Entities keep any damage that they took as real enemies, before they were demoted.
+	if (IsValid(Enemy)) Enemy->SetCurrentHealth(CrowdType.Health[EntityIndex]);
+
+	CrowdType.Locations.RemoveAtSwap(EntityIndex);
+	CrowdType.Directions.RemoveAtSwap(EntityIndex);
+	CrowdType.Health.RemoveAtSwap(EntityIndex);
+
+	TotalPromotions++;
+
+	return Enemy;
+}
+
+FOPCrowdType* UOPCrowdSubsystem::FindOrAddCrowdType(TSubclassOf<AOPEnemy> EnemyClass)
+{
+	if (!IsValid(EnemyClass)) return nullptr;
+
+	FOPCrowdType* CrowdType = CrowdTypes.FindByPredicate([EnemyClass](const FOPCrowdType& Index) {return Index.EnemyClass == EnemyClass;});
+
+	if (CrowdType) return CrowdType;
+
+	TObjectPtr<AOPEnemy> EnemyDefaults = EnemyClass.GetDefaultObject();
+
+	if (!IsValid(EnemyDefaults->GetCrowdProxyMesh())) return nullptr;
+
+	//All instanced meshes share a single owning actor, which is spawned the first time that it's needed.
+	if (!IsValid(CrowdOwner)) CrowdOwner = UOPWorldSubsystem::SpawnComponentOwner(GetWorld(), TEXT("OPCrowdOwner"));
+
+	if (!IsValid(CrowdOwner)) return nullptr;
+
+	//Entities are purely visual. They don't collide, cast shadows, or take damage until they're promoted.
+	TObjectPtr<UInstancedStaticMeshComponent> Instances = NewObject<UInstancedStaticMeshComponent>(CrowdOwner);
+	Instances->SetStaticMesh(EnemyDefaults->GetCrowdProxyMesh());
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCastShadow(false);
+	Instances->SetupAttachment(CrowdOwner->GetRootComponent());
+	Instances->RegisterComponent();
+
+	FOPCrowdType& NewCrowdType = CrowdTypes.AddDefaulted_GetRef();
+	NewCrowdType.EnemyClass = EnemyClass;
+	NewCrowdType.Instances = Instances;
+	NewCrowdType.MoveSpeed = EnemyDefaults->GetCharacterMovement()->MaxWalkSpeed;
+	NewCrowdType.HalfHeight = EnemyDefaults->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+
+	return &NewCrowdType;
+}
\ No newline at end of file
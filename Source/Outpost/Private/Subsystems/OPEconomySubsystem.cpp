@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPEconomySubsystem.h"
+
+void UOPEconomySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ResetEconomy();
+}
+
+void UOPEconomySubsystem::Deinitialize()
+{
+	Ledger.Empty();
+	TransactionLog.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPEconomySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	FlushLedger();
+
+	//The HUD is only told about the balance once per frame, no matter how many transactions were applied.
+	if (FirstUnbroadcastTransaction >= TransactionLog.Num()) return;
+
+	TArray<FEconomyTransaction> NewTransactions(TransactionLog.GetData() + FirstUnbroadcastTransaction, TransactionLog.Num() - FirstUnbroadcastTransaction);
+	FirstUnbroadcastTransaction = TransactionLog.Num();
+
+	OnBalanceUpdated.Broadcast(Balance, NewTransactions);
+}
+
+TStatId UOPEconomySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPEconomySubsystem, STATGROUP_Tickables);
+}
+
+void UOPEconomySubsystem::RecordKill(const UObject* Source, EHitZone HitZone)
+{
+	FOPLedgerEntry& Entry = RecordEvent(EEconomyEvent::Kill, Source);
+	Entry.Amount += KillReward;
+
+	if (HitZone == EHitZone::Head)
+	{
+		Entry.Headshots++;
+		Entry.Amount += HeadshotBonus;
+	}
+}
+
+void UOPEconomySubsystem::RecordDamageTaken(float Damage)
+{
+	if (Damage <= 0.f) return;
+
+	bTookDamageThisWave = true;
+
+	const int32 Penalty = FMath::RoundToInt(Damage * DamagePenaltyPerPoint);
+
+	if (Penalty > 0) RecordEvent(EEconomyEvent::DamageTaken, nullptr).Amount -= Penalty;
+}
+
+void UOPEconomySubsystem::RecordWaveStarted(int32 WaveIndex)
+{
+	//Anything earned before the wave started belongs to the previous wave.
+	FlushLedger();
+
+	CurrentWaveIndex = WaveIndex;
+	bTookDamageThisWave = false;
+}
+
+void UOPEconomySubsystem::RecordWaveCleared(int32 WaveIndex)
+{
+	RecordEvent(EEconomyEvent::WaveCleared, nullptr).Amount += WaveClearedReward;
+
+	if (!bTookDamageThisWave) RecordEvent(EEconomyEvent::NoDamageBonus, nullptr).Amount += NoDamageBonus;
+}
+
+bool UOPEconomySubsystem::SpendCash(int32 Cost)
+{
+	//Pending rewards are applied first, so that the purchase is checked against cash that is actually in the balance.
+	FlushLedger();
+
+	if (Cost < 0 || Balance < Cost) return false;
+
+	ApplyTransaction(EEconomyEvent::Purchase, 1, 0, -Cost);
+
+	return true;
+}
+
+void UOPEconomySubsystem::RefundCash(int32 Amount)
+{
+	if (Amount <= 0) return;
+
+	ApplyTransaction(EEconomyEvent::Refund, 1, 0, Amount);
+}
+
+void UOPEconomySubsystem::FlushLedger()
+{
+	if (Ledger.IsEmpty()) return;
+
+	//Entries are applied in the order that they were first recorded, so the same events always produce the same log.
+	for (const FOPLedgerEntry& Index : Ledger)
+	{
+		int32 Amount = Index.Amount;
+
+		if (Index.Event == EEconomyEvent::Kill && Index.Count > 1) Amount += (Index.Count - 1) * MultiKillBonus;
+
+		//Penalties can only take what the player has, so the balance never drops below 0 and every logged amount adds up to it.
+		Amount = FMath::Max(Amount, -Balance);
+
+		ApplyTransaction(Index.Event, Index.Count, Index.Headshots, Amount);
+	}
+
+	Ledger.Reset();
+}
+
+int32 UOPEconomySubsystem::GetAvailableCash() const
+{
+	int32 AvailableCash = Balance;
+
+	for (const FOPLedgerEntry& Index : Ledger)
+	{
+		AvailableCash += Index.Amount;
+	}
+
+	return AvailableCash;
+}
+
+void UOPEconomySubsystem::RestoreFromLog(const TArray<FEconomyTransaction>& SavedLog)
+{
+	Ledger.Reset();
+	TransactionLog = SavedLog;
+
+	Balance = TransactionLog.IsEmpty() ? StartingCash : TransactionLog.Last().BalanceAfter;
+	CurrentWaveIndex = TransactionLog.IsEmpty() ? INDEX_NONE : TransactionLog.Last().WaveIndex;
+
+	//The HUD is sent the restored balance, without replaying every old transaction.
+	FirstUnbroadcastTransaction = TransactionLog.Num();
+	OnBalanceUpdated.Broadcast(Balance, TArray<FEconomyTransaction>());
+}
+
+void UOPEconomySubsystem::ResetEconomy()
+{
+	Ledger.Reset();
+	TransactionLog.Reset();
+
+	Balance = StartingCash;
+	CurrentWaveIndex = INDEX_NONE;
+	FirstUnbroadcastTransaction = 0;
+	bTookDamageThisWave = false;
+}
+
+FOPLedgerEntry& UOPEconomySubsystem::RecordEvent(EEconomyEvent Event, const UObject* Source)
+{
+	const TObjectKey<UObject> SourceKey(Source);
+
+	//There are only ever a handful of entries in a single frame, so a linear search is enough.
+	for (FOPLedgerEntry& Index : Ledger)
+	{
+		if (Index.Event == Event && Index.Source == SourceKey)
+		{
+			Index.Count++;
+			return Index;
+		}
+	}
+
+	FOPLedgerEntry& NewEntry = Ledger.AddDefaulted_GetRef();
+	NewEntry.Event = Event;
+	NewEntry.Source = SourceKey;
+	NewEntry.Count = 1;
+
+	return NewEntry;
+}
+
+FEconomyTransaction& UOPEconomySubsystem::ApplyTransaction(EEconomyEvent Event, int32 Count, int32 Headshots, int32 Amount)
+{
+	//Debits are checked against the balance before they get here, so the logged amounts always add up to each balance.
+	Balance += Amount;
+
+	FEconomyTransaction& Transaction = TransactionLog.AddDefaulted_GetRef();
+	Transaction.Sequence = TransactionLog.Num() - 1;
+	Transaction.WaveIndex = CurrentWaveIndex;
+	Transaction.Event = Event;
+	Transaction.Count = Count;
+	Transaction.Headshots = Headshots;
+	Transaction.Amount = Amount;
+	Transaction.BalanceAfter = Balance;
+
+	return Transaction;
+}
\ No newline at end of file
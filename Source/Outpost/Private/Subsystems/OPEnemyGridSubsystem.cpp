@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPEnemyGridSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+
+void UOPEnemyGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+}
+
+void UOPEnemyGridSubsystem::Deinitialize()
+{
+	Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPEnemyGridSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	RebuildGrid();
+}
+
+TStatId UOPEnemyGridSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPEnemyGridSubsystem, STATGROUP_Tickables);
+}
+
+void UOPEnemyGridSubsystem::QueryRadius(const FVector& Center, float Radius, TArray<AActor*>& OutEnemies) const
+{
+	if (CellSize <= 0.f) return;
+
+	const FIntPoint MinCell = GetCell(Center - FVector(Radius));
+	const FIntPoint MaxCell = GetCell(Center + FVector(Radius));
+	const float RadiusSquared = FMath::Square(Radius);
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			const TArray<TObjectPtr<AActor>>* Cell = Cells.Find(FIntPoint(X, Y));
+
+			if (!Cell) continue;
+
+			for (TObjectPtr<AActor> Index : *Cell)
+			{
+				if (IsValid(Index) && FVector::DistSquared(Index->GetActorLocation(), Center) <= RadiusSquared) OutEnemies.Emplace(Index);
+			}
+		}
+	}
+}
+
+void UOPEnemyGridSubsystem::RebuildGrid()
+{
+	for (TPair<FIntPoint, TArray<TObjectPtr<AActor>>>& Index : Cells)
+	{
+		Index.Value.Reset();
+	}
+
+	if (!IsValid(WorldSubsystem) || CellSize <= 0.f) return;
+
+	for (TObjectPtr<AActor> Index : WorldSubsystem->EnemyArray)
+	{
+		if (IsValid(Index)) Cells.FindOrAdd(GetCell(Index->GetActorLocation())).Emplace(Index);
+	}
+
+	//Cells that enemies have moved out of are only thrown away once there are a lot of them, so that the map isn't rebuilt every frame.
+	if (Cells.Num() > WorldSubsystem->EnemyArray.Num() * 4 + 64)
+	{
+		for (auto It = Cells.CreateIterator(); It; ++It)
+		{
+			if (It.Value().Num() <= 0) It.RemoveCurrent();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPEnemyPoolSubsystem.h"
+#include "Characters/OPEnemy.h"
+
+void UOPEnemyPoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPEnemyPoolSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	int32 SpawnsThisFrame = 0;
+
+	//Dormant enemies are pre-spawned a few at a time, so that no single frame has to pay for all of them.
+	for (TPair<TSubclassOf<AOPEnemy>, FOPEnemyPoolEntry>& Pool : Pools)
+	{
+		while (Pool.Value.PendingPrewarmCount > 0 && SpawnsThisFrame < MaxPrewarmSpawnsPerFrame)
+		{
+			TObjectPtr<AOPEnemy> Enemy = SpawnEnemy(Pool.Key, FTransform(ParkingLocation), true);
+
+			Pool.Value.PendingPrewarmCount--;
+			SpawnsThisFrame++;
+
+			if (IsValid(Enemy)) Pool.Value.DormantEnemies.Emplace(Enemy);
+		}
+
+		if (SpawnsThisFrame >= MaxPrewarmSpawnsPerFrame) return;
+	}
+}
+
+TStatId UOPEnemyPoolSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPEnemyPoolSubsystem, STATGROUP_Tickables);
+}
+
+void UOPEnemyPoolSubsystem::PrewarmPool(TSubclassOf<AOPEnemy> EnemyClass, int32 Count)
+{
+	if (!IsValid(EnemyClass)) return;
+
+	FOPEnemyPoolEntry& Pool = Pools.FindOrAdd(EnemyClass);
+
+	//Only pre-spawn enough enemies to top the pool up to the requested amount.
+	Pool.PendingPrewarmCount = FMath::Max(Pool.PendingPrewarmCount, Count - Pool.DormantEnemies.Num());
+}
+
+AOPEnemy* UOPEnemyPoolSubsystem::AcquireEnemy(TSubclassOf<AOPEnemy> EnemyClass, const FTransform& SpawnTransform)
+{
+	if (!IsValid(EnemyClass)) return nullptr;
+
+	FOPEnemyPoolEntry& Pool = Pools.FindOrAdd(EnemyClass);
+
+	while (Pool.DormantEnemies.Num() > 0)
+	{
+		TObjectPtr<AOPEnemy> Enemy = Pool.DormantEnemies.Pop(false);
+
+		if (IsValid(Enemy))
+		{
+			Enemy->ActivateFromPool(SpawnTransform);
+
+			return Enemy;
+		}
+	}
+
+	//The pool ran dry, so a new enemy has to be spawned on the spot.
+	PoolMisses++;
+
+	return SpawnEnemy(EnemyClass, SpawnTransform, false);
+}
+
+void UOPEnemyPoolSubsystem::ReleaseEnemy(AOPEnemy* Enemy)
+{
+	if (!IsValid(Enemy) || Enemy->IsDormant()) return;
+
+	Enemy->DeactivateForPool(ParkingLocation);
+
+	Pools.FindOrAdd(Enemy->GetClass()).DormantEnemies.Emplace(Enemy);
+}
+
+int32 UOPEnemyPoolSubsystem::GetDormantCount(TSubclassOf<AOPEnemy> EnemyClass) const
+{
+	const FOPEnemyPoolEntry* Pool = Pools.Find(EnemyClass);
+
+	return Pool ? Pool->DormantEnemies.Num() : 0;
+}
+
+bool UOPEnemyPoolSubsystem::IsPrewarmComplete() const
+{
+	for (const TPair<TSubclassOf<AOPEnemy>, FOPEnemyPoolEntry>& Pool : Pools)
+	{
+		if (Pool.Value.PendingPrewarmCount > 0) return false;
+	}
+
+	return true;
+}
+
+AOPEnemy* UOPEnemyPoolSubsystem::SpawnEnemy(TSubclassOf<AOPEnemy> EnemyClass, const FTransform& SpawnTransform, bool bSpawnDormant)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = bSpawnDormant ? ESpawnActorCollisionHandlingMethod::AlwaysSpawn : ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	SpawnParams.bDeferConstruction = true;
+
+	TObjectPtr<AOPEnemy> Enemy = GetWorld()->SpawnActor<AOPEnemy>(EnemyClass, SpawnTransform, SpawnParams);
+
+	if (!IsValid(Enemy)) return nullptr;
+
+	//Dormant enemies skip registration entirely, and park themselves as soon as they begin play.
+	Enemy->bSpawnDormant = bSpawnDormant;
+	Enemy->FinishSpawning(SpawnTransform);
+
+	return Enemy;
+}
\ No newline at end of file
@@ -0,0 +1,460 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPFlowFieldSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Characters/OPEnemy.h"
+#include "NavigationSystem.h"
+
+namespace OPFlowField
+{
+	//The eight neighbours of a cell, ordered so that the opposite of each direction is always four steps away.
+	static const FIntPoint DirectionOffsets[8] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+
+	FORCEINLINE uint8 GetOppositeDirection(uint8 Direction) { return (Direction + 4) % 8; }
+
+	//Keeps the cheapest open cell at the top of the heap.
+	static const auto CompareOpenCells = [](const TPair<float, int32>& a, const TPair<float, int32>& b) {return a.Key < b.Key;};
+}
+
+void UOPFlowFieldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Enemies are picked up as agents as soon as they enter play, and dropped as soon as they leave it.
+	TObjectPtr<UOPWorldSubsystem> WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+
+	if (IsValid(WorldSubsystem))
+	{
+		WorldSubsystem->OnEnemyRegistered.AddUObject(this, &UOPFlowFieldSubsystem::OnEnemyRegistered);
+		WorldSubsystem->OnEnemyUnregistered.AddUObject(this, &UOPFlowFieldSubsystem::OnEnemyUnregistered);
+	}
+}
+
+void UOPFlowFieldSubsystem::Deinitialize()
+{
+	Fields.Empty();
+	Costs.Empty();
+	Heights.Empty();
+	BlockerCounts.Empty();
+	BlockedRegions.Empty();
+	PendingChangedCells.Empty();
+	Agents.Empty();
+	AgentGoals.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPFlowFieldSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	//Every change made since the last tick is applied to each field in one go.
+	if (PendingChangedCells.Num() > 0)
+	{
+		const TArray<int32> ChangedCells = PendingChangedCells.Array();
+		PendingChangedCells.Reset();
+
+		CellsUpdatedLastChange = 0;
+
+		for (FOPFlowField& Index : Fields)
+		{
+			UpdateIntegrationField(Index, ChangedCells);
+		}
+	}
+
+	SteerAgents();
+}
+
+TStatId UOPFlowFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPFlowFieldSubsystem, STATGROUP_Tickables);
+}
+
+void UOPFlowFieldSubsystem::SetFieldArea(const FBox& NewFieldArea)
+{
+	if (!NewFieldArea.IsValid || CellSize <= 0.f || MaxCellsPerAxis <= 0) return;
+
+	//Large areas use bigger cells, so that the grid never grows past its maximum size.
+	const FVector AreaSize = NewFieldArea.GetSize();
+
+	GridCellSize = FMath::Max(CellSize, FMath::Max(AreaSize.X, AreaSize.Y) / MaxCellsPerAxis);
+	GridOrigin = NewFieldArea.Min;
+	NumCellsX = FMath::Max(FMath::CeilToInt(AreaSize.X / GridCellSize), 1);
+	NumCellsY = FMath::Max(FMath::CeilToInt(AreaSize.Y / GridCellSize), 1);
+
+	Costs.Init(1, NumCellsX * NumCellsY);
+	Heights.Init(NewFieldArea.GetCenter().Z, NumCellsX * NumCellsY);
+	BlockerCounts.Init(0, NumCellsX * NumCellsY);
+	PendingChangedCells.Reset();
+
+	//Cells that aren't on the navmesh are blocked. If there is no navmesh, then every cell is walkable.
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	if (IsValid(NavigationSystem))
+	{
+		const FVector QueryExtent = FVector(GridCellSize * 0.5f, GridCellSize * 0.5f, NewFieldArea.GetExtent().Z);
+
+		for (int32 Y = 0; Y < NumCellsY; Y++)
+		{
+			for (int32 X = 0; X < NumCellsX; X++)
+			{
+				const FVector CellCenter = FVector(GridOrigin.X + (X + 0.5f) * GridCellSize, GridOrigin.Y + (Y + 0.5f) * GridCellSize, NewFieldArea.GetCenter().Z);
+				FNavLocation NavLocation;
+
+				if (NavigationSystem->ProjectPointToNavigation(CellCenter, NavLocation, QueryExtent))
+				{
+					Heights[Y * NumCellsX + X] = NavLocation.Location.Z;
+				}
+				else
+				{
+					Costs[Y * NumCellsX + X] = BlockedCost;
+				}
+			}
+		}
+	}
+
+	//Anything that was already blocking part of the level, such as barricades, carries over to the new grid.
+	for (const FBox& Region : BlockedRegions)
+	{
+		FIntPoint MinCell, MaxCell;
+
+		if (!GetRegionCells(Region, MinCell, MaxCell)) continue;
+
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+			{
+				BlockerCounts[Y * NumCellsX + X]++;
+			}
+		}
+	}
+
+	//Every goal is recalculated from scratch, since the old fields don't line up with the new grid.
+	for (FOPFlowField& Index : Fields)
+	{
+		Index.GoalCell = GetCellIndex(Index.GoalLocation);
+		BuildIntegrationField(Index);
+	}
+}
+
+int32 UOPFlowFieldSubsystem::AddGoal(const FVector& GoalLocation)
+{
+	FOPFlowField& Field = Fields.AddDefaulted_GetRef();
+	Field.GoalLocation = GoalLocation;
+	Field.GoalCell = GetCellIndex(GoalLocation);
+
+	if (HasFieldArea()) BuildIntegrationField(Field);
+
+	return Fields.Num() - 1;
+}
+
+void UOPFlowFieldSubsystem::SetRegionBlocked(const FBox& Region, bool bBlocked)
+{
+	if (!Region.IsValid) return;
+
+	//The region is remembered, so that it can be applied again if the grid is ever rebuilt.
+	if (bBlocked)
+	{
+		BlockedRegions.Emplace(Region);
+	}
+	else if (BlockedRegions.RemoveSingle(Region) <= 0)
+	{
+		return;
+	}
+
+	if (!HasFieldArea()) return;
+
+	FIntPoint MinCell, MaxCell;
+
+	if (!GetRegionCells(Region, MinCell, MaxCell)) return;
+
+	for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+	{
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			const int32 CellIndex = Y * NumCellsX + X;
+			const bool bWasBlocked = IsCellBlocked(CellIndex);
+
+			//Overlapping regions are counted, so that a cell only opens up once nothing is covering it anymore.
+			BlockerCounts[CellIndex] = bBlocked ? FMath::Min(BlockerCounts[CellIndex] + 1, 254) : FMath::Max(BlockerCounts[CellIndex] - 1, 0);
+
+			if (IsCellBlocked(CellIndex) != bWasBlocked) PendingChangedCells.Emplace(CellIndex);
+		}
+	}
+}
+
+void UOPFlowFieldSubsystem::RegisterAgent(ACharacter* Agent, int32 GoalId)
+{
+	if (!IsValid(Agent) || Agents.Contains(Agent)) return;
+
+	Agents.Emplace(Agent);
+	AgentGoals.Emplace(GoalId);
+}
+
+void UOPFlowFieldSubsystem::UnregisterAgent(ACharacter* Agent)
+{
+	const int32 AgentIndex = Agents.IndexOfByKey(Agent);
+
+	if (AgentIndex == INDEX_NONE) return;
+
+	Agents.RemoveAtSwap(AgentIndex);
+	AgentGoals.RemoveAtSwap(AgentIndex);
+}
+
+FVector UOPFlowFieldSubsystem::GetFlowDirection(const FVector& Location, int32 GoalId) const
+{
+	const int32 CellIndex = GetCellIndex(Location);
+
+	if (!Fields.IsValidIndex(GoalId) || CellIndex == INDEX_NONE) return FVector::ZeroVector;
+
+	const FOPFlowField& Field = Fields[GoalId];
+
+	//Agents in the goal's cell head straight for it.
+	if (CellIndex == Field.GoalCell) return (Field.GoalLocation - Location).GetSafeNormal2D();
+
+	if (!Field.Directions.IsValidIndex(CellIndex) || Field.Directions[CellIndex] == NoDirection) return FVector::ZeroVector;
+
+	//Heading for the center of the next cell, rather than along the grid's eight directions, keeps agents from zig-zagging.
+	const FIntPoint NextCell = FIntPoint(CellIndex % NumCellsX, CellIndex / NumCellsX) + OPFlowField::DirectionOffsets[Field.Directions[CellIndex]];
+	const FVector NextCellCenter = FVector(GridOrigin.X + (NextCell.X + 0.5f) * GridCellSize, GridOrigin.Y + (NextCell.Y + 0.5f) * GridCellSize, Location.Z);
+
+	return (NextCellCenter - Location).GetSafeNormal2D();
+}
+
+bool UOPFlowFieldSubsystem::GetGroundHeight(const FVector& Location, float& OutHeight) const
+{
+	const int32 CellIndex = GetCellIndex(Location);
+
+	if (CellIndex == INDEX_NONE || Costs[CellIndex] == BlockedCost) return false;
+
+	OutHeight = Heights[CellIndex];
+
+	return true;
+}
+
+void UOPFlowFieldSubsystem::OnEnemyRegistered(AActor* Enemy)
+{
+	TObjectPtr<AOPEnemy> EnemyCharacter = Cast<AOPEnemy>(Enemy);
+
+	if (IsValid(EnemyCharacter) && EnemyCharacter->ShouldFollowFlowField()) RegisterAgent(EnemyCharacter);
+}
+
+void UOPFlowFieldSubsystem::OnEnemyUnregistered(AActor* Enemy)
+{
+	UnregisterAgent(Cast<ACharacter>(Enemy));
+}
+
+void UOPFlowFieldSubsystem::BuildIntegrationField(FOPFlowField& Field)
+{
+	Field.Integration.Init(MAX_flt, Costs.Num());
+	Field.Directions.Init(NoDirection, Costs.Num());
+
+	if (Field.GoalCell == INDEX_NONE || IsCellBlocked(Field.GoalCell)) return;
+
+	//A standard Dijkstra fill, outwards from the goal.
+	TArray<TPair<float, int32>> OpenCells;
+
+	Field.Integration[Field.GoalCell] = 0.f;
+	OpenCells.HeapPush(TPair<float, int32>(0.f, Field.GoalCell), OPFlowField::CompareOpenCells);
+
+	PropagateIntegrationField(Field, OpenCells);
+}
+
+void UOPFlowFieldSubsystem::UpdateIntegrationField(FOPFlowField& Field, const TArray<int32>& ChangedCells)
+{
+	if (Field.Integration.Num() != Costs.Num()) return;
+
+	/*
+	Every changed cell is invalidated, along with its neighbours (whose diagonal moves may cut past it), and every cell whose path led through any of them.
+	Cells whose paths didn't touch any changed cell are still correct, and are left alone.
+	*/
+	TArray<int32> InvalidCells;
+	TBitArray<> IsInvalid(false, Costs.Num());
+
+	for (int32 CellIndex : ChangedCells)
+	{
+		const FIntPoint Cell = FIntPoint(CellIndex % NumCellsX, CellIndex / NumCellsX);
+
+		for (int32 Direction = -1; Direction < 8; Direction++)
+		{
+			const FIntPoint Neighbour = Direction < 0 ? Cell : Cell + OPFlowField::DirectionOffsets[Direction];
+
+			if (Neighbour.X < 0 || Neighbour.Y < 0 || Neighbour.X >= NumCellsX || Neighbour.Y >= NumCellsY) continue;
+
+			const int32 NeighbourIndex = Neighbour.Y * NumCellsX + Neighbour.X;
+
+			if (NeighbourIndex == Field.GoalCell || IsInvalid[NeighbourIndex]) continue;
+
+			InvalidCells.Emplace(NeighbourIndex);
+			IsInvalid[NeighbourIndex] = true;
+		}
+	}
+
+	for (int32 i = 0; i < InvalidCells.Num(); i++)
+	{
+		const FIntPoint Cell = FIntPoint(InvalidCells[i] % NumCellsX, InvalidCells[i] / NumCellsX);
+
+		for (uint8 Direction = 0; Direction < 8; Direction++)
+		{
+			const FIntPoint Neighbour = Cell + OPFlowField::DirectionOffsets[Direction];
+
+			if (Neighbour.X < 0 || Neighbour.Y < 0 || Neighbour.X >= NumCellsX || Neighbour.Y >= NumCellsY) continue;
+
+			const int32 NeighbourIndex = Neighbour.Y * NumCellsX + Neighbour.X;
+
+			if (!IsInvalid[NeighbourIndex] && Field.Directions[NeighbourIndex] == OPFlowField::GetOppositeDirection(Direction))
+			{
+				InvalidCells.Emplace(NeighbourIndex);
+				IsInvalid[NeighbourIndex] = true;
+			}
+		}
+	}
+
+	for (int32 CellIndex : InvalidCells)
+	{
+		Field.Integration[CellIndex] = MAX_flt;
+		Field.Directions[CellIndex] = NoDirection;
+	}
+
+	//The valid cells bordering the invalidated ones are used as the starting point, and the fill carries on from there.
+	TArray<TPair<float, int32>> OpenCells;
+
+	for (int32 CellIndex : InvalidCells)
+	{
+		const FIntPoint Cell = FIntPoint(CellIndex % NumCellsX, CellIndex / NumCellsX);
+
+		for (const FIntPoint& Offset : OPFlowField::DirectionOffsets)
+		{
+			const FIntPoint Neighbour = Cell + Offset;
+
+			if (Neighbour.X < 0 || Neighbour.Y < 0 || Neighbour.X >= NumCellsX || Neighbour.Y >= NumCellsY) continue;
+
+			const int32 NeighbourIndex = Neighbour.Y * NumCellsX + Neighbour.X;
+
+			if (!IsInvalid[NeighbourIndex] && Field.Integration[NeighbourIndex] < MAX_flt) OpenCells.HeapPush(TPair<float, int32>(Field.Integration[NeighbourIndex], NeighbourIndex), OPFlowField::CompareOpenCells);
+		}
+	}
+
+	CellsUpdatedLastChange += InvalidCells.Num();
+
+	PropagateIntegrationField(Field, OpenCells);
+}
+
+void UOPFlowFieldSubsystem::PropagateIntegrationField(FOPFlowField& Field, TArray<TPair<float, int32>>& OpenCells)
+{
+	while (OpenCells.Num() > 0)
+	{
+		TPair<float, int32> Current;
+		OpenCells.HeapPop(Current, OPFlowField::CompareOpenCells, false);
+
+		//Cells can be pushed more than once. Only the cheapest entry is worth expanding.
+		if (Current.Key > Field.Integration[Current.Value]) continue;
+
+		const FIntPoint Cell = FIntPoint(Current.Value % NumCellsX, Current.Value / NumCellsX);
+
+		for (uint8 Direction = 0; Direction < 8; Direction++)
+		{
+			const FIntPoint Offset = OPFlowField::DirectionOffsets[Direction];
+			const FIntPoint Neighbour = Cell + Offset;
+
+			if (Neighbour.X < 0 || Neighbour.Y < 0 || Neighbour.X >= NumCellsX || Neighbour.Y >= NumCellsY) continue;
+
+			const int32 NeighbourIndex = Neighbour.Y * NumCellsX + Neighbour.X;
+
+			if (IsCellBlocked(NeighbourIndex)) continue;
+
+			//Agents aren't allowed to cut diagonally past the corner of a blocked cell.
+			const bool bDiagonal = Offset.X != 0 && Offset.Y != 0;
+
+			if (bDiagonal && (IsCellBlocked(Cell.Y * NumCellsX + Neighbour.X) || IsCellBlocked(Neighbour.Y * NumCellsX + Cell.X))) continue;
+
+			const float NewIntegration = Current.Key + Costs[NeighbourIndex] * (bDiagonal ? UE_SQRT_2 : 1.f);
+
+			if (NewIntegration >= Field.Integration[NeighbourIndex]) continue;
+
+			Field.Integration[NeighbourIndex] = NewIntegration;
+			Field.Directions[NeighbourIndex] = OPFlowField::GetOppositeDirection(Direction);
+
+			OpenCells.HeapPush(TPair<float, int32>(NewIntegration, NeighbourIndex), OPFlowField::CompareOpenCells);
+		}
+	}
+}
+
+void UOPFlowFieldSubsystem::SteerAgents()
+{
+	if (Agents.Num() <= 0 || !HasFieldArea()) return;
+
+	const int32 DefaultGoal = GetOutpostGoal();
+	const float GoalAcceptanceRadiusSquared = FMath::Square(GoalAcceptanceRadius);
+
+	//One pass over every agent. Each one only costs a grid lookup, no matter how far away the goal is.
+	for (int32 i = Agents.Num() - 1; i >= 0; i--)
+	{
+		TObjectPtr<ACharacter> Agent = Agents[i].Get();
+
+		if (!IsValid(Agent))
+		{
+			Agents.RemoveAtSwap(i);
+			AgentGoals.RemoveAtSwap(i);
+			continue;
+		}
+
+		const int32 GoalId = AgentGoals[i] == INDEX_NONE ? DefaultGoal : AgentGoals[i];
+
+		if (!Fields.IsValidIndex(GoalId)) continue;
+
+		const FVector AgentLocation = Agent->GetActorLocation();
+
+		//Agents that have arrived are left to their AI.
+		if (FVector::DistSquared2D(AgentLocation, Fields[GoalId].GoalLocation) <= GoalAcceptanceRadiusSquared) continue;
+
+		const FVector FlowDirection = GetFlowDirection(AgentLocation, GoalId);
+
+		//The character movement component turns this into acceleration on its next tick, exactly as it would for player input.
+		if (!FlowDirection.IsNearlyZero()) Agent->AddMovementInput(FlowDirection);
+	}
+}
+
+int32 UOPFlowFieldSubsystem::GetOutpostGoal()
+{
+	//The outpost's goal is only added once the grid exists, and the outpost's location is known.
+	if (OutpostGoal == INDEX_NONE && HasFieldArea())
+	{
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem = GetWorld()->GetSubsystem<UOPWorldSubsystem>();
+
+		if (IsValid(WorldSubsystem)) OutpostGoal = AddGoal(WorldSubsystem->OutpostLocation);
+	}
+
+	return OutpostGoal;
+}
+
+int32 UOPFlowFieldSubsystem::GetCellIndex(const FVector& Location) const
+{
+	if (!HasFieldArea()) return INDEX_NONE;
+
+	const int32 X = FMath::FloorToInt((Location.X - GridOrigin.X) / GridCellSize);
+	const int32 Y = FMath::FloorToInt((Location.Y - GridOrigin.Y) / GridCellSize);
+
+	if (X < 0 || Y < 0 || X >= NumCellsX || Y >= NumCellsY) return INDEX_NONE;
+
+	return Y * NumCellsX + X;
+}
+
+bool UOPFlowFieldSubsystem::GetRegionCells(const FBox& Region, FIntPoint& MinCell, FIntPoint& MaxCell) const
+{
+	MinCell.X = FMath::FloorToInt((Region.Min.X - GridOrigin.X) / GridCellSize);
+	MinCell.Y = FMath::FloorToInt((Region.Min.Y - GridOrigin.Y) / GridCellSize);
+	MaxCell.X = FMath::FloorToInt((Region.Max.X - GridOrigin.X) / GridCellSize);
+	MaxCell.Y = FMath::FloorToInt((Region.Max.Y - GridOrigin.Y) / GridCellSize);
+
+	//A region that's entirely off the grid covers no cells, rather than being squashed onto the border.
+	if (MaxCell.X < 0 || MaxCell.Y < 0 || MinCell.X >= NumCellsX || MinCell.Y >= NumCellsY) return false;
+
+	//Only the part of the region that's on the grid is kept.
+	MinCell.X = FMath::Max(MinCell.X, 0);
+	MinCell.Y = FMath::Max(MinCell.Y, 0);
+	MaxCell.X = FMath::Min(MaxCell.X, NumCellsX - 1);
+	MaxCell.Y = FMath::Min(MaxCell.Y, NumCellsY - 1);
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPGenerationCacheSubsystem.h"
+#include "Subsystems/OPGenerationSubsystem.h"
+#include "Outpost.h"
+#include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//"OPGC". A cached file that doesn't start with this is treated as stale, and the area is generated again.
+static constexpr uint32 LayoutCacheMagic = 0x4F504743;
+
+//Should be increased whenever the way layouts are written changes. Layouts written in an older format are thrown away.
+static constexpr int32 LayoutCacheFormatVersion = 1;
+
+//The size of a single placement in the file. Used to reject corrupted counts before anything is allocated.
+static constexpr int64 CachedPlacementSize = sizeof(uint8) + sizeof(int32) + sizeof(FVector3f) + sizeof(float) * 2;
+
+/*
+Reads or writes everything in a layout, apart from the header. Nothing in the layout is changed when writing.
+Generated placements are only ever turned around their yaw and scaled evenly, so each one is stored as a location, a yaw and a scale rather than a full transform.
+*/
+static void SerializeLayoutBody(FArchive& Ar, FOPGeneratedLayout& Layout)
+{
+	FVector3f PlayerStart(Layout.PlayerStart);
+	FVector3f OutpostLocation(Layout.OutpostLocation);
+	int32 SpawnZoneCount = Layout.SpawnZones.Num();
+	int32 PlacementCount = Layout.Placements.Num();
+
+	Ar << PlayerStart << OutpostLocation << SpawnZoneCount;
+
+	if (Ar.IsLoading())
+	{
+		if (SpawnZoneCount < 0 || SpawnZoneCount * int64(sizeof(FVector3f)) > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Layout.PlayerStart = FVector(PlayerStart);
+		Layout.OutpostLocation = FVector(OutpostLocation);
+		Layout.SpawnZones.SetNum(SpawnZoneCount);
+	}
+
+	for (FVector& Index : Layout.SpawnZones)
+	{
+		FVector3f SpawnZone(Index);
+		Ar << SpawnZone;
+
+		if (Ar.IsLoading()) Index = FVector(SpawnZone);
+	}
+
+	Ar << PlacementCount;
+
+	if (Ar.IsLoading())
+	{
+		if (PlacementCount < 0 || PlacementCount * CachedPlacementSize > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return;
+		}
+
+		Layout.Placements.SetNum(PlacementCount);
+	}
+
+	for (FOPGeneratedPlacement& Index : Layout.Placements)
+	{
+		uint8 Stage = static_cast<uint8>(Index.Stage);
+		int32 RuleIndex = Index.RuleIndex;
+		FVector3f Location(Index.Transform.GetLocation());
+		float Yaw = Index.Transform.Rotator().Yaw;
+		float Scale = Index.Transform.GetScale3D().X;
+
+		Ar << Stage << RuleIndex << Location << Yaw << Scale;
+
+		if (Ar.IsLoading())
+		{
+			Index.Stage = static_cast<EGenerationStage>(Stage);
+			Index.RuleIndex = RuleIndex;
+			Index.Transform = FTransform(FRotator(0.f, Yaw, 0.f), FVector(Location), FVector(Scale));
+		}
+	}
+}
+
+void UOPGenerationCacheSubsystem::Deinitialize()
+{
+	for (TFuture<void>& Index : PendingWrites)
+	{
+		Index.Wait();
+	}
+
+	PendingWrites.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UOPGenerationCacheSubsystem::LoadLayout(int32 Seed, int32 GeneratorVersion, uint32 SettingsHash, FOPGeneratedLayout& OutLayout)
+{
+	const FString CachePath = GetCachePath(Seed, GeneratorVersion);
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	//The file is mapped rather than read, so it's paged straight into memory with no extra copy.
+	TUniquePtr<IMappedFileHandle> MappedFile(PlatformFile.OpenMapped(*CachePath));
+
+	if (!MappedFile.IsValid() || MappedFile->GetFileSize() <= 0)
+	{
+		CacheMisses++;
+		return false;
+	}
+
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+
+	if (!MappedRegion.IsValid())
+	{
+		CacheMisses++;
+		return false;
+	}
+
+	FMemoryReaderView Reader(FMemoryView(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize()));
+
+	uint32 Magic = 0;
+	int32 FormatVersion = 0;
+	int32 CachedGeneratorVersion = 0;
+	uint32 CachedSettingsHash = 0;
+	int32 CachedSeed = 0;
+
+	Reader << Magic << FormatVersion << CachedGeneratorVersion << CachedSettingsHash << CachedSeed;
+
+	const bool bIsStale = Reader.IsError() || Magic != LayoutCacheMagic || FormatVersion != LayoutCacheFormatVersion || CachedGeneratorVersion != GeneratorVersion || CachedSettingsHash != SettingsHash || CachedSeed != Seed;
+
+	FOPGeneratedLayout CachedLayout;
+
+	if (!bIsStale) SerializeLayoutBody(Reader, CachedLayout);
+
+	//The file has to be unmapped before it can be deleted.
+	MappedRegion.Reset();
+	MappedFile.Reset();
+
+	if (bIsStale || Reader.IsError())
+	{
+		UE_LOG(LogOutpost, Log, TEXT("The cached layout for seed %d is out of date, and will be generated again."), Seed);
+
+		PlatformFile.DeleteFile(*CachePath);
+		CacheInvalidations++;
+		CacheMisses++;
+
+		return false;
+	}
+
+	CachedLayout.Seed = Seed;
+	CachedLayout.GeneratorVersion = GeneratorVersion;
+	OutLayout = MoveTemp(CachedLayout);
+
+	CacheHits++;
+
+	return true;
+}
+
+void UOPGenerationCacheSubsystem::SaveLayout(const FOPGeneratedLayout& Layout, uint32 SettingsHash)
+{
+	//The layout is packed on the game thread, since it's a single pass over flat arrays. Only writing the file happens in the background.
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = LayoutCacheMagic;
+	int32 FormatVersion = LayoutCacheFormatVersion;
+	int32 GeneratorVersion = Layout.GeneratorVersion;
+	int32 Seed = Layout.Seed;
+
+	Writer << Magic << FormatVersion << GeneratorVersion << SettingsHash << Seed;
+
+	//Saving only ever reads from the layout.
+	SerializeLayoutBody(Writer, const_cast<FOPGeneratedLayout&>(Layout));
+
+	//Writes that have already finished are forgotten about.
+	PendingWrites.RemoveAll([](const TFuture<void>& Index) { return Index.IsReady(); });
+
+	PendingWrites.Emplace(Async(EAsyncExecution::ThreadPool, [Bytes = MoveTemp(Bytes), CacheDirectory = GetCacheDirectory(), CachePath = GetCachePath(Seed, GeneratorVersion), MaxLayouts = MaxCachedLayouts]()
+		{
+			//The layout is written under a temporary name first, so that a half-written file is never mistaken for a cached layout.
+			const FString TempPath = CachePath + TEXT(".tmp");
+
+			if (!FFileHelper::SaveArrayToFile(Bytes, *TempPath) || !IFileManager::Get().Move(*CachePath, *TempPath, true))
+			{
+				UE_LOG(LogOutpost, Warning, TEXT("Could not write the cached layout %s."), *CachePath);
+				return;
+			}
+
+			TrimCache(CacheDirectory, MaxLayouts);
+		}));
+}
+
+void UOPGenerationCacheSubsystem::ClearCache()
+{
+	for (TFuture<void>& Index : PendingWrites)
+	{
+		Index.Wait();
+	}
+
+	PendingWrites.Empty();
+
+	IFileManager::Get().DeleteDirectory(*GetCacheDirectory(), false, true);
+}
+
+FString UOPGenerationCacheSubsystem::GetCacheDirectory() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("GenerationCache");
+}
+
+FString UOPGenerationCacheSubsystem::GetCachePath(int32 Seed, int32 GeneratorVersion) const
+{
+	return GetCacheDirectory() / FString::Printf(TEXT("Layout_%d_v%d.opgc"), Seed, GeneratorVersion);
+}
+
+void UOPGenerationCacheSubsystem::TrimCache(const FString& CacheDirectory, int32 MaxLayouts)
+{
+	TArray<FString> CachedFiles;
+	IFileManager::Get().FindFiles(CachedFiles, *(CacheDirectory / TEXT("*.opgc")), true, false);
+
+	if (CachedFiles.Num() <= FMath::Max(MaxLayouts, 1)) return;
+
+	TArray<TPair<FDateTime, FString>> FilesByAge;
+
+	for (const FString& Index : CachedFiles)
+	{
+		const FString FilePath = CacheDirectory / Index;
+		FilesByAge.Emplace(IFileManager::Get().GetTimeStamp(*FilePath), FilePath);
+	}
+
+	FilesByAge.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B) { return A.Key < B.Key; });
+
+	for (int32 i = 0; i < FilesByAge.Num() - FMath::Max(MaxLayouts, 1); i++)
+	{
+		IFileManager::Get().Delete(*FilesByAge[i].Value);
+	}
+}
\ No newline at end of file
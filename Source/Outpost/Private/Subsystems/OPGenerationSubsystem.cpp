@@ -0,0 +1,516 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPGenerationSubsystem.h"
+#include "Subsystems/OPGenerationCacheSubsystem.h"
+#include "Subsystems/OPAreaStreamingSubsystem.h"
+#include "Data/OPGenerationSettings.h"
+#include "Outpost.h"
+
+//The number of stages in EGenerationStage. The layout itself is decided before any of them run.
+static constexpr int32 GenerationStageCount = static_cast<int32>(EGenerationStage::Outpost) + 1;
+
+void UOPGenerationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Cache = Collection.InitializeDependency<UOPGenerationCacheSubsystem>();
+	Streaming = Collection.InitializeDependency<UOPAreaStreamingSubsystem>();
+}
+
+void UOPGenerationSubsystem::Deinitialize()
+{
+	WaitForTasks();
+	ClearGeneratedArea();
+
+	Super::Deinitialize();
+}
+
+void UOPGenerationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsGenerating) return;
+
+	//The game thread only ever checks on the worker threads, and never waits for them.
+	if (!bIsCommitting)
+	{
+		bool bAllStagesComplete = LayoutTask.IsCompleted();
+
+		for (const UE::Tasks::TTask<TArray<FOPGeneratedPlacement>>& Index : StageTasks)
+		{
+			bAllStagesComplete &= Index.IsCompleted();
+		}
+
+		if (bAllStagesComplete) OnStagesComplete();
+	}
+
+	if (bIsCommitting) CommitPlacements();
+
+	const float Progress = GetProgress();
+
+	if (Progress != LastBroadcastProgress)
+	{
+		LastBroadcastProgress = Progress;
+		OnGenerationProgress.Broadcast(Progress);
+	}
+
+	if (bIsCommitting && NextCommitIndex >= Layout.Placements.Num()) FinishGeneration();
+}
+
+TStatId UOPGenerationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPGenerationSubsystem, STATGROUP_Tickables);
+}
+
+bool UOPGenerationSubsystem::StartGeneration(UOPGenerationSettings* NewSettings, int32 Seed, FVector Origin)
+{
+	if (!IsValid(NewSettings) || bIsGenerating) return false;
+
+	ClearGeneratedArea();
+
+	Settings = NewSettings;
+	Layout.Seed = Seed;
+
+	if (IsValid(Streaming)) Streaming->SetCellSize(Settings->CellSize);
+
+	//The worker threads are given a copy of everything they need, so that the settings asset can be edited or unloaded while they run.
+	Params = FOPGenerationParams();
+	Params.Seed = Seed;
+	Params.Origin = Origin;
+	Params.AreaHalfExtent = Settings->AreaHalfExtent;
+	Params.OutpostDistance = Settings->OutpostDistance;
+	Params.OutpostClearRadius = Settings->OutpostClearRadius;
+	Params.PlayerClearRadius = Settings->PlayerClearRadius;
+	Params.CoverBandWidth = Settings->CoverBandWidth;
+	Params.SpawnZoneCount = Settings->SpawnZoneCount;
+	Params.SpawnZoneDistance = Settings->SpawnZoneDistance;
+	Params.MaxPlacementAttempts = FMath::Max(MaxPlacementAttempts, 1);
+	Params.StageRules.SetNum(GenerationStageCount);
+
+	for (int32 i = 0; i < GenerationStageCount; i++)
+	{
+		for (const FGenerationRule& Index : Settings->GetStageRules(static_cast<EGenerationStage>(i)))
+		{
+			FOPGenerationRuleParams& RuleParams = Params.StageRules[i].AddDefaulted_GetRef();
+			RuleParams.Count = FMath::Max(Index.Count, 0);
+			RuleParams.Spacing = FMath::Max(Index.Spacing, 1.f);
+			RuleParams.MinScale = Index.MinScale;
+			RuleParams.MaxScale = FMath::Max(Index.MaxScale, Index.MinScale);
+			RuleParams.bRandomYaw = Index.bRandomYaw;
+		}
+	}
+
+	bIsGenerating = true;
+	bIsCommitting = false;
+	bGenerationComplete = false;
+	NextCommitIndex = 0;
+	CommitFrames = 0;
+	PlacementsCommitted = 0;
+	LastBroadcastProgress = -1.f;
+	GenerationStartTime = FPlatformTime::Seconds();
+	SettingsHash = GetSettingsHash();
+
+	//If this area has been generated before, the cached layout is already on the ground, so only adding it to the world is left.
+	bLoadedFromCache = IsValid(Cache) && Cache->LoadLayout(Seed, Settings->GeneratorVersion, SettingsHash, Layout);
+
+	if (bLoadedFromCache)
+	{
+		Layout.bIsOnGround = true;
+		AddSpawnZones();
+		GenerationTimeMs = (FPlatformTime::Seconds() - GenerationStartTime) * 1000.0;
+		bIsCommitting = true;
+
+		return true;
+	}
+
+	//Every stage needs to know where the outpost and the player are, so the layout is decided first. The stages then run side by side.
+	LayoutTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [LayoutParams = Params]() { return GenerateLayout(LayoutParams); });
+
+	StageTasks.Reset();
+
+	for (int32 i = 0; i < GenerationStageCount; i++)
+	{
+		StageTasks.Emplace(UE::Tasks::Launch(UE_SOURCE_LOCATION, [StageParams = Params, StageLayoutTask = LayoutTask, Stage = static_cast<EGenerationStage>(i)]()
+			{
+				return GenerateStage(StageParams, StageLayoutTask.GetResult(), Stage);
+			},
+			UE::Tasks::Prerequisites(LayoutTask)));
+	}
+
+	return true;
+}
+
+void UOPGenerationSubsystem::ClearGeneratedArea()
+{
+	//Generation that is still running is forgotten about, rather than waited for.
+	bIsGenerating = false;
+	bIsCommitting = false;
+	bGenerationComplete = false;
+
+	if (IsValid(Streaming)) Streaming->ClearCells();
+
+	Layout = FOPGeneratedLayout();
+}
+
+float UOPGenerationSubsystem::GetProgress() const
+{
+	if (bGenerationComplete) return 1.f;
+
+	if (!bIsGenerating) return 0.f;
+
+	//Deciding on placements counts for the first half of the progress, and adding them to the world counts for the second.
+	if (!bIsCommitting)
+	{
+		int32 StagesComplete = 0;
+
+		for (const UE::Tasks::TTask<TArray<FOPGeneratedPlacement>>& Index : StageTasks)
+		{
+			if (Index.IsCompleted()) StagesComplete++;
+		}
+
+		return 0.5f * StagesComplete / FMath::Max(StageTasks.Num(), 1);
+	}
+
+	return 0.5f + 0.5f * NextCommitIndex / FMath::Max(Layout.Placements.Num(), 1);
+}
+
+FBox UOPGenerationSubsystem::GetAreaBounds() const
+{
+	const float TraceHeight = IsValid(Settings) ? Settings->GroundTraceHeight : 50000.f;
+	const FVector Extent(Params.AreaHalfExtent, Params.AreaHalfExtent, TraceHeight);
+
+	return FBox(Params.Origin - Extent, Params.Origin + Extent);
+}
+
+int32 UOPGenerationSubsystem::GetStageSeed(int32 Seed, int32 StageIndex)
+{
+	return static_cast<int32>(HashCombine(GetTypeHash(Seed), GetTypeHash(StageIndex)));
+}
+
+FOPGeneratedLayout UOPGenerationSubsystem::GenerateLayout(const FOPGenerationParams& InParams)
+{
+	FRandomStream Stream(GetStageSeed(InParams.Seed, INDEX_NONE));
+
+	FOPGeneratedLayout NewLayout;
+	NewLayout.Seed = InParams.Seed;
+	NewLayout.PlayerStart = InParams.Origin;
+
+	//The outpost is placed in a random direction from the player, far enough inside of the area that its clear radius fits.
+	const float OutpostAngle = Stream.FRandRange(0.f, UE_TWO_PI);
+	const float OutpostDistance = FMath::Min(InParams.OutpostDistance, FMath::Max(InParams.AreaHalfExtent - InParams.OutpostClearRadius, 0.f));
+
+	NewLayout.OutpostLocation = InParams.Origin + FVector(FMath::Cos(OutpostAngle), FMath::Sin(OutpostAngle), 0.f) * OutpostDistance;
+
+	//Spawn zones are spread across the side of the outpost that faces away from the player, so that enemies never arrive on top of them.
+	const int32 SpawnZoneCount = FMath::Max(InParams.SpawnZoneCount, 0);
+	const float ArcPerZone = UE_PI / FMath::Max(SpawnZoneCount, 1);
+	const float FirstZoneAngle = OutpostAngle - UE_HALF_PI;
+
+	for (int32 i = 0; i < SpawnZoneCount; i++)
+	{
+		const float ZoneAngle = FirstZoneAngle + ArcPerZone * (i + Stream.FRandRange(0.25f, 0.75f));
+
+		FVector ZoneLocation = NewLayout.OutpostLocation + FVector(FMath::Cos(ZoneAngle), FMath::Sin(ZoneAngle), 0.f) * InParams.SpawnZoneDistance;
+		ZoneLocation.X = FMath::Clamp(ZoneLocation.X, InParams.Origin.X - InParams.AreaHalfExtent, InParams.Origin.X + InParams.AreaHalfExtent);
+		ZoneLocation.Y = FMath::Clamp(ZoneLocation.Y, InParams.Origin.Y - InParams.AreaHalfExtent, InParams.Origin.Y + InParams.AreaHalfExtent);
+
+		NewLayout.SpawnZones.Emplace(ZoneLocation);
+	}
+
+	return NewLayout;
+}
+
+TArray<FOPGeneratedPlacement> UOPGenerationSubsystem::GenerateStage(const FOPGenerationParams& InParams, const FOPGeneratedLayout& InLayout, EGenerationStage Stage)
+{
+	TArray<FOPGeneratedPlacement> Placements;
+
+	const int32 StageIndex = static_cast<int32>(Stage);
+
+	if (!InParams.StageRules.IsValidIndex(StageIndex)) return Placements;
+
+	const TArray<FOPGenerationRuleParams>& Rules = InParams.StageRules[StageIndex];
+
+	//Each stage has its own stream, so adding objects to one stage never moves anything placed by another.
+	FRandomStream Stream(GetStageSeed(InParams.Seed, StageIndex));
+
+	//Everything placed so far is kept in a grid of cells as wide as the largest spacing, so only the neighbouring cells need to be checked for room.
+	float CellSize = 1.f;
+
+	for (const FOPGenerationRuleParams& Index : Rules)
+	{
+		CellSize = FMath::Max(CellSize, Index.Spacing);
+	}
+
+	//Each entry holds a placed location in X and Y, and the spacing it needs in Z.
+	TMap<FIntPoint, TArray<FVector3f>> Occupied;
+
+	for (int32 RuleIndex = 0; RuleIndex < Rules.Num(); RuleIndex++)
+	{
+		const FOPGenerationRuleParams& Rule = Rules[RuleIndex];
+
+		for (int32 Copy = 0; Copy < Rule.Count; Copy++)
+		{
+			for (int32 Attempt = 0; Attempt < InParams.MaxPlacementAttempts; Attempt++)
+			{
+				const FVector2D Location = SampleStageLocation(Stream, InParams, InLayout, Stage);
+
+				if (!IsLocationClear(Location, InParams, InLayout, Stage)) continue;
+
+				const FIntPoint Cell(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+				bool bHasRoom = true;
+
+				for (int32 X = -1; X <= 1 && bHasRoom; X++)
+				{
+					for (int32 Y = -1; Y <= 1 && bHasRoom; Y++)
+					{
+						const TArray<FVector3f>* Neighbours = Occupied.Find(Cell + FIntPoint(X, Y));
+
+						if (!Neighbours) continue;
+
+						for (const FVector3f& Index : *Neighbours)
+						{
+							if (FVector2D::DistSquared(Location, FVector2D(Index.X, Index.Y)) < FMath::Square(FMath::Max(Rule.Spacing, Index.Z)))
+							{
+								bHasRoom = false;
+								break;
+							}
+						}
+					}
+				}
+
+				if (!bHasRoom) continue;
+
+				Occupied.FindOrAdd(Cell).Emplace(FVector3f(Location.X, Location.Y, Rule.Spacing));
+
+				//Every random value is drawn whether it's used or not, so changing one rule's options never shifts the rest of the stage.
+				const float Yaw = Stream.FRandRange(0.f, 360.f);
+				const float Scale = Stream.FRandRange(Rule.MinScale, Rule.MaxScale);
+
+				FOPGeneratedPlacement& Placement = Placements.AddDefaulted_GetRef();
+				Placement.Stage = Stage;
+				Placement.RuleIndex = RuleIndex;
+				Placement.Transform = FTransform(FRotator(0.f, Rule.bRandomYaw ? Yaw : 0.f, 0.f), FVector(Location, InParams.Origin.Z), FVector(Scale));
+
+				break;
+			}
+		}
+	}
+
+	return Placements;
+}
+
+FVector2D UOPGenerationSubsystem::SampleStageLocation(FRandomStream& Stream, const FOPGenerationParams& InParams, const FOPGeneratedLayout& InLayout, EGenerationStage Stage)
+{
+	const FVector2D Outpost(InLayout.OutpostLocation);
+
+	//The outpost layout fills its clear radius, and cover rings the outside of it. Everything else is spread across the whole area.
+	if (Stage == EGenerationStage::Outpost || Stage == EGenerationStage::Cover)
+	{
+		const float InnerRadius = Stage == EGenerationStage::Outpost ? 0.f : InParams.OutpostClearRadius;
+		const float OuterRadius = Stage == EGenerationStage::Outpost ? InParams.OutpostClearRadius : InParams.OutpostClearRadius + InParams.CoverBandWidth;
+
+		//Picking the square of the radius keeps the locations evenly spread, instead of bunched up towards the middle.
+		const float Radius = FMath::Sqrt(Stream.FRandRange(FMath::Square(InnerRadius), FMath::Square(OuterRadius)));
+		const float Angle = Stream.FRandRange(0.f, UE_TWO_PI);
+
+		return Outpost + FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)) * Radius;
+	}
+
+	const FVector2D Origin(InParams.Origin);
+
+	return Origin + FVector2D(Stream.FRandRange(-InParams.AreaHalfExtent, InParams.AreaHalfExtent), Stream.FRandRange(-InParams.AreaHalfExtent, InParams.AreaHalfExtent));
+}
+
+bool UOPGenerationSubsystem::IsLocationClear(const FVector2D& Location, const FOPGenerationParams& InParams, const FOPGeneratedLayout& InLayout, EGenerationStage Stage)
+{
+	const FVector2D Offset = Location - FVector2D(InParams.Origin);
+
+	if (FMath::Abs(Offset.X) > InParams.AreaHalfExtent || FMath::Abs(Offset.Y) > InParams.AreaHalfExtent) return false;
+
+	if (Offset.SizeSquared() < FMath::Square(InParams.PlayerClearRadius)) return false;
+
+	//Only the outpost layout is allowed inside of the outpost's clear radius.
+	return Stage == EGenerationStage::Outpost || FVector2D::DistSquared(Location, FVector2D(InLayout.OutpostLocation)) >= FMath::Square(InParams.OutpostClearRadius);
+}
+
+void UOPGenerationSubsystem::OnStagesComplete()
+{
+	Layout = LayoutTask.GetResult();
+	Layout.GeneratorVersion = IsValid(Settings) ? Settings->GeneratorVersion : 0;
+
+	//Stages are gathered in a fixed order, so the same seed always produces the same list of placements.
+	for (const UE::Tasks::TTask<TArray<FOPGeneratedPlacement>>& Index : StageTasks)
+	{
+		Layout.Placements.Append(Index.GetResult());
+	}
+
+	StageTasks.Reset();
+	LayoutTask = UE::Tasks::TTask<FOPGeneratedLayout>();
+
+	GenerationTimeMs = (FPlatformTime::Seconds() - GenerationStartTime) * 1000.0;
+
+	//The few locations that other systems need straight away are moved onto the ground before anything else.
+	SnapToGround(Layout.PlayerStart);
+	SnapToGround(Layout.OutpostLocation);
+
+	for (FVector& Index : Layout.SpawnZones)
+	{
+		SnapToGround(Index);
+	}
+
+	AddSpawnZones();
+
+	bIsCommitting = true;
+}
+
+void UOPGenerationSubsystem::CommitPlacements()
+{
+	const double FrameStartTime = FPlatformTime::Seconds();
+	const int32 FirstCommitIndex = NextCommitIndex;
+
+	//At least one placement is added every frame, so that generation always makes progress.
+	while (NextCommitIndex < Layout.Placements.Num())
+	{
+		if (NextCommitIndex > FirstCommitIndex && (FPlatformTime::Seconds() - FrameStartTime) * 1000.0 > CommitBudgetMs) break;
+
+		CommitPlacement(Layout.Placements[NextCommitIndex++]);
+	}
+
+	CommitFrames++;
+}
+
+void UOPGenerationSubsystem::CommitPlacement(FOPGeneratedPlacement& Placement)
+{
+	if (!IsValid(Settings)) return;
+
+	const TArray<FGenerationRule>& Rules = Settings->GetStageRules(Placement.Stage);
+
+	if (!Rules.IsValidIndex(Placement.RuleIndex)) return;
+
+	const FGenerationRule& Rule = Rules[Placement.RuleIndex];
+
+	//Placements that have no ground under them are dropped, rather than left floating.
+	if (!Layout.bIsOnGround)
+	{
+		FVector Location = Placement.Transform.GetLocation();
+
+		if (!SnapToGround(Location))
+		{
+			Placement.RuleIndex = INDEX_NONE;
+			return;
+		}
+
+		Placement.Transform.SetLocation(Location);
+	}
+
+	if (!IsValid(Streaming) || (!IsValid(Rule.ActorClass) && !IsValid(Rule.Mesh))) return;
+
+	//Nothing is spawned here. The streaming subsystem only spawns what is in the cells around the player.
+	if (IsValid(Rule.ActorClass))
+	{
+		Streaming->AddActor(Rule.ActorClass, Placement.Transform);
+	}
+	else
+	{
+		Streaming->AddInstance(Rule, Placement.Transform);
+	}
+
+	PlacementsCommitted++;
+}
+
+void UOPGenerationSubsystem::AddSpawnZones()
+{
+	if (!IsValid(Streaming)) return;
+
+	for (const FVector& Index : Layout.SpawnZones)
+	{
+		Streaming->AddSpawnZone(Index);
+	}
+}
+
+void UOPGenerationSubsystem::FinishGeneration()
+{
+	bIsCommitting = false;
+	bIsGenerating = false;
+	bGenerationComplete = true;
+
+	//Newly generated layouts are cached with every placement already on the ground, so the next time this area is needed no traces are made at all.
+	if (!Layout.bIsOnGround)
+	{
+		Layout.Placements.RemoveAll([](const FOPGeneratedPlacement& Index) { return Index.RuleIndex == INDEX_NONE; });
+		Layout.bIsOnGround = true;
+
+		if (IsValid(Cache)) Cache->SaveLayout(Layout, SettingsHash);
+	}
+
+	if (IsValid(Streaming)) Streaming->StartStreaming(Layout.PlayerStart);
+
+	UE_LOG(LogOutpost, Log, TEXT("%s seed %d: %d placements, decided in %.1fms and added over %d frames."), bLoadedFromCache ? TEXT("Loaded") : TEXT("Generated"), Layout.Seed, PlacementsCommitted, GenerationTimeMs, CommitFrames);
+
+	OnGenerationComplete.Broadcast();
+}
+
+uint32 UOPGenerationSubsystem::GetSettingsHash() const
+{
+	uint32 Hash = GetTypeHash(Params.Origin);
+
+	Hash = HashCombine(Hash, GetTypeHash(Params.AreaHalfExtent));
+	Hash = HashCombine(Hash, GetTypeHash(Params.OutpostDistance));
+	Hash = HashCombine(Hash, GetTypeHash(Params.OutpostClearRadius));
+	Hash = HashCombine(Hash, GetTypeHash(Params.PlayerClearRadius));
+	Hash = HashCombine(Hash, GetTypeHash(Params.CoverBandWidth));
+	Hash = HashCombine(Hash, GetTypeHash(Params.SpawnZoneCount));
+	Hash = HashCombine(Hash, GetTypeHash(Params.SpawnZoneDistance));
+	Hash = HashCombine(Hash, GetTypeHash(Params.MaxPlacementAttempts));
+
+	if (!IsValid(Settings)) return Hash;
+
+	Hash = HashCombine(Hash, GetTypeHash(Settings->GroundTraceHeight));
+
+	//Cached placements refer to their rules by index, so every rule is hashed along with what it places.
+	for (int32 i = 0; i < GenerationStageCount; i++)
+	{
+		for (const FGenerationRule& Index : Settings->GetStageRules(static_cast<EGenerationStage>(i)))
+		{
+			Hash = HashCombine(Hash, GetTypeHash(i));
+			Hash = HashCombine(Hash, GetTypeHash(GetPathNameSafe(Index.Mesh)));
+			Hash = HashCombine(Hash, GetTypeHash(GetPathNameSafe(Index.ActorClass)));
+			Hash = HashCombine(Hash, GetTypeHash(Index.Count));
+			Hash = HashCombine(Hash, GetTypeHash(Index.Spacing));
+			Hash = HashCombine(Hash, GetTypeHash(Index.MinScale));
+			Hash = HashCombine(Hash, GetTypeHash(Index.MaxScale));
+			Hash = HashCombine(Hash, GetTypeHash(Index.bRandomYaw ? 1 : 0));
+		}
+	}
+
+	return Hash;
+}
+
+bool UOPGenerationSubsystem::SnapToGround(FVector& Location) const
+{
+	const float TraceHeight = IsValid(Settings) ? Settings->GroundTraceHeight : 50000.f;
+
+	//Nothing generated is loaded until generation has finished, so placements always land on the level's own ground rather than on each other.
+	FCollisionQueryParams GroundParams(SCENE_QUERY_STAT(OPGenerationGround), false);
+
+	FHitResult HitResult;
+
+	if (!GetWorld()->LineTraceSingleByObjectType(HitResult, Location + FVector(0.f, 0.f, TraceHeight), Location - FVector(0.f, 0.f, TraceHeight), FCollisionObjectQueryParams(ECC_WorldStatic), GroundParams)) return false;
+
+	Location = HitResult.ImpactPoint;
+
+	return true;
+}
+
+void UOPGenerationSubsystem::WaitForTasks()
+{
+	//The tasks only ever work on their own copies of the settings, so this is just to make sure they are finished before the world goes away.
+	if (LayoutTask.IsValid()) LayoutTask.Wait();
+
+	for (UE::Tasks::TTask<TArray<FOPGeneratedPlacement>>& Index : StageTasks)
+	{
+		if (Index.IsValid()) Index.Wait();
+	}
+
+	StageTasks.Reset();
+}
\ No newline at end of file
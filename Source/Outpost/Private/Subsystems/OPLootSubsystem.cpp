@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPLootSubsystem.h"
+#include "Items/OPLootPickup.h"
+#include "Data/OPLootTable.h"
+#include "Data/OPCheckpoint.h"
+#include "Engine/StaticMesh.h"
+
+void UOPLootSubsystem::Deinitialize()
+{
+	PendingDrops.Empty();
+	LivePickups.Empty();
+	DormantPickups.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPLootSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (PendingDrops.IsEmpty()) return;
+
+	//Only a few drops are placed each frame, oldest first.
+	const int32 DropsThisFrame = FMath::Min(PendingDrops.Num(), FMath::Max(MaxDropsPerFrame, 1));
+
+	for (int32 i = 0; i < DropsThisFrame; i++)
+	{
+		PlaceDrop(PendingDrops[i]);
+	}
+
+	PendingDrops.RemoveAt(0, DropsThisFrame, false);
+}
+
+TStatId UOPLootSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPLootSubsystem, STATGROUP_Tickables);
+}
+
+void UOPLootSubsystem::DropLoot(const UOPLootTable* LootTable, const FVector& Location, TSubclassOf<AOPWeapon> EquippedWeapon)
+{
+	if (!IsValid(LootTable)) return;
+
+	if (IsValid(EquippedWeapon) && LootStream.FRand() < LootTable->EquippedWeaponDropChance) DropWeapon(EquippedWeapon, Location);
+
+	for (const FLootDrop& Index : LootTable->Drops)
+	{
+		if (LootStream.FRand() >= Index.DropChance) continue;
+
+		FOPPendingLoot NewDrop;
+		NewDrop.Location = Location;
+
+		if (IsValid(Index.WeaponClass))
+		{
+			NewDrop.WeaponClass = Index.WeaponClass;
+		}
+		else
+		{
+			NewDrop.AmmoType = Index.AmmoType;
+			NewDrop.Amount = LootStream.RandRange(Index.MinAmmo, FMath::Max(Index.MinAmmo, Index.MaxAmmo));
+			NewDrop.Mesh = Index.AmmoMesh;
+
+			if (NewDrop.Amount <= 0) continue;
+		}
+
+		QueueDrop(MoveTemp(NewDrop));
+	}
+}
+
+void UOPLootSubsystem::SetSeed(int32 Seed)
+{
+	LootStream.Initialize(Seed);
+}
+
+void UOPLootSubsystem::DropWeapon(TSubclassOf<AOPWeapon> WeaponClass, const FVector& Location)
+{
+	if (!IsValid(WeaponClass)) return;
+
+	FOPPendingLoot NewDrop;
+	NewDrop.Location = Location;
+	NewDrop.WeaponClass = WeaponClass;
+
+	QueueDrop(MoveTemp(NewDrop));
+}
+
+void UOPLootSubsystem::ReleasePickup(AOPLootPickup* Pickup)
+{
+	if (!IsValid(Pickup) || LivePickups.Remove(Pickup) == 0) return;
+
+	Pickup->Deactivate();
+	DormantPickups.Emplace(Pickup);
+}
+
+void UOPLootSubsystem::ClearAllLoot()
+{
+	PendingDrops.Empty();
+
+	for (TObjectPtr<AOPLootPickup> Index : LivePickups)
+	{
+		if (!IsValid(Index)) continue;
+
+		Index->Deactivate();
+		DormantPickups.Emplace(Index);
+	}
+
+	LivePickups.Empty();
+}
+
+void UOPLootSubsystem::WriteToCheckpoint(FOPCheckpoint& Checkpoint) const
+{
+	Checkpoint.LootSeed = LootStream.GetCurrentSeed();
+
+	for (const TObjectPtr<AOPLootPickup>& Index : LivePickups)
+	{
+		if (!IsValid(Index)) continue;
+
+		Checkpoint.LootLocations.Emplace(Index->GetActorLocation());
+		Checkpoint.LootWeaponClasses.Emplace(Checkpoint.FindOrAddAsset(Index->GetWeaponClass()));
+		Checkpoint.LootAmmoTypes.Emplace(Index->GetAmmoType());
+		Checkpoint.LootAmounts.Emplace(Index->GetAmmoAmount());
+		Checkpoint.LootMeshes.Emplace(Checkpoint.FindOrAddAsset(Index->GetAmmoMesh()));
+	}
+
+	for (const FOPPendingLoot& Index : PendingDrops)
+	{
+		Checkpoint.LootLocations.Emplace(SnapToGround(Index.Location));
+		Checkpoint.LootWeaponClasses.Emplace(Checkpoint.FindOrAddAsset(Index.WeaponClass));
+		Checkpoint.LootAmmoTypes.Emplace(Index.AmmoType);
+		Checkpoint.LootAmounts.Emplace(Index.Amount);
+		Checkpoint.LootMeshes.Emplace(Checkpoint.FindOrAddAsset(Index.Mesh));
+	}
+}
+
+void UOPLootSubsystem::ReadFromCheckpoint(const FOPCheckpoint& Checkpoint)
+{
+	ClearAllLoot();
+
+	//Checkpoints from before the loot stream was saved leave it where it is.
+	if (Checkpoint.LootSeed != 0) LootStream.Initialize(Checkpoint.LootSeed);
+
+	for (int32 i = 0; i < Checkpoint.LootLocations.Num(); i++)
+	{
+		TSubclassOf<AOPWeapon> WeaponClass = Cast<UClass>(Checkpoint.LoadAsset(Checkpoint.LootWeaponClasses[i]));
+
+		//A weapon whose class can no longer be found is skipped, rather than being turned into a pile of ammo.
+		if (Checkpoint.LootWeaponClasses[i] != INDEX_NONE && !IsValid(WeaponClass)) continue;
+
+		TObjectPtr<AOPLootPickup> Pickup = GetFreePickup();
+
+		if (!IsValid(Pickup)) continue;
+
+		if (IsValid(WeaponClass))
+		{
+			Pickup->ActivateAsWeapon(Checkpoint.LootLocations[i], WeaponClass);
+		}
+		else
+		{
+			Pickup->ActivateAsAmmo(Checkpoint.LootLocations[i], Checkpoint.LootAmmoTypes[i], Checkpoint.LootAmounts[i], Cast<UStaticMesh>(Checkpoint.LoadAsset(Checkpoint.LootMeshes[i])));
+		}
+
+		LivePickups.Emplace(Pickup);
+	}
+}
+
+void UOPLootSubsystem::QueueDrop(FOPPendingLoot&& Drop)
+{
+	//If the queue is full, the oldest waiting drop makes room for the newest one.
+	if (PendingDrops.Num() >= FMath::Max(MaxPendingDrops, 1))
+	{
+		PendingDrops.RemoveAt(0, 1, false);
+		DiscardedDrops++;
+	}
+
+	PendingDrops.Emplace(MoveTemp(Drop));
+}
+
+void UOPLootSubsystem::PlaceDrop(const FOPPendingLoot& Drop)
+{
+	const bool bIsAmmo = !IsValid(Drop.WeaponClass);
+
+	//Ammo is merged into a nearby pile of the same type, if there is one.
+	if (bIsAmmo)
+	{
+		TObjectPtr<AOPLootPickup> ExistingPile = FindMergeablePile(Drop.AmmoType, Drop.Location);
+
+		if (IsValid(ExistingPile))
+		{
+			ExistingPile->AddAmmo(Drop.Amount);
+			MergedDrops++;
+			return;
+		}
+	}
+
+	TObjectPtr<AOPLootPickup> Pickup = GetFreePickup();
+
+	if (!IsValid(Pickup)) return;
+
+	//The square root spreads drops evenly over the circle, instead of bunching them up in the middle.
+	const float ScatterAngle = LootStream.FRandRange(0.f, 2.f * PI);
+	const float ScatterDistance = DropScatterRadius * FMath::Sqrt(LootStream.FRand());
+	const FVector DropLocation = SnapToGround(Drop.Location + FVector(FMath::Cos(ScatterAngle) * ScatterDistance, FMath::Sin(ScatterAngle) * ScatterDistance, 0.f));
+
+	if (bIsAmmo)
+	{
+		Pickup->ActivateAsAmmo(DropLocation, Drop.AmmoType, Drop.Amount, Drop.Mesh);
+	}
+	else
+	{
+		Pickup->ActivateAsWeapon(DropLocation, Drop.WeaponClass);
+	}
+
+	LivePickups.Emplace(Pickup);
+}
+
+AOPLootPickup* UOPLootSubsystem::FindMergeablePile(EWeaponType AmmoType, const FVector& Location) const
+{
+	const float MergeRadiusSquared = FMath::Square(MergeRadius);
+
+	//Newer piles are checked first, since they are the most likely to be close by.
+	for (int32 i = LivePickups.Num() - 1; i >= 0; i--)
+	{
+		TObjectPtr<AOPLootPickup> Pickup = LivePickups[i];
+
+		if (!IsValid(Pickup) || !Pickup->IsAmmo() || Pickup->GetAmmoType() != AmmoType) continue;
+
+		if (FVector::DistSquared(Pickup->GetActorLocation(), Location) <= MergeRadiusSquared) return Pickup;
+	}
+
+	return nullptr;
+}
+
+AOPLootPickup* UOPLootSubsystem::GetFreePickup()
+{
+	//Once the cap is reached, the oldest live pickup is recycled for the newest one.
+	if (LivePickups.Num() >= FMath::Max(MaxLiveLoot, 1))
+	{
+		TObjectPtr<AOPLootPickup> Oldest = LivePickups[0];
+		LivePickups.RemoveAt(0, 1, false);
+		RecycledDrops++;
+
+		if (IsValid(Oldest))
+		{
+			Oldest->Deactivate();
+			return Oldest;
+		}
+	}
+
+	while (!DormantPickups.IsEmpty())
+	{
+		TObjectPtr<AOPLootPickup> Pickup = DormantPickups.Pop(false);
+
+		if (IsValid(Pickup)) return Pickup;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AOPLootPickup>(AOPLootPickup::StaticClass(), FTransform::Identity, SpawnParams);
+}
+
+FVector UOPLootSubsystem::SnapToGround(const FVector& Location) const
+{
+	FHitResult GroundHit;
+
+	const FVector TraceStart = Location + FVector(0.f, 0.f, 100.f);
+	const FVector TraceEnd = Location - FVector(0.f, 0.f, 1000.f);
+
+	if (GetWorld()->LineTraceSingleByObjectType(GroundHit, TraceStart, TraceEnd, FCollisionObjectQueryParams(ECC_WorldStatic))) return GroundHit.ImpactPoint;
+
+	return Location;
+}
\ No newline at end of file
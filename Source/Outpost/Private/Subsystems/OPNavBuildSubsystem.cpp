@@ -0,0 +1,224 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPNavBuildSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "Kismet/GameplayStatics.h"
+
+void UOPNavBuildSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+}
+
+void UOPNavBuildSubsystem::Deinitialize()
+{
+	EndDeferredBuild();
+
+	PendingTiles.Empty();
+	DeferredDirtyAreas.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPNavBuildSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsBuilding) return;
+
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = GetNavigationSystem();
+
+	if (!IsValid(NavigationSystem))
+	{
+		FinishBuild();
+		return;
+	}
+
+	//Tiles are only handed over while the navigation system's own queue is short, so anything that changes later only ever waits behind a handful of tiles.
+	const int32 QueuedTiles = NavigationSystem->GetNumRemainingBuildTasks() + NavigationSystem->GetNumRunningBuildTasks();
+	const int32 TileBudget = FMath::Min(MaxTilesPerFrame, MaxQueuedTiles - QueuedTiles);
+	const bool bHadPendingTiles = PendingTiles.Num() > 0;
+
+	if (TileBudget > 0 && bHadPendingTiles)
+	{
+		//The order is only refreshed once the player has moved at least a tile's width, since sorting every frame would be wasted work.
+		const FVector PlayerLocation = GetPlayerLocation();
+		const ARecastNavMesh* NavMesh = Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate));
+		const float TileSize = IsValid(NavMesh) ? NavMesh->TileSizeUU : 1000.f;
+
+		if (FVector::DistSquared2D(PlayerLocation, LastSortLocation) > FMath::Square(TileSize)) SortPendingTiles();
+
+		for (int32 i = 0; i < TileBudget && PendingTiles.Num() > 0; i++)
+		{
+			NavigationSystem->AddDirtyArea(PendingTiles.Pop(false), ENavigationDirtyFlag::All);
+			SubmittedTiles++;
+		}
+	}
+
+	const float Progress = GetProgress();
+
+	if (Progress != LastBroadcastProgress)
+	{
+		LastBroadcastProgress = Progress;
+		OnNavBuildProgress.Broadcast(Progress);
+	}
+
+	//Dirty areas take a frame to turn into build tasks, so the build is only finished once the navigation system has been idle for two frames in a row.
+	if (!bHadPendingTiles && QueuedTiles == 0 && !NavigationSystem->IsNavigationBuildInProgress())
+	{
+		if (++IdleFrames >= 2) FinishBuild();
+	}
+	else
+	{
+		IdleFrames = 0;
+	}
+}
+
+TStatId UOPNavBuildSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPNavBuildSubsystem, STATGROUP_Tickables);
+}
+
+void UOPNavBuildSubsystem::DeferNavigationBuild()
+{
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = GetNavigationSystem();
+
+	if (!IsValid(NavigationSystem) || bIsBuildDeferred) return;
+
+	//Everything that generation adds would otherwise dirty the navmesh piece by piece, in whatever order it was added.
+	NavigationSystem->AddNavigationBuildLock(ENavigationBuildLock::Custom);
+	bIsBuildDeferred = true;
+}
+
+void UOPNavBuildSubsystem::BuildArea(const FBox& Bounds)
+{
+	EndDeferredBuild();
+
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = GetNavigationSystem();
+
+	if (!IsValid(NavigationSystem) || !Bounds.IsValid) return;
+
+	TObjectPtr<ARecastNavMesh> NavMesh = Cast<ARecastNavMesh>(NavigationSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate));
+
+	if (IsValid(NavMesh)) NavMesh->SetMaxSimultaneousTileGenerationJobsCount(FMath::Max(MaxTileGenerationJobs, 1));
+
+	//The area is split along the navmesh's own tile grid, so that each dirty area only rebuilds the tile that it covers.
+	const float TileSize = IsValid(NavMesh) ? NavMesh->TileSizeUU : 1000.f;
+	const FIntPoint MinTile(FMath::FloorToInt32(Bounds.Min.X / TileSize), FMath::FloorToInt32(Bounds.Min.Y / TileSize));
+	const FIntPoint MaxTile(FMath::FloorToInt32(Bounds.Max.X / TileSize), FMath::FloorToInt32(Bounds.Max.Y / TileSize));
+
+	PendingTiles.Reset();
+
+	for (int32 X = MinTile.X; X <= MaxTile.X; X++)
+	{
+		for (int32 Y = MinTile.Y; Y <= MaxTile.Y; Y++)
+		{
+			//Each tile is shrunk slightly, so that it doesn't also dirty its neighbours along its edges.
+			const FVector TileMin(X * TileSize + 1.f, Y * TileSize + 1.f, Bounds.Min.Z);
+			const FVector TileMax((X + 1) * TileSize - 1.f, (Y + 1) * TileSize - 1.f, Bounds.Max.Z);
+
+			PendingTiles.Emplace(TileMin, TileMax);
+		}
+	}
+
+	TotalTiles = PendingTiles.Num();
+	SubmittedTiles = 0;
+	IdleFrames = 0;
+	LastBroadcastProgress = -1.f;
+	bIsBuilding = true;
+
+	SortPendingTiles();
+}
+
+void UOPNavBuildSubsystem::RebuildDirtyArea(const FBox& Bounds)
+{
+	if (!Bounds.IsValid) return;
+
+	//Changes made while generation is running are held on to, and applied as soon as navigation building is allowed again.
+	if (bIsBuildDeferred)
+	{
+		DeferredDirtyAreas.Emplace(Bounds);
+		return;
+	}
+
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = GetNavigationSystem();
+
+	if (IsValid(NavigationSystem)) NavigationSystem->AddDirtyArea(Bounds, ENavigationDirtyFlag::All);
+}
+
+float UOPNavBuildSubsystem::GetProgress() const
+{
+	if (!bIsBuilding) return 1.f;
+
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = GetNavigationSystem();
+
+	//Tiles that are still queued in the navigation system don't count as built yet.
+	const int32 QueuedTiles = IsValid(NavigationSystem) ? NavigationSystem->GetNumRemainingBuildTasks() + NavigationSystem->GetNumRunningBuildTasks() : 0;
+	const int32 BuiltTiles = SubmittedTiles - FMath::Min(QueuedTiles, SubmittedTiles);
+
+	return static_cast<float>(BuiltTiles) / FMath::Max(TotalTiles, 1);
+}
+
+UNavigationSystemV1* UOPNavBuildSubsystem::GetNavigationSystem() const
+{
+	return FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+}
+
+FVector UOPNavBuildSubsystem::GetPlayerLocation() const
+{
+	TObjectPtr<APawn> PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+
+	if (IsValid(PlayerPawn)) return PlayerPawn->GetActorLocation();
+
+	return IsValid(WorldSubsystem) ? WorldSubsystem->OutpostLocation : FVector::ZeroVector;
+}
+
+void UOPNavBuildSubsystem::SortPendingTiles()
+{
+	const FVector PlayerLocation = GetPlayerLocation();
+	const FVector OutpostLocation = IsValid(WorldSubsystem) ? WorldSubsystem->OutpostLocation : PlayerLocation;
+
+	LastSortLocation = PlayerLocation;
+
+	//The nearest tile is sorted to the end, so that handing it over is a cheap pop.
+	PendingTiles.Sort([&PlayerLocation, &OutpostLocation](const FBox& A, const FBox& B)
+		{
+			const float DistanceA = FMath::Min(FVector::DistSquared2D(A.GetCenter(), PlayerLocation), FVector::DistSquared2D(A.GetCenter(), OutpostLocation));
+			const float DistanceB = FMath::Min(FVector::DistSquared2D(B.GetCenter(), PlayerLocation), FVector::DistSquared2D(B.GetCenter(), OutpostLocation));
+
+			return DistanceA > DistanceB;
+		});
+}
+
+void UOPNavBuildSubsystem::EndDeferredBuild()
+{
+	if (!bIsBuildDeferred) return;
+
+	bIsBuildDeferred = false;
+
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = GetNavigationSystem();
+
+	if (!IsValid(NavigationSystem)) return;
+
+	//The lock is lifted without a rebuild. The area is rebuilt tile by tile instead.
+	NavigationSystem->RemoveNavigationBuildLock(ENavigationBuildLock::Custom, UNavigationSystemV1::ELockRemovalRebuildAction::NoRebuild);
+
+	for (const FBox& Index : DeferredDirtyAreas)
+	{
+		NavigationSystem->AddDirtyArea(Index, ENavigationDirtyFlag::All);
+	}
+
+	DeferredDirtyAreas.Reset();
+}
+
+void UOPNavBuildSubsystem::FinishBuild()
+{
+	bIsBuilding = false;
+	PendingTiles.Reset();
+
+	OnNavBuildProgress.Broadcast(1.f);
+	OnNavBuildComplete.Broadcast();
+}
\ No newline at end of file
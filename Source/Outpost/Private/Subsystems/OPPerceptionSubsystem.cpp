@@ -0,0 +1,217 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPPerceptionSubsystem.h"
+#include "Subsystems/OPTraceBatchSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "Kismet/GameplayStatics.h"
+
+void UOPPerceptionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Line of sight checks are sent out through the shared trace batch.
+	TraceBatchSubsystem = Collection.InitializeDependency<UOPTraceBatchSubsystem>();
+
+	//Enemies are added to the visibility table as soon as they enter play, and removed as soon as they leave it.
+	TObjectPtr<UOPWorldSubsystem> WorldSubsystem = Collection.InitializeDependency<UOPWorldSubsystem>();
+
+	if (IsValid(WorldSubsystem))
+	{
+		WorldSubsystem->OnEnemyRegistered.AddUObject(this, &UOPPerceptionSubsystem::OnEnemyRegistered);
+		WorldSubsystem->OnEnemyUnregistered.AddUObject(this, &UOPPerceptionSubsystem::OnEnemyUnregistered);
+	}
+}
+
+void UOPPerceptionSubsystem::Deinitialize()
+{
+	Agents.Empty();
+	CheckPriorities.Empty();
+	VisibilityTable.Empty();
+	AgentIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPPerceptionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ChecksLastFrame = 0;
+
+	//Enemies that were destroyed without being unregistered are swept out, so that they never hold up the indices of the others.
+	for (int32 i = Agents.Num() - 1; i >= 0; i--)
+	{
+		if (Agents[i].IsValid()) continue;
+
+		RemoveAgentIndexEntry(i);
+		RemoveAgent(i);
+	}
+
+	TObjectPtr<APawn> PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+
+	if (Agents.Num() <= 0 || !IsValid(PlayerPawn) || !IsValid(TraceBatchSubsystem)) return;
+
+	const FVector PlayerLocation = PlayerPawn->GetPawnViewLocation();
+	const float SightRadiusSquared = FMath::Square(SightRadius);
+	const float SightCosine = FMath::Cos(FMath::DegreesToRadians(SightHalfAngle));
+
+	/*
+	Every enemy's priority grows each frame by how significant it is, so that close enemies are checked often...
+	...And far away enemies still get their turn, once they've waited long enough.
+	Enemies that fail the cheap range and angle tests are updated right away, without using up any of the budget.
+	*/
+	TArray<int32> CheckOrder;
+
+	for (int32 i = 0; i < Agents.Num(); i++)
+	{
+		TObjectPtr<AActor> Enemy = Agents[i].Get();
+
+		if (!IsValid(Enemy)) continue;
+
+		const FVector ToPlayer = PlayerLocation - Enemy->GetActorLocation();
+		const float DistanceSquared = ToPlayer.SizeSquared();
+
+		if (DistanceSquared > SightRadiusSquared || FVector::DotProduct(Enemy->GetActorForwardVector(), ToPlayer.GetSafeNormal()) < SightCosine)
+		{
+			UpdateVisibility(i, false, PlayerLocation);
+			continue;
+		}
+
+		const float Significance = DistanceSquared <= FMath::Square(HighSignificanceRadius) ? MaxSignificance : SightRadius / FMath::Max(FMath::Sqrt(DistanceSquared), 1.f);
+
+		CheckPriorities[i] += Significance * DeltaTime;
+		CheckOrder.Emplace(i);
+	}
+
+	if (CheckOrder.Num() > MaxChecksPerFrame) CheckOrder.Sort([this](int32 a, int32 b) {return CheckPriorities[a] > CheckPriorities[b];});
+
+	//Only the most overdue enemies are checked this frame. Everyone else keeps their current result until their turn comes.
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(OPPerceptionSight), false, PlayerPawn);
+
+	for (int32 i = 0; i < FMath::Min(CheckOrder.Num(), MaxChecksPerFrame); i++)
+	{
+		const int32 AgentIndex = CheckOrder[i];
+		TObjectPtr<AActor> Enemy = Agents[AgentIndex].Get();
+
+		FVector EyeLocation;
+		FRotator EyeRotation;
+		Enemy->GetActorEyesViewPoint(EyeLocation, EyeRotation);
+
+		FCollisionQueryParams EnemyTraceParams = TraceParams;
+		EnemyTraceParams.AddIgnoredActor(Enemy);
+
+		TraceBatchSubsystem->QueueLineTrace(EyeLocation, PlayerLocation, ECC_Visibility, EnemyTraceParams, FOPTraceBatchDelegate::CreateUObject(this, &UOPPerceptionSubsystem::OnSightTraceComplete, Agents[AgentIndex], PlayerLocation));
+
+		CheckPriorities[AgentIndex] = 0.f;
+		ChecksLastFrame++;
+	}
+}
+
+TStatId UOPPerceptionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPPerceptionSubsystem, STATGROUP_Tickables);
+}
+
+bool UOPPerceptionSubsystem::CanSeePlayer(const AActor* Enemy) const
+{
+	const int32* AgentIndex = AgentIndices.Find(Enemy);
+
+	return AgentIndex && VisibilityTable[*AgentIndex].bCanSeePlayer;
+}
+
+bool UOPPerceptionSubsystem::GetLastKnownPlayerLocation(const AActor* Enemy, FVector& OutLocation, float& OutTimeSinceSeen) const
+{
+	const int32* AgentIndex = AgentIndices.Find(Enemy);
+
+	if (!AgentIndex || VisibilityTable[*AgentIndex].LastSeenTime < 0.f) return false;
+
+	OutLocation = VisibilityTable[*AgentIndex].LastKnownPlayerLocation;
+	OutTimeSinceSeen = GetWorld()->GetTimeSeconds() - VisibilityTable[*AgentIndex].LastSeenTime;
+
+	return true;
+}
+
+void UOPPerceptionSubsystem::RestoreLastKnownPlayerLocation(const AActor* Enemy, const FVector& Location, float TimeSinceSeen)
+{
+	const int32* AgentIndex = AgentIndices.Find(Enemy);
+
+	if (!AgentIndex) return;
+
+	//Whether the player is visible right now is left to the enemy's next check, which it gets straight away.
+	FOPVisibilityEntry& Entry = VisibilityTable[*AgentIndex];
+	Entry.LastKnownPlayerLocation = Location;
+	Entry.LastSeenTime = FMath::Max(GetWorld()->GetTimeSeconds() - TimeSinceSeen, 0.f);
+}
+
+void UOPPerceptionSubsystem::OnEnemyRegistered(AActor* Enemy)
+{
+	if (!IsValid(Enemy) || AgentIndices.Contains(Enemy)) return;
+
+	//New enemies start out at the front of the line, so that they get their first check right away.
+	AgentIndices.Add(Enemy, Agents.Emplace(Enemy));
+	CheckPriorities.Emplace(MaxSignificance);
+	VisibilityTable.AddDefaulted();
+}
+
+void UOPPerceptionSubsystem::OnEnemyUnregistered(AActor* Enemy)
+{
+	int32 AgentIndex;
+
+	if (!AgentIndices.RemoveAndCopyValue(Enemy, AgentIndex)) return;
+
+	RemoveAgent(AgentIndex);
+}
+
+void UOPPerceptionSubsystem::OnSightTraceComplete(const FHitResult& HitResult, bool bBlockingHit, TWeakObjectPtr<AActor> Enemy, FVector PlayerLocation)
+{
+	//The enemy may have died, or been returned to the enemy pool, while the trace was in flight.
+	const int32* AgentIndex = AgentIndices.Find(Enemy.Get());
+
+	if (AgentIndex) UpdateVisibility(*AgentIndex, !bBlockingHit, PlayerLocation);
+}
+
+void UOPPerceptionSubsystem::RemoveAgent(int32 AgentIndex)
+{
+	const int32 LastIndex = Agents.Num() - 1;
+
+	Agents.RemoveAtSwap(AgentIndex);
+	CheckPriorities.RemoveAtSwap(AgentIndex);
+	VisibilityTable.RemoveAtSwap(AgentIndex);
+
+	if (AgentIndex == LastIndex) return;
+
+	//The last enemy was swapped into the removed enemy's place, so its index needs updating...
+	TObjectPtr<AActor> MovedEnemy = Agents[AgentIndex].Get();
+
+	if (IsValid(MovedEnemy))
+	{
+		AgentIndices.Add(MovedEnemy, AgentIndex);
+	}
+	//...Unless it's already gone, in which case its old entry is dropped, and it's swept out on the next tick.
+	else
+	{
+		RemoveAgentIndexEntry(LastIndex);
+	}
+}
+
+void UOPPerceptionSubsystem::RemoveAgentIndexEntry(int32 AgentIndex)
+{
+	for (TMap<TObjectKey<AActor>, int32>::TIterator It = AgentIndices.CreateIterator(); It; ++It)
+	{
+		if (It.Value() != AgentIndex) continue;
+
+		It.RemoveCurrent();
+		return;
+	}
+}
+
+void UOPPerceptionSubsystem::UpdateVisibility(int32 AgentIndex, bool bCanSeePlayer, const FVector& PlayerLocation)
+{
+	FOPVisibilityEntry& Entry = VisibilityTable[AgentIndex];
+	Entry.bCanSeePlayer = bCanSeePlayer;
+
+	if (!bCanSeePlayer) return;
+
+	Entry.LastKnownPlayerLocation = PlayerLocation;
+	Entry.LastSeenTime = GetWorld()->GetTimeSeconds();
+}
\ No newline at end of file
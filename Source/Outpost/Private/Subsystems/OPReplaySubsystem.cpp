@@ -0,0 +1,313 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPReplaySubsystem.h"
+#include "Characters/OPPlayer.h"
+#include "Outpost.h"
+#include "EnhancedInputComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/GameViewportClient.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//"OPRP". Replays share the save game's slots with checkpoints, so this keeps LoadReplay from accepting either.
+static constexpr uint32 ReplayMagic = 0x4F505250;
+
+//An action instance that carries a recorded event. The engine only ever fills these in itself, so the recorded event is set through a subclass.
+struct FOPReplayedActionInstance : public FInputActionInstance
+{
+	FOPReplayedActionInstance(const UInputAction* Action, ETriggerEvent InTriggerEvent, const FInputActionValue& InValue)
+		: FInputActionInstance(Action)
+	{
+		//The value has already been through the action's triggers and modifiers when it was recorded, so it's set as-is.
+		TriggerEvent = InTriggerEvent;
+		Value = InValue;
+	}
+};
+
+void UOPReplaySubsystem::Deinitialize()
+{
+	//A recording that is still running when the level closes is kept, rather than lost.
+	StopRecording();
+
+	if (IsReplaying()) FinishReplay();
+
+	Replay.Reset();
+	Player = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UOPReplaySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsSessionRunning) return;
+
+	//This runs after the player has handled this frame's input, so the frame is finished.
+	if (bIsRecording)
+	{
+		Replay.FrameDeltaTimes.Emplace(FApp::GetDeltaTime());
+		CurrentFrame++;
+		return;
+	}
+
+	CurrentFrame++;
+
+	if (CurrentFrame >= Replay.GetFrameCount())
+	{
+		FinishReplay();
+		OnReplayFinished.Broadcast(CurrentFrame);
+		return;
+	}
+
+	//The next frame's events are sent now, so that the player picks them up on the same frame as they did while recording.
+	PlayFrame(CurrentFrame);
+}
+
+TStatId UOPReplaySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPReplaySubsystem, STATGROUP_Tickables);
+}
+
+bool UOPReplaySubsystem::StartRecording(const FString& SlotName)
+{
+	if (SlotName.IsEmpty() || bIsRecording || bHasReplay || bIsLoadingReplay) return false;
+
+	Replay.Reset();
+	Replay.RandomSeed = FMath::Rand();
+
+	RecordingSlotName = SlotName;
+	bIsRecording = true;
+
+	SetPlayerInputHeld(true);
+
+	return true;
+}
+
+bool UOPReplaySubsystem::StopRecording()
+{
+	if (!bIsRecording) return false;
+
+	TObjectPtr<UEnhancedInputComponent> PlayerInput = GetPlayerInput();
+
+	if (IsValid(PlayerInput))
+	{
+		for (uint32 Index : RecordingBindings)
+		{
+			PlayerInput->RemoveBindingByHandle(Index);
+		}
+	}
+
+	RecordingBindings.Reset();
+	bIsRecording = false;
+	bIsSessionRunning = false;
+	EventCount = Replay.GetEventCount();
+
+	SetPlayerInputHeld(false);
+
+	TObjectPtr<UOPSaveSubsystem> SaveSubsystem = GetSaveSubsystem();
+
+	if (!IsValid(SaveSubsystem))
+	{
+		Replay.Reset();
+		return false;
+	}
+
+	//The recording is only packed once, when it stops, so recording itself never touches the disk.
+	FOPPendingSave PendingSave;
+	PendingSave.SlotName = RecordingSlotName;
+	PendingSave.Magic = ReplayMagic;
+	PendingSave.Version = static_cast<int32>(EOPReplayVersion::Latest);
+
+	FMemoryWriter Writer(PendingSave.Bytes);
+	Replay.Serialize(Writer, EOPReplayVersion::Latest);
+
+	LastRecordingSize = PendingSave.Bytes.Num();
+
+	SaveSubsystem->WriteSlot(MoveTemp(PendingSave));
+
+	Replay.Reset();
+
+	return true;
+}
+
+bool UOPReplaySubsystem::LoadReplay(const FString& SlotName)
+{
+	TObjectPtr<UOPSaveSubsystem> SaveSubsystem = GetSaveSubsystem();
+
+	if (!IsValid(SaveSubsystem) || bIsRecording || bHasReplay || bIsLoadingReplay) return false;
+
+	bIsLoadingReplay = SaveSubsystem->ReadSlot(SlotName, ReplayMagic, static_cast<int32>(EOPReplayVersion::Latest), FOPSlotReadDelegate::CreateUObject(this, &UOPReplaySubsystem::OnReplayRead, SlotName));
+
+	//The player's own input would change the run, so it's held back from the start.
+	if (bIsLoadingReplay) SetPlayerInputHeld(true);
+
+	return bIsLoadingReplay;
+}
+
+void UOPReplaySubsystem::StartSession()
+{
+	if (bIsSessionRunning || (!bIsRecording && !bHasReplay)) return;
+
+	Player = Cast<AOPPlayer>(UGameplayStatics::GetPlayerCharacter(this, 0));
+
+	CurrentFrame = 0;
+	NextEventIndex = 0;
+	bIsSessionRunning = true;
+
+	//Everything that draws from the global random number generator, such as loot drops, draws the same numbers on every run.
+	FMath::RandInit(Replay.RandomSeed);
+	FMath::SRandInit(Replay.RandomSeed);
+
+	if (bIsRecording)
+	{
+		TObjectPtr<UEnhancedInputComponent> PlayerInput = GetPlayerInput();
+
+		if (IsValid(PlayerInput))
+		{
+			//Each action and trigger event that the player handles is listened to once, in the order that the player bound them, so events are recorded in the order that the player received them.
+			TArray<TPair<const UInputAction*, ETriggerEvent>> HandledEvents;
+
+			for (const TUniquePtr<FEnhancedInputActionEventBinding>& Index : PlayerInput->GetActionEventBindings())
+			{
+				HandledEvents.AddUnique(TPair<const UInputAction*, ETriggerEvent>(Index->GetAction(), Index->GetTriggerEvent()));
+			}
+
+			for (const TPair<const UInputAction*, ETriggerEvent>& Index : HandledEvents)
+			{
+				RecordingBindings.Emplace(PlayerInput->BindAction(Index.Key, Index.Value, this, &UOPReplaySubsystem::RecordEvent).GetHandle());
+			}
+		}
+
+		SetPlayerInputHeld(false);
+		return;
+	}
+
+	//Every frame of the replay runs with the time that it took while recording, no matter how long it actually takes.
+	bWasUsingFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+
+	FApp::SetUseFixedTimeStep(true);
+
+	if (!bRenderReplay && IsValid(GetWorld()->GetGameViewport())) GetWorld()->GetGameViewport()->bDisableWorldRendering = true;
+
+	PlayFrame(0);
+}
+
+void UOPReplaySubsystem::SetSeed(int32 NewSeed)
+{
+	if (bIsRecording) Replay.Seed = NewSeed;
+}
+
+UOPSaveSubsystem* UOPReplaySubsystem::GetSaveSubsystem() const
+{
+	const UGameInstance* GameInstance = GetWorld()->GetGameInstance();
+
+	return IsValid(GameInstance) ? GameInstance->GetSubsystem<UOPSaveSubsystem>() : nullptr;
+}
+
+UEnhancedInputComponent* UOPReplaySubsystem::GetPlayerInput() const
+{
+	return IsValid(Player) ? Cast<UEnhancedInputComponent>(Player->InputComponent) : nullptr;
+}
+
+void UOPReplaySubsystem::SetPlayerInputHeld(bool bHeld)
+{
+	if (!IsValid(Player)) Player = Cast<AOPPlayer>(UGameplayStatics::GetPlayerCharacter(this, 0));
+
+	TObjectPtr<APlayerController> PlayerController = UGameplayStatics::GetPlayerController(this, 0);
+
+	if (!IsValid(Player) || !IsValid(PlayerController)) return;
+
+	//Only the player's own input component is held back. Replayed events are sent to its bindings directly, so they still get through.
+	if (bHeld)
+	{
+		Player->DisableInput(PlayerController);
+	}
+	else
+	{
+		Player->EnableInput(PlayerController);
+	}
+}
+
+void UOPReplaySubsystem::RecordEvent(const FInputActionInstance& Instance)
+{
+	if (!bIsSessionRunning || !bIsRecording) return;
+
+	const int32 ActionIndex = Replay.FindOrAddAction(Instance.GetSourceAction());
+
+	if (ActionIndex == INDEX_NONE) return;
+
+	Replay.AddEvent(CurrentFrame, ActionIndex, Instance.GetTriggerEvent(), Instance.GetValue());
+}
+
+void UOPReplaySubsystem::PlayFrame(int32 Frame)
+{
+	if (Replay.FrameDeltaTimes.IsValidIndex(Frame)) FApp::SetFixedDeltaTime(Replay.FrameDeltaTimes[Frame]);
+
+	TObjectPtr<UEnhancedInputComponent> PlayerInput = GetPlayerInput();
+
+	for (; NextEventIndex < Replay.GetEventCount() && Replay.EventFrames[NextEventIndex] <= Frame; NextEventIndex++)
+	{
+		const UInputAction* Action = Replay.LoadAction(Replay.EventActions[NextEventIndex]);
+
+		if (!IsValid(PlayerInput) || !IsValid(Action)) continue;
+
+		const FOPReplayedActionInstance Instance(Action, Replay.EventTriggers[NextEventIndex], Replay.GetEventValue(NextEventIndex));
+
+		//Every one of the player's bindings for the event runs, exactly as it would have if the event had come from their own input.
+		for (const TUniquePtr<FEnhancedInputActionEventBinding>& Index : PlayerInput->GetActionEventBindings())
+		{
+			if (Index->GetAction() == Action && Index->GetTriggerEvent() == Instance.GetTriggerEvent()) Index->Execute(Instance);
+		}
+	}
+}
+
+void UOPReplaySubsystem::FinishReplay()
+{
+	bIsSessionRunning = false;
+	bHasReplay = false;
+
+	FApp::SetUseFixedTimeStep(bWasUsingFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	if (IsValid(GetWorld()->GetGameViewport())) GetWorld()->GetGameViewport()->bDisableWorldRendering = false;
+
+	SetPlayerInputHeld(false);
+}
+
+void UOPReplaySubsystem::OnReplayRead(const TArray<uint8>& Bytes, int32 Version, FString SlotName)
+{
+	bIsLoadingReplay = false;
+
+	if (Bytes.IsEmpty())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Could not read the replay %s."), *SlotName);
+
+		SetPlayerInputHeld(false);
+		OnReplayLoaded.Broadcast(SlotName, false);
+		return;
+	}
+
+	Replay.Reset();
+
+	FMemoryReader Reader(Bytes);
+	Replay.Serialize(Reader, static_cast<EOPReplayVersion>(Version));
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("The replay %s is corrupted."), *SlotName);
+
+		Replay.Reset();
+		SetPlayerInputHeld(false);
+		OnReplayLoaded.Broadcast(SlotName, false);
+		return;
+	}
+
+	bHasReplay = true;
+	EventCount = Replay.GetEventCount();
+
+	OnReplayLoaded.Broadcast(SlotName, true);
+}
\ No newline at end of file
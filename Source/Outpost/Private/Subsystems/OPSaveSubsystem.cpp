@@ -0,0 +1,394 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPSaveSubsystem.h"
+#include "Subsystems/OPEconomySubsystem.h"
+#include "Subsystems/OPAreaStreamingSubsystem.h"
+#include "Data/OPSaveGame.h"
+#include "Characters/OPPlayer.h"
+#include "OutpostGameModeBase.h"
+#include "Outpost.h"
+#include "Async/Async.h"
+#include "Kismet/GameplayStatics.h"
+#include "PlatformFeatures.h"
+#include "SaveGameSystem.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//"OPSV". ReadSlot checks this before it decompresses anything in the slot.
+static constexpr uint32 SaveGameMagic = 0x4F505356;
+
+//The size of the header that comes before the compressed data in every slot: the magic number, the format version and the uncompressed size.
+static constexpr int32 SlotHeaderSize = sizeof(uint32) + sizeof(int32) * 2;
+
+//The most that a slot is allowed to decompress to. Used to reject corrupted sizes before anything is allocated.
+static constexpr int32 MaxSlotSize = 16 * 1024 * 1024;
+
+void UOPSaveSubsystem::Deinitialize()
+{
+	//The save game is packed before it's written, so a save that is still being written is always finished, rather than lost.
+	if (WriteTask.IsValid()) WriteTask.Wait();
+	if (ReadTask.IsValid()) ReadTask.Wait();
+
+	for (FOPPendingSave& Index : QueuedSaves)
+	{
+		StartWrite(MoveTemp(Index));
+		WriteTask.Wait();
+	}
+
+	QueuedSaves.Empty();
+	Journals.Empty();
+
+	LoadedSave = nullptr;
+	PendingLoad = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UOPSaveSubsystem::SaveGame(const FString& SlotName)
+{
+	TObjectPtr<UWorld> World = GetGameInstance()->GetWorld();
+
+	if (!IsValid(World)) return false;
+
+	TObjectPtr<UOPEconomySubsystem> Economy = World->GetSubsystem<UOPEconomySubsystem>();
+
+	//A delta can only follow on from a journal that was written from this world, and only while the journal is still small next to its full save.
+	FOPSaveJournal* Journal = Journals.Find(SlotName);
+
+	const bool bWriteDelta = Journal && Journal->World == World && Journal->DeltaCount < MaxJournalDeltas && Journal->JournalSize <= Journal->BaseSize * MaxJournalFraction
+		&& IsValid(Economy) && Journal->TransactionCount <= Economy->GetTransactionLog().Num();
+
+	TObjectPtr<UOPSaveGame> NewSave = CaptureGameState(bWriteDelta ? Journal->TransactionCount : 0);
+
+	if (!IsValid(NewSave)) return false;
+
+	//Only the generated objects that changed since the last save are written to a delta. Either way, they are up to date on disk from now on.
+	TObjectPtr<UOPAreaStreamingSubsystem> AreaStreaming = World->GetSubsystem<UOPAreaStreamingSubsystem>();
+
+	if (IsValid(AreaStreaming))
+	{
+		AreaStreaming->WriteToSaveGame(NewSave, bWriteDelta);
+		AreaStreaming->ClearDirtyRecords();
+	}
+
+	if (bWriteDelta)
+	{
+		NewSave->DeltaIndex = ++Journal->DeltaCount;
+	}
+	else
+	{
+		//A full save starts a new journal. Deltas left over from the previous one no longer match its ID, so they are never applied.
+		Journal = &Journals.Emplace(SlotName);
+		Journal->BaseId = FGuid::NewGuid();
+		Journal->World = World;
+	}
+
+	NewSave->BaseId = Journal->BaseId;
+	Journal->TransactionCount = NewSave->FirstTransaction + NewSave->TransactionLog.Num();
+
+	//Packing the save game is a single pass over a few small arrays, so it's done straight away. Everything that takes time happens in the background.
+	FOPPendingSave PendingSave;
+	PendingSave.SlotName = bWriteDelta ? GetDeltaSlotName(SlotName, NewSave->DeltaIndex) : SlotName;
+	PendingSave.Magic = SaveGameMagic;
+	PendingSave.Version = static_cast<int32>(EOPSaveVersion::Latest);
+
+	FMemoryWriter Writer(PendingSave.Bytes);
+	NewSave->SerializeSaveData(Writer, EOPSaveVersion::Latest);
+
+	LastSaveSize = PendingSave.Bytes.Num();
+	bLastSaveWasDelta = bWriteDelta;
+
+	if (bWriteDelta)
+	{
+		Journal->JournalSize += LastSaveSize;
+	}
+	else
+	{
+		Journal->BaseSize = LastSaveSize;
+	}
+
+	WriteSlot(MoveTemp(PendingSave));
+
+	return true;
+}
+
+bool UOPSaveSubsystem::LoadGame(const FString& SlotName)
+{
+	return ReadSlot(SlotName, SaveGameMagic, static_cast<int32>(EOPSaveVersion::Latest), FOPSlotReadDelegate::CreateUObject(this, &UOPSaveSubsystem::OnSaveGameRead, SlotName, 0));
+}
+
+bool UOPSaveSubsystem::DoesSaveExist(const FString& SlotName) const
+{
+	return UGameplayStatics::DoesSaveGameExist(SlotName, UserIndex);
+}
+
+void UOPSaveSubsystem::WriteSlot(FOPPendingSave&& Save)
+{
+	//Only one slot is written at a time, so that two writes to the same slot never race each other.
+	if (bIsWriting)
+	{
+		FOPPendingSave* QueuedSave = QueuedSaves.FindByPredicate([&Save](const FOPPendingSave& Index) { return Index.SlotName == Save.SlotName; });
+
+		if (QueuedSave)
+		{
+			*QueuedSave = MoveTemp(Save);
+		}
+		else
+		{
+			QueuedSaves.Emplace(MoveTemp(Save));
+		}
+
+		return;
+	}
+
+	StartWrite(MoveTemp(Save));
+}
+
+bool UOPSaveSubsystem::ReadSlot(const FString& SlotName, uint32 Magic, int32 MaxVersion, FOPSlotReadDelegate OnRead)
+{
+	if (bIsReading) return false;
+
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+
+	if (!SaveSystem) return false;
+
+	bIsReading = true;
+
+	ReadTask = Async(EAsyncExecution::ThreadPool, [WeakThis = TWeakObjectPtr<UOPSaveSubsystem>(this), SaveSystem, SlotName, ExpectedMagic = Magic, MaxVersion, OnRead = MoveTemp(OnRead), SaveUserIndex = UserIndex]()
+		{
+			TArray<uint8> FileBytes;
+			TArray<uint8> Bytes;
+
+			uint32 Magic = 0;
+			int32 Version = 0;
+			int32 UncompressedSize = 0;
+
+			if (SaveSystem->LoadGame(false, *SlotName, SaveUserIndex, FileBytes) && FileBytes.Num() > SlotHeaderSize)
+			{
+				FMemoryReader Reader(FileBytes);
+				Reader << Magic << Version << UncompressedSize;
+
+				//Slots written by a newer version of the game can't be read, since there is no way of knowing what was added to them.
+				const bool bIsValidHeader = Magic == ExpectedMagic && Version >= 1 && Version <= MaxVersion && UncompressedSize > 0 && UncompressedSize <= MaxSlotSize;
+
+				if (bIsValidHeader)
+				{
+					Bytes.SetNumUninitialized(UncompressedSize);
+
+					if (!FCompression::UncompressMemory(NAME_Oodle, Bytes.GetData(), UncompressedSize, FileBytes.GetData() + SlotHeaderSize, FileBytes.Num() - SlotHeaderSize)) Bytes.Empty();
+				}
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, OnRead, Bytes = MoveTemp(Bytes), Version]()
+				{
+					if (!WeakThis.IsValid()) return;
+
+					WeakThis->bIsReading = false;
+					OnRead.ExecuteIfBound(Bytes, Version);
+				});
+		});
+
+	return true;
+}
+
+void UOPSaveSubsystem::ClearLoadedSave()
+{
+	//The save game has now been applied to this world, so the next save to its slot can carry on with its journal.
+	FOPSaveJournal* Journal = Journals.Find(LoadedSlotName);
+
+	if (IsValid(LoadedSave) && Journal) Journal->World = GetGameInstance()->GetWorld();
+
+	LoadedSave = nullptr;
+	LoadedSlotName.Reset();
+}
+
+UOPSaveGame* UOPSaveSubsystem::CaptureGameState(int32 FirstTransaction)
+{
+	TObjectPtr<UWorld> World = GetGameInstance()->GetWorld();
+
+	if (!IsValid(World)) return nullptr;
+
+	TObjectPtr<AOutpostGameModeBase> GameMode = Cast<AOutpostGameModeBase>(World->GetAuthGameMode());
+	TObjectPtr<AOPPlayer> Player = Cast<AOPPlayer>(UGameplayStatics::GetPlayerCharacter(World, 0));
+
+	if (!IsValid(GameMode) || !IsValid(Player)) return nullptr;
+
+	TObjectPtr<UOPSaveGame> NewSave = NewObject<UOPSaveGame>(this);
+	NewSave->SaveTime = FDateTime::UtcNow();
+
+	GameMode->WriteToSaveGame(NewSave);
+	Player->WriteToSaveGame(NewSave);
+
+	//Rewards that were earned this frame are applied first, so that they aren't left out of the save.
+	TObjectPtr<UOPEconomySubsystem> Economy = World->GetSubsystem<UOPEconomySubsystem>();
+
+	if (IsValid(Economy))
+	{
+		Economy->FlushLedger();
+
+		const TArray<FEconomyTransaction>& TransactionLog = Economy->GetTransactionLog();
+
+		NewSave->FirstTransaction = FMath::Clamp(FirstTransaction, 0, TransactionLog.Num());
+		NewSave->TransactionLog.Append(TransactionLog.GetData() + NewSave->FirstTransaction, TransactionLog.Num() - NewSave->FirstTransaction);
+	}
+
+	return NewSave;
+}
+
+void UOPSaveSubsystem::StartWrite(FOPPendingSave&& Save)
+{
+	ISaveGameSystem* SaveSystem = IPlatformFeaturesModule::Get().GetSaveGameSystem();
+
+	if (!SaveSystem)
+	{
+		OnSaveComplete.Broadcast(Save.SlotName, false);
+		return;
+	}
+
+	bIsWriting = true;
+
+	WriteTask = Async(EAsyncExecution::ThreadPool, [WeakThis = TWeakObjectPtr<UOPSaveSubsystem>(this), SaveSystem, Save = MoveTemp(Save), SaveUserIndex = UserIndex]()
+		{
+			const double WriteStartTime = FPlatformTime::Seconds();
+
+			uint32 Magic = Save.Magic;
+			int32 Version = Save.Version;
+			int32 UncompressedSize = Save.Bytes.Num();
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, UncompressedSize);
+
+			//The header is written uncompressed, so that the version can be checked before anything is decompressed.
+			TArray<uint8> FileBytes;
+			FMemoryWriter Writer(FileBytes);
+			Writer << Magic << Version << UncompressedSize;
+
+			FileBytes.SetNumUninitialized(SlotHeaderSize + CompressedSize);
+
+			bool bSuccess = FCompression::CompressMemory(NAME_Oodle, FileBytes.GetData() + SlotHeaderSize, CompressedSize, Save.Bytes.GetData(), UncompressedSize);
+
+			if (bSuccess)
+			{
+				FileBytes.SetNum(SlotHeaderSize + CompressedSize);
+				bSuccess = SaveSystem->SaveGame(false, *Save.SlotName, SaveUserIndex, FileBytes);
+			}
+
+			const float WriteTimeMs = (FPlatformTime::Seconds() - WriteStartTime) * 1000.0;
+
+			AsyncTask(ENamedThreads::GameThread, [WeakThis, SlotName = Save.SlotName, bSuccess, FileSize = FileBytes.Num(), WriteTimeMs]()
+				{
+					if (WeakThis.IsValid()) WeakThis->OnWriteComplete(SlotName, bSuccess, FileSize, WriteTimeMs);
+				});
+		});
+}
+
+void UOPSaveSubsystem::OnWriteComplete(const FString& SlotName, bool bSuccess, int32 CompressedSize, float WriteTimeMs)
+{
+	bIsWriting = false;
+	LastCompressedSize = CompressedSize;
+	LastWriteTimeMs = WriteTimeMs;
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Could not write the save slot %s."), *SlotName);
+
+		//If any part of a journal couldn't be written, the next save to its slot is a full one, so that nothing depends on what was lost.
+		for (TMap<FString, FOPSaveJournal>::TIterator It = Journals.CreateIterator(); It; ++It)
+		{
+			if (SlotName == It.Key() || SlotName.StartsWith(It.Key() + TEXT("_Delta"))) It.RemoveCurrent();
+		}
+	}
+
+	OnSaveComplete.Broadcast(SlotName, bSuccess);
+
+	if (!QueuedSaves.IsEmpty())
+	{
+		FOPPendingSave NextSave = MoveTemp(QueuedSaves[0]);
+		QueuedSaves.RemoveAt(0);
+
+		StartWrite(MoveTemp(NextSave));
+	}
+}
+
+FString UOPSaveSubsystem::GetDeltaSlotName(const FString& SlotName, int32 DeltaIndex)
+{
+	return FString::Printf(TEXT("%s_Delta%d"), *SlotName, DeltaIndex);
+}
+
+void UOPSaveSubsystem::OnSaveGameRead(const TArray<uint8>& Bytes, int32 Version, FString SlotName, int32 DeltaIndex)
+{
+	//The journal ends at the first delta that doesn't exist. Everything before it is still loaded.
+	if (Bytes.IsEmpty() && DeltaIndex > 0)
+	{
+		FinishLoad(SlotName);
+		return;
+	}
+
+	if (Bytes.IsEmpty())
+	{
+		UE_LOG(LogOutpost, Warning, TEXT("Could not read the save game %s."), *SlotName);
+
+		OnLoadComplete.Broadcast(SlotName, false);
+		return;
+	}
+
+	TObjectPtr<UOPSaveGame> NewSave = NewObject<UOPSaveGame>(this);
+
+	FMemoryReader Reader(Bytes);
+	NewSave->SerializeSaveData(Reader, static_cast<EOPSaveVersion>(Version));
+
+	if (DeltaIndex == 0)
+	{
+		if (Reader.IsError() || NewSave->IsDelta())
+		{
+			UE_LOG(LogOutpost, Warning, TEXT("The save game %s is corrupted."), *SlotName);
+
+			OnLoadComplete.Broadcast(SlotName, false);
+			return;
+		}
+
+		PendingLoad = NewSave;
+
+		PendingJournal = FOPSaveJournal();
+		PendingJournal.BaseId = NewSave->BaseId;
+		PendingJournal.BaseSize = Bytes.Num();
+	}
+	else if (Reader.IsError() || !IsValid(PendingLoad) || !PendingLoad->ApplyDelta(NewSave))
+	{
+		//Deltas that were left over from an older full save, or that were never fully written, also end the journal.
+		FinishLoad(SlotName);
+		return;
+	}
+	else
+	{
+		PendingJournal.DeltaCount = DeltaIndex;
+		PendingJournal.JournalSize += Bytes.Num();
+	}
+
+	//Save games from before the journal was added never have any deltas.
+	const bool bHasJournal = PendingLoad->BaseId.IsValid();
+
+	if (!bHasJournal || !ReadSlot(GetDeltaSlotName(SlotName, DeltaIndex + 1), SaveGameMagic, static_cast<int32>(EOPSaveVersion::Latest), FOPSlotReadDelegate::CreateUObject(this, &UOPSaveSubsystem::OnSaveGameRead, SlotName, DeltaIndex + 1))) FinishLoad(SlotName);
+}
+
+void UOPSaveSubsystem::FinishLoad(const FString& SlotName)
+{
+	if (!IsValid(PendingLoad)) return;
+
+	LoadedSave = PendingLoad;
+	LoadedSlotName = SlotName;
+	PendingLoad = nullptr;
+
+	//The journal only carries on once the save game has been applied to a world, since until then the world doesn't match it.
+	if (LoadedSave->BaseId.IsValid())
+	{
+		PendingJournal.TransactionCount = LoadedSave->TransactionLog.Num();
+		PendingJournal.World = nullptr;
+
+		Journals.Emplace(SlotName, PendingJournal);
+	}
+	else
+	{
+		Journals.Remove(SlotName);
+	}
+
+	OnLoadComplete.Broadcast(SlotName, true);
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPShopSubsystem.h"
+#include "Subsystems/OPEconomySubsystem.h"
+#include "Data/OPShopCatalog.h"
+#include "Interfaces/OPCharacterInterface.h"
+#include "Outpost.h"
+#include "Engine/AssetManager.h"
+
+void UOPShopSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Economy = Collection.InitializeDependency<UOPEconomySubsystem>();
+}
+
+void UOPShopSubsystem::Deinitialize()
+{
+	ReleaseAllHandles();
+
+	Super::Deinitialize();
+}
+
+void UOPShopSubsystem::SetCatalog(UOPShopCatalog* NewCatalog)
+{
+	ReleaseAllHandles();
+
+	Catalog = NewCatalog;
+}
+
+void UOPShopSubsystem::PreloadItem(int32 ItemIndex)
+{
+	const FShopItem* Item = GetItem(ItemIndex);
+
+	if (!Item) return;
+
+	//If the item is already preloaded, it just becomes the most recently hovered one.
+	if (PreloadHandles.Contains(ItemIndex))
+	{
+		PreloadOrder.Remove(ItemIndex);
+		PreloadOrder.Emplace(ItemIndex);
+		return;
+	}
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+	GetItemAssets(*Item, AssetsToLoad);
+
+	if (AssetsToLoad.IsEmpty()) return;
+
+	//The handle is kept even if everything is already loaded, so that the assets stay in memory while the item is preloaded.
+	PreloadHandles.Emplace(ItemIndex, UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetsToLoad, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority));
+	PreloadOrder.Emplace(ItemIndex);
+	PreloadsStarted++;
+
+	//Release the item that was hovered longest ago, if there are too many preloaded items.
+	while (PreloadOrder.Num() > FMath::Max(MaxPreloadedItems, 1))
+	{
+		TSharedPtr<FStreamableHandle> OldestHandle;
+		PreloadHandles.RemoveAndCopyValue(PreloadOrder[0], OldestHandle);
+		PreloadOrder.RemoveAt(0);
+
+		if (OldestHandle.IsValid()) OldestHandle->ReleaseHandle();
+		PreloadsEvicted++;
+	}
+}
+
+bool UOPShopSubsystem::PurchaseItem(int32 ItemIndex, AActor* Buyer)
+{
+	const FShopItem* Item = GetItem(ItemIndex);
+
+	if (!Item || !IsValid(Buyer) || !Buyer->Implements<UOPCharacterInterface>() || !IsValid(Economy)) return false;
+
+	//The player isn't charged for ammo that they have no room for.
+	if (Item->WeaponClass.IsNull() && IOPCharacterInterface::Execute_IsPlayerReserveAmmoMaxedOut(Buyer, Item->AmmoType)) return false;
+
+	if (!Economy->SpendCash(Item->Price)) return false;
+
+	TArray<FSoftObjectPath> ItemAssets;
+	GetItemAssets(*Item, ItemAssets);
+
+	//Items without any assets, such as ammo, can always be delivered right away.
+	const bool bIsResident = ItemAssets.IsEmpty() || IsItemResident(ItemIndex);
+
+	if (bIsResident)
+	{
+		if (!ItemAssets.IsEmpty()) PreloadHits++;
+
+		if (DeliverItem(ItemIndex, Buyer, true)) return true;
+
+		Economy->RefundCash(Item->Price);
+		return false;
+	}
+
+	//The item was bought before it finished loading, so it will be delivered once it has. It's still paid for now, so the cash can't be spent twice.
+	PreloadMisses++;
+
+	const int32 DeliveryId = NextDeliveryId++;
+
+	FOPPendingDelivery& Delivery = PendingDeliveries.Emplace(DeliveryId);
+	Delivery.ItemIndex = ItemIndex;
+	Delivery.Price = Item->Price;
+	Delivery.Buyer = Buyer;
+	Delivery.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(ItemAssets, FStreamableDelegate::CreateUObject(this, &UOPShopSubsystem::OnPendingDeliveryLoaded, DeliveryId), FStreamableManager::AsyncLoadHighPriority);
+
+	return true;
+}
+
+bool UOPShopSubsystem::IsItemResident(int32 ItemIndex) const
+{
+	const FShopItem* Item = GetItem(ItemIndex);
+
+	if (!Item) return false;
+
+	TArray<FSoftObjectPath> ItemAssets;
+	GetItemAssets(*Item, ItemAssets);
+
+	for (const FSoftObjectPath& Index : ItemAssets)
+	{
+		if (!Index.ResolveObject()) return false;
+	}
+
+	return true;
+}
+
+const FShopItem* UOPShopSubsystem::GetItem(int32 ItemIndex) const
+{
+	return IsValid(Catalog) && Catalog->Items.IsValidIndex(ItemIndex) ? &Catalog->Items[ItemIndex] : nullptr;
+}
+
+void UOPShopSubsystem::GetItemAssets(const FShopItem& Item, TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (!Item.WeaponClass.IsNull()) OutAssets.AddUnique(Item.WeaponClass.ToSoftObjectPath());
+
+	for (const TSoftObjectPtr<UObject>& Index : Item.AdditionalAssets)
+	{
+		if (!Index.IsNull()) OutAssets.AddUnique(Index.ToSoftObjectPath());
+	}
+}
+
+void UOPShopSubsystem::ReleaseAllHandles()
+{
+	for (TPair<int32, TSharedPtr<FStreamableHandle>>& Index : PreloadHandles)
+	{
+		if (Index.Value.IsValid()) Index.Value->ReleaseHandle();
+	}
+
+	for (TPair<int32, FOPPendingDelivery>& Index : PendingDeliveries)
+	{
+		if (Index.Value.Handle.IsValid()) Index.Value.Handle->CancelHandle();
+
+		//The item was paid for, but will never be delivered.
+		if (IsValid(Economy)) Economy->RefundCash(Index.Value.Price);
+	}
+
+	PreloadHandles.Empty();
+	PreloadOrder.Empty();
+	PendingDeliveries.Empty();
+}
+
+void UOPShopSubsystem::OnPendingDeliveryLoaded(int32 DeliveryId)
+{
+	FOPPendingDelivery Delivery;
+
+	if (!PendingDeliveries.RemoveAndCopyValue(DeliveryId, Delivery)) return;
+
+	const bool bWasDelivered = Delivery.Buyer.IsValid() && DeliverItem(Delivery.ItemIndex, Delivery.Buyer.Get(), false);
+
+	//The buyer is gone, or the item failed to load, so the cash is given back.
+	if (!bWasDelivered && IsValid(Economy)) Economy->RefundCash(Delivery.Price);
+
+	if (Delivery.Handle.IsValid()) Delivery.Handle->ReleaseHandle();
+}
+
+bool UOPShopSubsystem::DeliverItem(int32 ItemIndex, AActor* Buyer, bool bWasResident)
+{
+	const FShopItem* Item = GetItem(ItemIndex);
+
+	if (!Item || !IsValid(Buyer)) return false;
+
+	if (Item->WeaponClass.IsNull())
+	{
+		IOPCharacterInterface::Execute_PickUpAmmo(Buyer, Item->AmmoType, Item->AmmoAmount);
+	}
+	else
+	{
+		//The weapon class is already resident, so this never loads anything synchronously.
+		TSubclassOf<AOPWeapon> WeaponClass = Item->WeaponClass.Get();
+
+		if (!IsValid(WeaponClass))
+		{
+			UE_LOG(LogOutpost, Warning, TEXT("Shop item %d could not be loaded."), ItemIndex);
+			return false;
+		}
+
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+		TObjectPtr<AOPWeapon> NewWeapon = GetWorld()->SpawnActor<AOPWeapon>(WeaponClass, Buyer->GetActorTransform(), SpawnParams);
+
+		if (!IsValid(NewWeapon)) return false;
+
+		IOPCharacterInterface::Execute_PickUpWeapon(Buyer, NewWeapon);
+	}
+
+	OnPurchaseDelivered.Broadcast(ItemIndex, bWasResident);
+
+	return true;
+}
\ No newline at end of file
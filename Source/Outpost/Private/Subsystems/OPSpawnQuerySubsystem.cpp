@@ -0,0 +1,239 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPSpawnQuerySubsystem.h"
+#include "Subsystems/OPTraceBatchSubsystem.h"
+#include "Subsystems/OPWorldSubsystem.h"
+#include "NavigationSystem.h"
+#include "Kismet/GameplayStatics.h"
+
+void UOPSpawnQuerySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Visibility checks are sent out through the shared trace batch.
+	TraceBatchSubsystem = Collection.InitializeDependency<UOPTraceBatchSubsystem>();
+}
+
+void UOPSpawnQuerySubsystem::Deinitialize()
+{
+	ActiveQueries.Empty();
+	CachedPlacements.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPSpawnQuerySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (ActiveQueries.Num() <= 0) return;
+
+	TArray<int32> FinishedQueries;
+
+	for (TPair<int32, FOPSpawnQuery>& Query : ActiveQueries)
+	{
+		ProjectCandidatesToNavmesh(Query.Key, Query.Value);
+
+		//A query is finished once every candidate has been projected, and every visibility check has come back.
+		if (Query.Value.NextCandidateIndex >= Query.Value.Candidates.Num() && Query.Value.PendingTraceCount <= 0) FinishedQueries.Emplace(Query.Key);
+	}
+
+	for (int32 Index : FinishedQueries)
+	{
+		FinishQuery(Index);
+	}
+}
+
+TStatId UOPSpawnQuerySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPSpawnQuerySubsystem, STATGROUP_Tickables);
+}
+
+void UOPSpawnQuerySubsystem::SetSpawnArea(const FBox& NewSpawnArea)
+{
+	SpawnArea = NewSpawnArea;
+
+	ClearCachedPlacements();
+}
+
+void UOPSpawnQuerySubsystem::ClearCachedPlacements()
+{
+	CachedPlacements.Empty();
+}
+
+void UOPSpawnQuerySubsystem::RequestPlacements(int32 WaveIndex, int32 NumPlacements, FOPSpawnPlacementsDelegate Callback)
+{
+	//If this wave's placements have already been found, then they can be handed out right away.
+	if (const TArray<FVector>* Cached = CachedPlacements.Find(WaveIndex))
+	{
+		if (Cached->Num() >= NumPlacements)
+		{
+			Callback.ExecuteIfBound(TArray<FVector>(Cached->GetData(), NumPlacements));
+			return;
+		}
+	}
+
+	const int32 QueryId = NextQueryId++;
+
+	FOPSpawnQuery& Query = ActiveQueries.Add(QueryId);
+	Query.WaveIndex = WaveIndex;
+	Query.NumPlacements = NumPlacements;
+	Query.Callback = MoveTemp(Callback);
+
+	StartQuery(Query);
+}
+
+void UOPSpawnQuerySubsystem::StartQuery(FOPSpawnQuery& Query)
+{
+	if (!HasSpawnArea() || CandidateSpacing <= 0.f || OccupancyCellSize <= 0.f) return;
+
+	//Get the player's point of view, and the location of the outpost.
+	FRotator ViewRotation = FRotator::ZeroRotator;
+	TObjectPtr<APlayerController> PlayerController = UGameplayStatics::GetPlayerController(this, 0);
+
+	if (IsValid(PlayerController)) PlayerController->GetPlayerViewPoint(Query.ViewLocation, ViewRotation);
+
+	const FVector ViewDirection = ViewRotation.Vector().GetSafeNormal2D();
+
+	TObjectPtr<UOPWorldSubsystem> WorldSubsystem = GetWorld()->GetSubsystem<UOPWorldSubsystem>();
+	const FVector OutpostLocation = IsValid(WorldSubsystem) ? WorldSubsystem->OutpostLocation : FVector::ZeroVector;
+
+	//Cells that already have a live enemy in them are considered occupied.
+	TSet<FIntPoint> OccupiedCells;
+
+	if (IsValid(WorldSubsystem))
+	{
+		for (TObjectPtr<AActor> Index : WorldSubsystem->EnemyArray)
+		{
+			if (IsValid(Index)) OccupiedCells.Emplace(FIntPoint(FMath::FloorToInt(Index->GetActorLocation().X / OccupancyCellSize), FMath::FloorToInt(Index->GetActorLocation().Y / OccupancyCellSize)));
+		}
+	}
+
+	//Only the best-scoring candidate in each occupancy cell is kept, so that placements stay spread out.
+	TMap<FIntPoint, FOPSpawnCandidate> BestCandidatePerCell;
+
+	const float MinOutpostDistanceSquared = FMath::Square(MinOutpostDistance);
+	const float MinPlayerDistanceSquared = FMath::Square(MinPlayerDistance);
+
+	for (float X = SpawnArea.Min.X; X <= SpawnArea.Max.X; X += CandidateSpacing)
+	{
+		for (float Y = SpawnArea.Min.Y; Y <= SpawnArea.Max.Y; Y += CandidateSpacing)
+		{
+			const FVector Location = FVector(X, Y, SpawnArea.GetCenter().Z);
+
+			//Cheap tests first: candidates that are too close to the outpost or the player are thrown out right away.
+			if (FVector::DistSquared2D(Location, OutpostLocation) < MinOutpostDistanceSquared) continue;
+			if (FVector::DistSquared2D(Location, Query.ViewLocation) < MinPlayerDistanceSquared) continue;
+
+			const FIntPoint Cell = FIntPoint(FMath::FloorToInt(X / OccupancyCellSize), FMath::FloorToInt(Y / OccupancyCellSize));
+
+			if (OccupiedCells.Contains(Cell)) continue;
+
+			/*
+			Candidates score higher the closer they are to the preferred distance from the outpost...
+			...And the further they are from where the player is currently looking.
+			*/
+			const float OutpostDistance = FVector::Dist2D(Location, OutpostLocation);
+			const FVector DirectionFromPlayer = (Location - Query.ViewLocation).GetSafeNormal2D();
+
+			FOPSpawnCandidate Candidate;
+			Candidate.Location = Location;
+			Candidate.Score = 1.f - FMath::Abs(OutpostDistance - PreferredOutpostDistance) / FMath::Max(PreferredOutpostDistance, 1.f);
+			Candidate.Score += 0.5f * (1.f - FVector::DotProduct(ViewDirection, DirectionFromPlayer));
+
+			FOPSpawnCandidate* Existing = BestCandidatePerCell.Find(Cell);
+
+			if (!Existing || Existing->Score < Candidate.Score) BestCandidatePerCell.Add(Cell, Candidate);
+		}
+	}
+
+	BestCandidatePerCell.GenerateValueArray(Query.Candidates);
+
+	//If there are too many candidates, only the best-scoring ones are checked any further.
+	if (Query.Candidates.Num() > MaxCandidates)
+	{
+		Query.Candidates.Sort([](const FOPSpawnCandidate& a, const FOPSpawnCandidate& b) {return a.Score > b.Score;});
+		Query.Candidates.SetNum(MaxCandidates);
+	}
+}
+
+void UOPSpawnQuerySubsystem::ProjectCandidatesToNavmesh(int32 QueryId, FOPSpawnQuery& Query)
+{
+	TObjectPtr<UNavigationSystemV1> NavigationSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+
+	const FVector QueryExtent = FVector(CandidateSpacing * 0.5f, CandidateSpacing * 0.5f, SpawnArea.GetExtent().Z + CandidateEyeHeight);
+
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(OPSpawnVisibility), false);
+
+	if (IsValid(UGameplayStatics::GetPlayerPawn(this, 0))) TraceParams.AddIgnoredActor(UGameplayStatics::GetPlayerPawn(this, 0));
+
+	const int32 LastCandidateIndex = FMath::Min(Query.NextCandidateIndex + MaxNavProjectionsPerFrame, Query.Candidates.Num());
+
+	for (; Query.NextCandidateIndex < LastCandidateIndex; Query.NextCandidateIndex++)
+	{
+		FOPSpawnCandidate Candidate = Query.Candidates[Query.NextCandidateIndex];
+
+		//Candidates that aren't on the navmesh are thrown out, since enemies wouldn't be able to path from them.
+		if (IsValid(NavigationSystem))
+		{
+			FNavLocation NavLocation;
+
+			if (!NavigationSystem->ProjectPointToNavigation(Candidate.Location, NavLocation, QueryExtent)) continue;
+
+			Candidate.Location = NavLocation.Location;
+		}
+
+		//Only the survivors are checked for visibility. If the line of sight is blocked, then the player can't see the candidate.
+		const FVector EyeLocation = Candidate.Location + FVector(0.f, 0.f, CandidateEyeHeight);
+
+		Query.PendingTraceCount++;
+
+		if (IsValid(TraceBatchSubsystem))
+		{
+			TraceBatchSubsystem->QueueLineTrace(Query.ViewLocation, EyeLocation, ECC_Visibility, TraceParams, FOPTraceBatchDelegate::CreateUObject(this, &UOPSpawnQuerySubsystem::OnVisibilityTraceComplete, QueryId, Candidate));
+		}
+		//If the trace batch isn't available, then the candidate is traced right away instead.
+		else
+		{
+			FHitResult HitResult;
+			const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(HitResult, Query.ViewLocation, EyeLocation, ECC_Visibility, TraceParams);
+
+			OnVisibilityTraceComplete(HitResult, bBlockingHit, QueryId, Candidate);
+		}
+	}
+}
+
+void UOPSpawnQuerySubsystem::OnVisibilityTraceComplete(const FHitResult& HitResult, bool bBlockingHit, int32 QueryId, FOPSpawnCandidate Candidate)
+{
+	FOPSpawnQuery* Query = ActiveQueries.Find(QueryId);
+
+	if (!Query) return;
+
+	Query->PendingTraceCount--;
+
+	//Candidates that the player can see are kept as a last resort, but always rank below hidden ones.
+	if (!bBlockingHit) Candidate.Score -= 100.f;
+
+	Query->CheckedCandidates.Emplace(Candidate);
+}
+
+void UOPSpawnQuerySubsystem::FinishQuery(int32 QueryId)
+{
+	FOPSpawnQuery Query;
+
+	if (!ActiveQueries.RemoveAndCopyValue(QueryId, Query)) return;
+
+	Query.CheckedCandidates.Sort([](const FOPSpawnCandidate& a, const FOPSpawnCandidate& b) {return a.Score > b.Score;});
+
+	//Only the top results are kept, and cached for the rest of the wave.
+	TArray<FVector> Placements;
+
+	for (int32 i = 0; i < FMath::Min(Query.NumPlacements, Query.CheckedCandidates.Num()); i++)
+	{
+		Placements.Emplace(Query.CheckedCandidates[i].Location);
+	}
+
+	CachedPlacements.Add(Query.WaveIndex, Placements);
+
+	Query.Callback.ExecuteIfBound(Placements);
+}
\ No newline at end of file
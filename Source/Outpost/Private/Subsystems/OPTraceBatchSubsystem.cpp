@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPTraceBatchSubsystem.h"
+
+void UOPTraceBatchSubsystem::Deinitialize()
+{
+	QueuedTraces.Empty();
+	InFlightTraces.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPTraceBatchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	//Results from last frame's batch are handed out first, so that callbacks can queue up traces for this frame's batch.
+	ResolveInFlightTraces();
+	IssueQueuedTraces();
+}
+
+TStatId UOPTraceBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPTraceBatchSubsystem, STATGROUP_Tickables);
+}
+
+void UOPTraceBatchSubsystem::QueueLineTrace(const FVector& Start, const FVector& End, ECollisionChannel Channel, const FCollisionQueryParams& Params, FOPTraceBatchDelegate Callback)
+{
+	FOPQueuedTrace& Trace = QueuedTraces.AddDefaulted_GetRef();
+	Trace.Start = Start;
+	Trace.End = End;
+	Trace.Channel = Channel;
+	Trace.Params = Params;
+	Trace.Callback = MoveTemp(Callback);
+}
+
+void UOPTraceBatchSubsystem::ResolveInFlightTraces()
+{
+	if (InFlightTraces.Num() <= 0) return;
+
+	//Callbacks are allowed to queue new traces, so the in-flight traces are swapped out before any are called.
+	TArray<FOPInFlightTrace> ResolvingTraces = MoveTemp(InFlightTraces);
+	InFlightTraces.Reset();
+
+	for (FOPInFlightTrace& Index : ResolvingTraces)
+	{
+		FTraceDatum Datum;
+
+		if (GetWorld()->QueryTraceData(Index.Handle, Datum))
+		{
+			const bool bBlockingHit = Datum.OutHits.Num() > 0 && Datum.OutHits[0].bBlockingHit;
+
+			Index.Trace.Callback.ExecuteIfBound(bBlockingHit ? Datum.OutHits[0] : FHitResult(Datum.Start, Datum.End), bBlockingHit);
+		}
+		//Any trace whose results aren't ready yet gets checked again next frame...
+		else if (GetWorld()->IsTraceHandleValid(Index.Handle, false))
+		{
+			InFlightTraces.Emplace(MoveTemp(Index));
+		}
+		//...But if its results were lost, such as after a hitch, it's traced right away instead, since every caller is waiting on its callback.
+		else
+		{
+			FHitResult HitResult(Index.Trace.Start, Index.Trace.End);
+			const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(HitResult, Index.Trace.Start, Index.Trace.End, Index.Trace.Channel, Index.Trace.Params);
+
+			Index.Trace.Callback.ExecuteIfBound(HitResult, bBlockingHit);
+		}
+	}
+}
+
+void UOPTraceBatchSubsystem::IssueQueuedTraces()
+{
+	TracesIssuedLastFrame = 0;
+
+	while (NextQueuedTraceIndex < QueuedTraces.Num() && TracesIssuedLastFrame < MaxTracesPerFrame)
+	{
+		FOPQueuedTrace& Trace = QueuedTraces[NextQueuedTraceIndex++];
+
+		FOPInFlightTrace& InFlight = InFlightTraces.AddDefaulted_GetRef();
+		InFlight.Handle = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Trace.Start, Trace.End, Trace.Channel, Trace.Params);
+		InFlight.Trace = MoveTemp(Trace);
+
+		TracesIssuedLastFrame++;
+	}
+
+	TotalTracesIssued += TracesIssuedLastFrame;
+
+	//Once every queued trace has been sent out, the queue can be reused without reallocating.
+	if (NextQueuedTraceIndex >= QueuedTraces.Num())
+	{
+		QueuedTraces.Reset();
+		NextQueuedTraceIndex = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Subsystems/OPTurretSubsystem.h"
+#include "Subsystems/OPEnemyGridSubsystem.h"
+#include "Subsystems/OPTraceBatchSubsystem.h"
+#include "Items/OPTurret.h"
+#include "Items/OPWeapon.h"
+#include "Characters/OPCharacterBase.h"
+#include "OPProfiling.h"
+
+void UOPTurretSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	EnemyGrid = Collection.InitializeDependency<UOPEnemyGridSubsystem>();
+	TraceBatch = Collection.InitializeDependency<UOPTraceBatchSubsystem>();
+}
+
+void UOPTurretSubsystem::Deinitialize()
+{
+	Turrets.Empty();
+	Pivots.Empty();
+	Facings.Empty();
+	Ranges.Empty();
+	MinAlignments.Empty();
+	NextFireTimes.Empty();
+	AwaitingSight.Empty();
+
+	Super::Deinitialize();
+}
+
+void UOPTurretSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	CandidatesTestedLastFrame = 0;
+	SightChecksLastFrame = 0;
+
+	if (Turrets.IsEmpty() || !IsValid(EnemyGrid)) return;
+
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	for (int32 i = 0; i < Turrets.Num(); i++)
+	{
+		//Turrets that are cooling down, reloading or waiting on a line of sight check are skipped.
+		if (AwaitingSight[i] || NextFireTimes[i] > CurrentTime) continue;
+
+		TObjectPtr<AOPTurret> Turret = Turrets[i];
+
+		if (!IsValid(Turret) || !IsValid(Turret->GetWeapon())) continue;
+
+		//An empty magazine means the turret's reload has just finished, so the weapon is only refilled now.
+		if (Turret->GetWeapon()->Stats.CurrentMagazine <= 0) Turret->GetWeapon()->ResetWeaponState();
+
+		TObjectPtr<AActor> Target = FindTarget(i);
+
+		if (!IsValid(Target)) continue;
+
+		//Line of sight is checked from the turret's pivot, so that the check doesn't depend on which way the turret is currently facing.
+		FCollisionQueryParams SightParams(SCENE_QUERY_STAT(OPTurretSight), false, Turret);
+		SightParams.AddIgnoredActor(Turret->GetWeapon());
+
+		const FVector AimLocation = GetAimLocation(Turret, Target);
+
+		AwaitingSight[i] = true;
+		SightChecksLastFrame++;
+		OP_COUNT_TRACE();
+
+		if (IsValid(TraceBatch))
+		{
+			TraceBatch->QueueLineTrace(Pivots[i], AimLocation, ECC_Visibility, SightParams, FOPTraceBatchDelegate::CreateUObject(this, &UOPTurretSubsystem::OnSightTraceComplete, TWeakObjectPtr<AOPTurret>(Turret), TWeakObjectPtr<AActor>(Target)));
+		}
+		else
+		{
+			FHitResult HitResult;
+			const bool bBlockingHit = GetWorld()->LineTraceSingleByChannel(HitResult, Pivots[i], AimLocation, ECC_Visibility, SightParams);
+
+			OnSightTraceComplete(HitResult, bBlockingHit, Turret, Target);
+		}
+	}
+}
+
+TStatId UOPTurretSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UOPTurretSubsystem, STATGROUP_Tickables);
+}
+
+void UOPTurretSubsystem::RegisterTurret(AOPTurret* Turret)
+{
+	if (!IsValid(Turret) || Turret->TurretIndex != INDEX_NONE) return;
+
+	Turret->TurretIndex = Turrets.Emplace(Turret);
+
+	Pivots.Emplace(Turret->GetPivotLocation());
+	Facings.Emplace(FVector2D(Turret->GetActorForwardVector()).GetSafeNormal());
+	Ranges.Emplace(Turret->Range);
+	MinAlignments.Emplace(FMath::Cos(FMath::DegreesToRadians(FMath::Clamp(Turret->ArcHalfAngle, 0.f, 180.f))));
+	NextFireTimes.Emplace(0.f);
+	AwaitingSight.Emplace(false);
+}
+
+void UOPTurretSubsystem::UnregisterTurret(AOPTurret* Turret)
+{
+	if (!IsValid(Turret) || !Turrets.IsValidIndex(Turret->TurretIndex) || Turrets[Turret->TurretIndex] != Turret) return;
+
+	const int32 RemovedIndex = Turret->TurretIndex;
+
+	//The last turret is moved into the removed turret's place, so the arrays stay packed.
+	Turrets.RemoveAtSwap(RemovedIndex, 1, false);
+	Pivots.RemoveAtSwap(RemovedIndex, 1, false);
+	Facings.RemoveAtSwap(RemovedIndex, 1, false);
+	Ranges.RemoveAtSwap(RemovedIndex, 1, false);
+	MinAlignments.RemoveAtSwap(RemovedIndex, 1, false);
+	NextFireTimes.RemoveAtSwap(RemovedIndex, 1, false);
+	AwaitingSight.RemoveAtSwap(RemovedIndex, 1, false);
+
+	if (Turrets.IsValidIndex(RemovedIndex) && IsValid(Turrets[RemovedIndex])) Turrets[RemovedIndex]->TurretIndex = RemovedIndex;
+
+	Turret->TurretIndex = INDEX_NONE;
+}
+
+AActor* UOPTurretSubsystem::FindTarget(int32 TurretIndex)
+{
+	const FVector Pivot = Pivots[TurretIndex];
+	const FVector2D Facing = Facings[TurretIndex];
+	const float RangeSquared = FMath::Square(Ranges[TurretIndex]);
+	const float MinAlignment = MinAlignments[TurretIndex];
+
+	Candidates.Reset();
+	EnemyGrid->QueryRadius(Pivot, Ranges[TurretIndex], Candidates);
+
+	const int32 CandidateCount = Candidates.Num();
+
+	if (CandidateCount == 0) return nullptr;
+
+	CandidatesTestedLastFrame += CandidateCount;
+
+	//Every candidate's offset from the turret is packed into flat arrays, so the tests below run as one branch-free loop.
+	CandidateX.SetNumUninitialized(CandidateCount, false);
+	CandidateY.SetNumUninitialized(CandidateCount, false);
+	CandidateZ.SetNumUninitialized(CandidateCount, false);
+	CandidateScores.SetNumUninitialized(CandidateCount, false);
+
+	for (int32 i = 0; i < CandidateCount; i++)
+	{
+		const FVector Offset = Candidates[i]->GetActorLocation() - Pivot;
+
+		CandidateX[i] = Offset.X;
+		CandidateY[i] = Offset.Y;
+		CandidateZ[i] = Offset.Z;
+	}
+
+	float* RESTRICT X = CandidateX.GetData();
+	float* RESTRICT Y = CandidateY.GetData();
+	float* RESTRICT Z = CandidateZ.GetData();
+	float* RESTRICT Scores = CandidateScores.GetData();
+
+	//Range and arc tests. Candidates that fail either are given the worst possible score, instead of being branched around.
+	for (int32 i = 0; i < CandidateCount; i++)
+	{
+		const float PlanarDistanceSquared = X[i] * X[i] + Y[i] * Y[i];
+		const float DistanceSquared = PlanarDistanceSquared + Z[i] * Z[i];
+		const float Alignment = X[i] * Facing.X + Y[i] * Facing.Y;
+
+		//Comparing against the scaled minimum alignment avoids normalizing every offset.
+		const bool bInArc = Alignment >= MinAlignment * FMath::Sqrt(PlanarDistanceSquared);
+		const bool bInRange = DistanceSquared <= RangeSquared;
+
+		Scores[i] = bInArc && bInRange ? DistanceSquared : MAX_flt;
+	}
+
+	//The closest enemy that passed both tests wins.
+	int32 BestIndex = INDEX_NONE;
+	float BestScore = MAX_flt;
+
+	for (int32 i = 0; i < CandidateCount; i++)
+	{
+		if (Scores[i] < BestScore)
+		{
+			BestScore = Scores[i];
+			BestIndex = i;
+		}
+	}
+
+	return BestIndex != INDEX_NONE ? Candidates[BestIndex] : nullptr;
+}
+
+void UOPTurretSubsystem::OnSightTraceComplete(const FHitResult& HitResult, bool bBlockingHit, TWeakObjectPtr<AOPTurret> Turret, TWeakObjectPtr<AActor> Target)
+{
+	if (!Turret.IsValid() || !Turrets.IsValidIndex(Turret->TurretIndex)) return;
+
+	const int32 TurretIndex = Turret->TurretIndex;
+	const float CurrentTime = GetWorld()->GetTimeSeconds();
+
+	AwaitingSight[TurretIndex] = false;
+
+	//If the target died in the meantime, or something is in the way, the turret looks again shortly.
+	if (!Target.IsValid() || !IsTargetValid(Target.Get()) || (bBlockingHit && HitResult.GetActor() != Target.Get()))
+	{
+		NextFireTimes[TurretIndex] = CurrentTime + RetargetDelay;
+		return;
+	}
+
+	TObjectPtr<AOPWeapon> Weapon = Turret->GetWeapon();
+
+	if (!IsValid(Weapon)) return;
+
+	//The target has had a frame to move, so the turret aims at where it is now.
+	const FVector AimLocation = GetAimLocation(Turret.Get(), Target.Get());
+
+	Turret->AimAt(AimLocation);
+
+	Weapon->FireFromMuzzle(AimLocation, Turret->AccuracyModifier);
+
+	//Turrets keep track of their own fire rate and reloads, so the weapon never has to start a timer. Once the magazine runs dry, the turret waits out its reload.
+	NextFireTimes[TurretIndex] = CurrentTime + (Weapon->Stats.CurrentMagazine > 0 ? Weapon->Stats.FireRate : Turret->ReloadTime);
+}
+
+FVector UOPTurretSubsystem::GetAimLocation(const AOPTurret* Turret, const AActor* Target) const
+{
+	return Target->GetActorLocation() + FVector(0.f, 0.f, Turret->AimHeightOffset);
+}
+
+bool UOPTurretSubsystem::IsTargetValid(const AActor* Target) const
+{
+	const AOPCharacterBase* Character = Cast<AOPCharacterBase>(Target);
+
+	return IsValid(Character) && !Character->IsCharacterDead() && !Character->IsHidden();
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Subsystems/OPWorldSubsystem.h"
+#include "OPProfiling.h"
 
 UOPWorldSubsystem::UOPWorldSubsystem()
 {
@@ -11,4 +12,74 @@ void UOPWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
 	
+}
+
+void UOPWorldSubsystem::SetProfilingEnabled(bool bEnabled)
+{
+#if OP_PROFILING_ENABLED
+	FOPProfiler::SetProfilingEnabled(bEnabled);
+#endif
+}
+
+bool UOPWorldSubsystem::IsProfilingEnabled() const
+{
+#if OP_PROFILING_ENABLED
+	return FOPProfiler::IsProfilingEnabled();
+#else
+	return false;
+#endif
+}
+
+void UOPWorldSubsystem::RegisterEnemy(AActor* Enemy)
+{
+	if (!IsValid(Enemy) || EnemyArray.Contains(Enemy)) return;
+
+	EnemyArray.Emplace(Enemy);
+	OP_SET_LIVE_ENEMIES(EnemyArray.Num());
+
+	OnEnemyRegistered.Broadcast(Enemy);
+}
+
+void UOPWorldSubsystem::UnregisterEnemy(AActor* Enemy)
+{
+	if (EnemyArray.Remove(Enemy) <= 0) return;
+
+	OP_SET_LIVE_ENEMIES(EnemyArray.Num());
+
+	OnEnemyUnregistered.Broadcast(Enemy);
+	OnEnemyUpdate.Broadcast();
+}
+
+void UOPWorldSubsystem::RegisterInteractable(AActor* Interactable)
+{
+	if (!IsValid(Interactable) || InteractableArray.Contains(Interactable)) return;
+
+	InteractableArray.Emplace(Interactable);
+	OnInteractableRegistered.Broadcast(Interactable);
+}
+
+void UOPWorldSubsystem::UnregisterInteractable(AActor* Interactable)
+{
+	if (InteractableArray.Remove(Interactable) <= 0) return;
+
+	OnInteractableUnregistered.Broadcast(Interactable);
+}
+
+AActor* UOPWorldSubsystem::SpawnComponentOwner(UWorld* World, FName BaseName)
+{
+	if (!IsValid(World)) return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = MakeUniqueObjectName(World, AActor::StaticClass(), BaseName);
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TObjectPtr<AActor> NewOwner = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+
+	if (!IsValid(NewOwner)) return nullptr;
+
+	NewOwner->SetActorTickEnabled(false);
+	NewOwner->SetRootComponent(NewObject<USceneComponent>(NewOwner, TEXT("Root")));
+	NewOwner->GetRootComponent()->RegisterComponent();
+
+	return NewOwner;
 }
\ No newline at end of file
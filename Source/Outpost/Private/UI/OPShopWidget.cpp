@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "UI/OPShopWidget.h"
+#include "Subsystems/OPShopSubsystem.h"
+#include "UINavComponent.h"
+
+void UOPShopWidget::NativeConstruct()
+{
+	Super::NativeConstruct();
+
+	ShopSubsystem = GetWorld()->GetSubsystem<UOPShopSubsystem>();
+}
+
+void UOPShopWidget::RegisterItemComponent(UUINavComponent* Component, int32 ItemIndex)
+{
+	if (IsValid(Component)) ItemComponents.Emplace(Component, ItemIndex);
+}
+
+void UOPShopWidget::OnNavigate_Implementation(UUINavComponent* FromComponent, UUINavComponent* ToComponent)
+{
+	Super::OnNavigate_Implementation(FromComponent, ToComponent);
+
+	//Hovering an item is a good sign that the player is about to buy it, so it starts loading now.
+	const int32* ItemIndex = ItemComponents.Find(ToComponent);
+
+	if (ItemIndex && IsValid(ShopSubsystem)) ShopSubsystem->PreloadItem(*ItemIndex);
+}
+
+void UOPShopWidget::OnSelect_Implementation(UUINavComponent* Component)
+{
+	Super::OnSelect_Implementation(Component);
+
+	const int32* ItemIndex = ItemComponents.Find(Component);
+
+	if (ItemIndex && IsValid(ShopSubsystem)) ShopSubsystem->PurchaseItem(*ItemIndex, GetOwningPlayerPawn());
+}
\ No newline at end of file
@@ -48,6 +48,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "OPCharacterBase|Health")
 		void SetMaxHealth(int32 NewValue);
 
+	//Returns "true" if the character has died.
+	UFUNCTION(BlueprintPure, Category = "OPCharacterBase|Health")
+		FORCEINLINE bool IsCharacterDead() const { return bIsCharacterDead; }
+
+	/* Inventory */
+
+	//Returns the weapon that the character currently has equipped.
+	UFUNCTION(BlueprintPure, Category = "OPCharacterBase|Inventory|Weapons")
+		FORCEINLINE AOPWeapon* GetCurrentWeapon() const { return CurrentWeapon; }
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -8,6 +8,8 @@
 
 //Forward declarations.
 class UUASAimAssistTargetComponent;
+class UStaticMesh;
+class UOPLootTable;
 
 /**
  * 
@@ -24,10 +26,45 @@ public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	/* Enemy pool */
+
+	/*
+	Takes the enemy out of its dormant state, resets it to a freshly-spawned state, and places it in the level.
+	Should only be called by the enemy pool.
+	@param	SpawnTransform	Where the enemy should be placed.
+	*/
+	void ActivateFromPool(const FTransform& SpawnTransform);
+
+	/*
+	Removes the enemy from play, and parks it out of sight until it's needed again.
+	Should only be called by the enemy pool.
+	@param	ParkingLocation	Where the enemy should be kept while it's dormant.
+	*/
+	void DeactivateForPool(const FVector& ParkingLocation);
+
+	//Returns "true" if the enemy is currently sitting in the enemy pool.
+	UFUNCTION(BlueprintPure, Category = "OPEnemy|Enemy Pool")
+		FORCEINLINE bool IsDormant() const { return bIsDormant; }
+
+	//Returns the component that makes this enemy a target for aim assist.
+	FORCEINLINE UUASAimAssistTargetComponent* GetAimAssistTargetComponent() const { return AimAssistTargetComponent; }
+
+	//Returns "true" if the enemy should be steered towards the outpost by the flow field, instead of finding its own path.
+	FORCEINLINE bool ShouldFollowFlowField() const { return bFollowFlowField; }
+
+	//Returns the mesh that is drawn for this enemy while it's a distant crowd entity.
+	FORCEINLINE UStaticMesh* GetCrowdProxyMesh() const { return CrowdProxyMesh; }
+
+	//Determines whether the enemy should go dormant as soon as it spawns, instead of entering play. Set by the enemy pool.
+	bool bSpawnDormant;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the enemy is removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/* Actor and scene components */
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPEnemy|Components")
@@ -45,19 +82,71 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
 		FCharacterMaterials DamageMaterials;
 
+	/* Navigation */
+
+	//Determines whether the enemy is steered towards the outpost by the flow field, or left to find its own path.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Navigation")
+		bool bFollowFlowField = true;
+
+	/*
+	The mesh that is drawn for this enemy while it's far away, and simulated as a crowd entity instead of a real enemy.
+	Enemies without one are always spawned as real enemies.
+	*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Navigation")
+		TObjectPtr<UStaticMesh> CrowdProxyMesh;
+
+	/* Loot */
+
+	//Everything that this enemy might drop when it dies.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Loot")
+		TObjectPtr<UOPLootTable> LootTable;
+
 	/* Death and respawning */
 	
-	//The amount of time it takes for a dead enemy's body to be cleared from the level.
+	/*
+	The amount of time it takes for a dead enemy's body to be cleared from the level.
+	Only used if the enemy's body could not be baked into a corpse.
+	*/
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Death and Respawning")
 		float ClearTimer = 30.f;
 
+	//How often a ragdolling enemy's body is checked, to see if it has come to rest.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Death and Respawning|Corpses")
+		float SettleCheckInterval = 0.25f;
+
+	//The speed that a ragdolling enemy's body must drop below, before it's considered to be at rest.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Death and Respawning|Corpses")
+		float SettleSpeedThreshold = 5.f;
+
+	//The longest that a ragdolling enemy's body is allowed to move, before it gets baked into a corpse anyway.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPEnemy|Death and Respawning|Corpses")
+		float MaxSettleTime = 5.f;
+
 	UFUNCTION()
 		void TakePointDamage(AActor* DamagedActor, float Damage, AController* InstigatedBy, FVector HitLocation, UPrimitiveComponent* FHitComponent, FName BoneName, FVector ShotFromDirection, const UDamageType* DamageType, AActor* DamageCauser);
 
+	//Returns the part of the enemy's body that was hit last, based on its physical material.
+	EHitZone GetHitZone() const;
+
+	void CheckRagdollSettled();
 	void ClearEnemy();
 
+	//Returns health, collision, physics, and weapons to the state they were in when the enemy first spawned.
+	void ResetEnemyState();
+
 	//Used for calculating location-based damage.
 	TObjectPtr<UPhysicalMaterial> LastHitMaterial;
 
 	FTimerHandle ClearHandle;
+	FTimerHandle SettleHandle;
+
+	//How long the enemy's body has been ragdolling for.
+	float TimeSpentRagdolling;
+
+	//The state of the enemy's mesh and capsule when it first spawned, so that it can be restored after ragdolling.
+	FTransform DefaultMeshRelativeTransform;
+	FName DefaultMeshCollisionProfile;
+	FName DefaultCapsuleCollisionProfile;
+
+	bool bIsDormant;
 };
\ No newline at end of file
@@ -17,6 +17,7 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FItemPickupDelegate,  bool, bWeap
 class UInputAction;
 class UInputMappingContext;
 class UCameraComponent;
+class UOPSaveGame;
 
 /**
  * 
@@ -39,6 +40,19 @@ public:
 	//Required for EnhancedInput plugin.
 	virtual void PawnClientRestart() override;
 
+	/* Saving */
+
+	//Writes the player's health, reserve ammo and weapons to a save game.
+	void WriteToSaveGame(UOPSaveGame* SaveGame) const;
+
+	/*
+	Restores the player's health, reserve ammo and weapons from a save game. Weapons that the player is already carrying aren't given to them again,
+	and any weapon they're carrying that isn't in the save game is taken away from them.
+	@param	SaveGame	The save game to restore from.
+	@param	WeaponClasses	The class of each of the save game's weapons, already loaded by the caller. A weapon whose class is null is skipped.
+	*/
+	void ReadFromSaveGame(const UOPSaveGame* SaveGame, const TArray<TSubclassOf<AOPWeapon>>& WeaponClasses);
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
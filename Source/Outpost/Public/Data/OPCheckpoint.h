@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "OPEnums.h"
+#include "OPStructs.h"
+
+/*
+Every version of the checkpoint format. Works the same way as the save game's versions:
+a new version is added above VersionPlusOne whenever something is added, and only read from checkpoints that are at least that version.
+*/
+enum class EOPCheckpointVersion : int32
+{
+	Initial = 1,
+
+	//Added the seed of the stream that loot is rolled from.
+	LootSeed,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+/*
+A snapshot of everything that is alive partway through a wave. Everything is stored as flat parallel arrays instead of one struct per actor,
+so that capturing is a single pass that appends to each array, and packing it is a handful of tight loops.
+Classes and meshes are only stored once, in the asset table, and everything else refers to them by their index in it.
+*/
+struct OUTPOST_API FOPCheckpoint
+{
+	/*
+	Reads or writes the whole checkpoint.
+	@param	Ar	The archive to read from or write to.
+	@param	Version	The version of the format that the archive is in. Always the latest version when writing.
+	*/
+	void Serialize(FArchive& Ar, EOPCheckpointVersion Version);
+
+	//Empties every array, but keeps their memory, so that the next capture doesn't allocate.
+	void Reset();
+
+	//Returns the index of an asset in the asset table, adding it if it isn't there yet. Returns INDEX_NONE for no asset.
+	int32 FindOrAddAsset(const UObject* Asset);
+
+	//Returns the index of an asset in the asset table, or INDEX_NONE if the checkpoint doesn't refer to it.
+	int32 FindAsset(const FSoftObjectPath& AssetPath) const;
+
+	//Returns an asset from the asset table, loading it if it isn't in memory.
+	UObject* LoadAsset(int32 AssetIndex) const;
+
+	//The path of every class and mesh that the checkpoint refers to.
+	TArray<FSoftObjectPath> AssetPaths;
+
+	/* Wave */
+
+	int32 WaveIndex = INDEX_NONE;
+
+	//How long the wave had been going for, in seconds.
+	float WaveTime = 0.f;
+
+	FWaveTelemetry WaveTelemetry;
+
+	//The current seed of the stream that scatters enemies around the spawn zones.
+	int32 SpawnSeed = 0;
+
+	TArray<FVector> SpawnZoneLocations;
+	int32 NextSpawnZoneIndex = 0;
+
+	//The class of every enemy that was still waiting to spawn, in spawn order.
+	TArray<int32> SpawnQueue;
+
+	/* Player */
+
+	FVector PlayerLocation = FVector::ZeroVector;
+	FRotator PlayerRotation = FRotator::ZeroRotator;
+
+	//The player's inventory and cash, packed in the save game format.
+	TArray<uint8> PlayerSave;
+	int32 PlayerSaveVersion = 0;
+
+	/* Enemies. Every array is indexed together, one entry per enemy. */
+
+	TArray<int32> EnemyClasses;
+	TArray<FVector> EnemyLocations;
+	TArray<float> EnemyYaws;
+	TArray<FVector> EnemyVelocities;
+	TArray<int32> EnemyHealth;
+
+	//The number of rounds left in each enemy's equipped weapon, or INDEX_NONE if it had none.
+	TArray<int32> EnemyMagazines;
+
+	//Where each enemy last saw the player, and how many seconds before the checkpoint that was. Negative if it never had.
+	TArray<FVector> EnemyLastKnownPlayerLocations;
+	TArray<float> EnemyTimesSinceSeen;
+
+	/* Crowd entities. Every array is indexed together, one entry per entity. */
+
+	TArray<int32> CrowdClasses;
+	TArray<FVector> CrowdLocations;
+	TArray<FVector> CrowdDirections;
+	TArray<int32> CrowdHealth;
+
+	/* Loot. Every array is indexed together, one entry per pickup. */
+
+	TArray<FVector> LootLocations;
+
+	//The class of weapon that each pickup gives, or INDEX_NONE if it's a pile of ammo.
+	TArray<int32> LootWeaponClasses;
+
+	TArray<EWeaponType> LootAmmoTypes;
+	TArray<int32> LootAmounts;
+	TArray<int32> LootMeshes;
+
+	//The current seed of the stream that loot is rolled from.
+	int32 LootSeed = 0;
+
+private:
+	//Where each asset is in the asset table. Only used while capturing.
+	TMap<TObjectKey<UObject>, int32> AssetIndices;
+
+	//Every asset that has already been looked up, so that restoring a crowd of the same class only resolves its path once.
+	mutable TArray<TWeakObjectPtr<UObject>> LoadedAssets;
+};
\ No newline at end of file
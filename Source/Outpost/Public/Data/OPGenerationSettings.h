@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OPStructs.h"
+#include "OPGenerationSettings.generated.h"
+
+/**
+ * Describes how a procedurally-generated area is laid out. The same settings and seed always produce the same area.
+ */
+UCLASS(BlueprintType)
+class OUTPOST_API UOPGenerationSettings : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//Should be increased whenever a change to the generator would place things differently for the same seed.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings")
+		int32 GeneratorVersion = 1;
+
+	/* Layout */
+
+	//Half of the width of the square area that is generated, centered on where the player starts.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float AreaHalfExtent = 20000.f;
+
+	//How far away from the player's start the outpost is placed.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float OutpostDistance = 8000.f;
+
+	//The radius around the outpost that only the outpost layout is placed in.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float OutpostClearRadius = 2500.f;
+
+	//The radius around the player's start that is kept clear of everything.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float PlayerClearRadius = 1000.f;
+
+	//How far outside of the outpost's clear radius cover is scattered. Cover is kept close to the outpost, where the fighting happens.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float CoverBandWidth = 3000.f;
+
+	//The number of spawn zones that enemy reinforcements arrive from.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		int32 SpawnZoneCount = 4;
+
+	//How far away from the outpost each spawn zone is placed.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float SpawnZoneDistance = 9000.f;
+
+	//How far above and below the area placements look for the ground.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float GroundTraceHeight = 50000.f;
+
+	//The width of each square cell that the area is streamed in. Every loaded cell draws each of its meshes with one instanced component, which is culled as a whole.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Layout")
+		float CellSize = 8000.f;
+
+	/* Stages */
+
+	//Rocks, mounds and other large features that are scattered across the whole area.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Stages")
+		TArray<FGenerationRule> TerrainFeatures;
+
+	//Walls, sandbags and other objects that characters can take cover behind, scattered around the outpost.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Stages")
+		TArray<FGenerationRule> Cover;
+
+	//Trees, bushes and grass that are scattered across the whole area.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Stages")
+		TArray<FGenerationRule> Foliage;
+
+	//Crates and other loot that are scattered across the whole area.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Stages")
+		TArray<FGenerationRule> Loot;
+
+	//Buildings, walls and other pieces of the outpost, placed inside of its clear radius.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPGenerationSettings|Stages")
+		TArray<FGenerationRule> OutpostLayout;
+
+	//Returns the rules for a single generation stage.
+	const TArray<FGenerationRule>& GetStageRules(EGenerationStage Stage) const;
+};
\ No newline at end of file
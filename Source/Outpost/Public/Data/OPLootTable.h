@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OPStructs.h"
+#include "OPLootTable.generated.h"
+
+/**
+ * Describes everything that a character might drop when they die.
+ */
+UCLASS(BlueprintType)
+class OUTPOST_API UOPLootTable : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//Every item that might be dropped. Each one is rolled separately.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPLootTable")
+		TArray<FLootDrop> Drops;
+
+	//The chance, between 0 and 1, that the character drops a copy of the weapon that they had equipped.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPLootTable")
+		float EquippedWeaponDropChance = 0.25f;
+};
\ No newline at end of file
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "InputActionValue.h"
+#include "InputTriggers.h"
+
+//Forward declarations.
+class UInputAction;
+
+/*
+Every version of the replay format. Works the same way as the save game's versions:
+a new version is added above VersionPlusOne whenever something is added, and only read from replays that are at least that version.
+*/
+enum class EOPReplayVersion : int32
+{
+	Initial = 1,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+/*
+A recording of every input action that reached the player's handlers during a run, frame by frame, along with the seeds that the run started with and how long each frame took.
+Played back with the same seeds and frame times, the same input reaches the same handlers on the same frames, so the run plays out the same way again.
+Events are stored as flat parallel arrays, like checkpoints, and each event only keeps as many values as its action has.
+*/
+struct OUTPOST_API FOPReplay
+{
+	/*
+	Reads or writes the whole replay.
+	@param	Ar	The archive to read from or write to.
+	@param	Version	The version of the format that the archive is in. Always the latest version when writing.
+	*/
+	void Serialize(FArchive& Ar, EOPReplayVersion Version);
+
+	//Empties every array, but keeps their memory.
+	void Reset();
+
+	//Returns the index of an action in the action table, adding it if it isn't there yet. Returns INDEX_NONE if the table is full.
+	int32 FindOrAddAction(const UInputAction* Action);
+
+	//Returns an action from the action table, loading it if it isn't in memory.
+	const UInputAction* LoadAction(int32 ActionIndex) const;
+
+	//Records an event that reached the player on a given frame.
+	void AddEvent(int32 Frame, int32 ActionIndex, ETriggerEvent TriggerEvent, const FInputActionValue& Value);
+
+	//Returns the value that an event's action had, as the player's handlers received it.
+	FInputActionValue GetEventValue(int32 EventIndex) const;
+
+	//Returns the number of frames that were recorded.
+	FORCEINLINE int32 GetFrameCount() const { return FrameDeltaTimes.Num(); }
+
+	//Returns the number of events that were recorded.
+	FORCEINLINE int32 GetEventCount() const { return EventFrames.Num(); }
+
+	/* Seeds */
+
+	//The seed that the area was generated from, or 0 if it wasn't generated.
+	int32 Seed = 0;
+
+	//The seed that the global random number generator was reset to, once the recording started.
+	int32 RandomSeed = 0;
+
+	/* Frames */
+
+	//How long each frame took, in seconds. Replays use these as their fixed timesteps.
+	TArray<float> FrameDeltaTimes;
+
+	/* Actions */
+
+	//The path of every action that the replay refers to.
+	TArray<FSoftObjectPath> ActionPaths;
+
+	//The value type of each action, which decides how many values each of its events keeps.
+	TArray<EInputActionValueType> ActionValueTypes;
+
+	/* Events. Every array is indexed together, one entry per event, in the order that they reached the player. */
+
+	TArray<int32> EventFrames;
+	TArray<uint8> EventActions;
+	TArray<ETriggerEvent> EventTriggers;
+
+	//Every event's values, one after the other.
+	TArray<float> EventValues;
+
+private:
+	//Where each action is in the action table. Only used while recording.
+	TMap<TObjectKey<UInputAction>, int32> ActionIndices;
+
+	//Where each event's values start in EventValues. Rebuilt whenever a replay is read, rather than stored.
+	TArray<int32> EventValueOffsets;
+
+	mutable TArray<TWeakObjectPtr<const UInputAction>> LoadedActions;
+
+	//Returns the number of values that an event of a given value type keeps.
+	static int32 GetValueCount(EInputActionValueType ValueType);
+};
\ No newline at end of file
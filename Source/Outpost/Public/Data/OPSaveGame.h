@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SaveGame.h"
+#include "OPStructs.h"
+#include "OPSaveGame.generated.h"
+
+/*
+Every version of the save game format. A new version should be added above VersionPlusOne whenever something is added to the save game,
+and whatever was added should only be read from saves that are at least that version. Older saves then keep loading, with the defaults for anything they don't have.
+*/
+enum class EOPSaveVersion : int32
+{
+	Initial = 1,
+
+	//Added the journal, and the generated objects that have changed.
+	Journal,
+
+	VersionPlusOne,
+	Latest = VersionPlusOne - 1
+};
+
+/**
+ * Everything about a run that is kept between sessions: the area's seed, the next wave, the player's inventory, their cash, and what has changed in the generated area.
+ * Written to disk as a compact binary archive by the save subsystem, rather than through tagged properties.
+ * A save game is either a full save, or a delta that only holds what changed since the save before it. Deltas are applied on top of their full save when it's loaded.
+ */
+UCLASS(BlueprintType)
+class OUTPOST_API UOPSaveGame : public USaveGame
+{
+	GENERATED_BODY()
+
+public:
+	/*
+	Reads or writes everything in the save game, apart from the header that the save subsystem writes.
+	@param	Ar	The archive to read from or write to.
+	@param	Version	The version of the format that the archive is in. Always the latest version when writing.
+	*/
+	void SerializeSaveData(FArchive& Ar, EOPSaveVersion Version);
+
+	/*
+	Applies a delta on top of this save game, as if the delta had been written as a full save.
+	@param	Delta	The next delta in this save game's journal.
+	@return	Could the delta be applied? Deltas that don't follow on from this save game are rejected.
+	*/
+	bool ApplyDelta(const UOPSaveGame* Delta);
+
+	//Returns "true" if this save game only holds what changed since the save before it.
+	FORCEINLINE bool IsDelta() const { return DeltaIndex > 0; }
+
+	//Returns "true" if an archive being read has room left for a number of entries of a given size. Used to reject corrupted counts before anything is allocated.
+	static bool HasRoomFor(FArchive& Ar, int32 Count, int64 EntrySize);
+
+	//Reads or writes one array of a group of parallel arrays, once the group's length has been read and checked with HasRoomFor.
+	template<typename T>
+	static void SerializeColumn(FArchive& Ar, TArray<T>& Column, int32 Count)
+	{
+		if (Ar.IsLoading()) Column.SetNumUninitialized(Count);
+
+		for (T& Index : Column)
+		{
+			Ar << Index;
+		}
+	}
+
+	//The version of the format that this save game was read from.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame")
+		int32 SaveVersion = static_cast<int32>(EOPSaveVersion::Latest);
+
+	//When this save game was written, in UTC.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame")
+		FDateTime SaveTime;
+
+	/* Progress */
+
+	//The seed that the area was generated from.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Progress")
+		int32 Seed;
+
+	//The index of the wave that the player will fight next.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Progress")
+		int32 WaveIndex;
+
+	/* Player */
+
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Player")
+		int32 CurrentHealth;
+
+	//The amount of reserve ammo that the player had of each type.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Player")
+		TMap<EWeaponType, int32> ReserveAmmo;
+
+	//Every weapon that the player was carrying.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Player")
+		TArray<FSavedWeapon> Weapons;
+
+	//The index of the weapon in Weapons that the player had equipped, or INDEX_NONE if they had none.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Player")
+		int32 CurrentWeaponIndex = INDEX_NONE;
+
+	/* Economy */
+
+	//Every transaction that was applied to the player's cash. Their balance is restored from the last one. In a delta, only the transactions since the save before it.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Economy")
+		TArray<FEconomyTransaction> TransactionLog;
+
+	//The position in the full transaction log of the first transaction in TransactionLog. Always 0 in a full save.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Economy")
+		int32 FirstTransaction;
+
+	/* World */
+
+	//Every generated gameplay object that differs from how it was generated. In a delta, only the ones that changed since the save before it.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|World")
+		TArray<FSavedCellActor> CellActors;
+
+	/* Journal */
+
+	//Identifies the full save that this save game belongs to. Deltas are only ever applied on top of the full save with the same ID.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Journal")
+		FGuid BaseId;
+
+	//0 for a full save. Otherwise, the position of this delta in its full save's journal, starting from 1.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveGame|Journal")
+		int32 DeltaIndex;
+};
\ No newline at end of file
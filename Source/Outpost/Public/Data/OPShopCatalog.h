@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OPStructs.h"
+#include "OPShopCatalog.generated.h"
+
+/**
+ * Describes everything that can be bought from the shop. Items only hold soft references, so the catalog itself is cheap to load.
+ */
+UCLASS(BlueprintType)
+class OUTPOST_API UOPShopCatalog : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//Every item in the shop, in the order they are shown.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPShopCatalog")
+		TArray<FShopItem> Items;
+};
\ No newline at end of file
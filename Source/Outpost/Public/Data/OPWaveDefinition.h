@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OPStructs.h"
+#include "OPWaveDefinition.generated.h"
+
+/**
+ * Describes a single wave of enemy reinforcements.
+ */
+UCLASS(BlueprintType)
+class OUTPOST_API UOPWaveDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//Every group of enemies that makes up this wave. Groups are spawned interleaved, so that the wave arrives mixed.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPWaveDefinition|Enemies")
+		TArray<FWaveEnemyGroup> EnemyGroups;
+
+	//Enemies will spawn around actors in the level that have any of these tags.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPWaveDefinition|Spawning")
+		TArray<FName> SpawnZoneTags;
+
+	//How far away from a spawn zone's center an enemy is allowed to spawn.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPWaveDefinition|Spawning")
+		float SpawnZoneRadius = 500.f;
+
+	//The amount of time the player has to prepare, before this wave approaches.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPWaveDefinition|Timing")
+		float PrepTime = 30.f;
+
+	//Returns the total number of enemies in this wave.
+	UFUNCTION(BlueprintPure, Category = "OPWaveDefinition")
+		int32 GetTotalEnemyCount() const;
+};
\ No newline at end of file
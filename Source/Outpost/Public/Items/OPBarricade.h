@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "OPBarricade.generated.h"
+
+//Forward declarations.
+class UBoxComponent;
+class UStaticMesh;
+class UOPBarricadeSubsystem;
+class UOPFlowFieldSubsystem;
+class UOPNavBuildSubsystem;
+
+/*
+A placeable, destructible barricade. The barricade is split into a row of chunks across its width, each with its own health.
+Chunks are drawn as instances by the barricade subsystem, and swap to a more damaged mesh as they lose health.
+The barricade never ticks, and only touches navigation and the flow field when it is placed, breached or repaired.
+*/
+UCLASS()
+class OUTPOST_API AOPBarricade : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AOPBarricade();
+
+	//Returns "true" if enough of the barricade has been destroyed for enemies to pass through it.
+	UFUNCTION(BlueprintPure, Category = "OPBarricade")
+		FORCEINLINE bool IsBreached() const { return bIsBreached; }
+
+	//Returns the total health of every chunk in the barricade.
+	UFUNCTION(BlueprintPure, Category = "OPBarricade")
+		int32 GetTotalHealth() const;
+
+	//Restores every chunk to full health, and closes the barricade again if it was breached.
+	UFUNCTION(BlueprintCallable, Category = "OPBarricade")
+		void RepairBarricade();
+
+	/*
+	Gets the health of every chunk, packed into a single byte each so that it can be stored cheaply while the barricade is unloaded.
+	@param	OutChunkHealth	The health of each chunk, from 0 for destroyed to 255 for full health.
+	*/
+	void GetPackedChunkHealth(TArray<uint8>& OutChunkHealth) const;
+
+	//Restores the health of every chunk from GetPackedChunkHealth, and breaches the barricade if enough chunks are destroyed.
+	void SetPackedChunkHealth(const TArray<uint8>& PackedChunkHealth);
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the barricade is removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Actor and scene components */
+
+	//The barricade's only collision. Blocks characters and shots, and is the only part of the barricade that affects navigation.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPBarricade|Components")
+		TObjectPtr<UBoxComponent> CollisionBox;
+
+	/* Chunks */
+
+	//The number of chunks that the barricade is split into, across the width of its collision box.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPBarricade|Chunks", meta = (ClampMin = 1))
+		int32 ChunkCount = 4;
+
+	//The health of each chunk.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPBarricade|Chunks", meta = (ClampMin = 1))
+		int32 ChunkMaxHealth = 200;
+
+	//The mesh that each chunk is drawn with, from intact to most damaged. Chunks with no health left aren't drawn at all.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPBarricade|Chunks")
+		TArray<TObjectPtr<UStaticMesh>> DamageStateMeshes;
+
+	//The fraction of chunks, between 0 and 1, that have to be destroyed before the barricade is breached.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPBarricade|Chunks", meta = (ClampMin = 0.f, ClampMax = 1.f))
+		float BreachFraction = 0.5f;
+
+	UFUNCTION()
+		void TakePointDamage(AActor* DamagedActor, float Damage, AController* InstigatedBy, FVector HitLocation, UPrimitiveComponent* FHitComponent, FName BoneName, FVector ShotFromDirection, const UDamageType* DamageType, AActor* DamageCauser);
+
+	//Returns the chunk closest to a location that still has health, or INDEX_NONE if every chunk is destroyed.
+	int32 FindChunkNear(const FVector& Location) const;
+
+	//Returns the damage state that a chunk with the given health should be drawn with.
+	int32 GetDamageState(int32 Health) const;
+
+	//Swaps a chunk's instance over to the mesh for its new damage state.
+	void SetChunkState(int32 ChunkIndex, int32 NewState);
+
+	FTransform GetChunkTransform(int32 ChunkIndex) const;
+
+	//Opens or closes the barricade for characters, navigation and the flow field.
+	void SetBreached(bool bBreached);
+
+	UPROPERTY()
+		TObjectPtr<UOPBarricadeSubsystem> BarricadeSubsystem;
+
+	UPROPERTY()
+		TObjectPtr<UOPFlowFieldSubsystem> FlowField;
+
+	UPROPERTY()
+		TObjectPtr<UOPNavBuildSubsystem> NavBuild;
+
+	/* Chunk data. Every array is indexed by chunk. */
+
+	TArray<int32> ChunkHealth;
+
+	//The damage state that each chunk is currently drawn with. One past the most damaged mesh, once a chunk is destroyed.
+	TArray<uint8> ChunkStates;
+
+	//The instance that each chunk is currently drawn with, in its damage state's mesh.
+	TArray<int32> ChunkInstances;
+
+	int32 DestroyedChunks;
+
+	bool bIsBreached;
+	bool bIsBlockingFlowField;
+};
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Interfaces/OPInteractInterface.h"
+#include "OPStructs.h"
+#include "OPLootPickup.generated.h"
+
+/*
+A lightweight stand-in for loot lying on the ground. Owned and recycled by the loot subsystem.
+Weapons are only spawned once the player actually picks one up, so dropped weapons cost nothing more than a mesh until then.
+*/
+UCLASS()
+class OUTPOST_API AOPLootPickup : public AActor, public IOPInteractInterface
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AOPLootPickup();
+
+	/* Overridden from OPInteractInterface */
+
+	virtual void OnInteract_Implementation(AActor* CallingPlayer) override;
+	virtual FText GetInteractableObjectName_Implementation() override;
+	virtual EInteractType GetInteractableObjectType_Implementation() override;
+
+	/*
+	Turns the pickup into a pile of reserve ammo, and places it in the level.
+	@param	Location	Where the pickup should be placed.
+	@param	NewAmmoType	The category of weapon that the reserve ammo belongs to.
+	@param	Amount	The amount of reserve ammo in the pile.
+	@param	Mesh	The mesh that represents the pile.
+	*/
+	void ActivateAsAmmo(const FVector& Location, EWeaponType NewAmmoType, int32 Amount, UStaticMesh* Mesh);
+
+	/*
+	Turns the pickup into a weapon, and places it in the level.
+	@param	Location	Where the pickup should be placed.
+	@param	NewWeaponClass	The class of weapon that the player receives when they pick this up.
+	*/
+	void ActivateAsWeapon(const FVector& Location, TSubclassOf<AOPWeapon> NewWeaponClass);
+
+	//Hides the pickup, and takes it out of play until the loot subsystem needs it again.
+	void Deactivate();
+
+	//Adds more reserve ammo to this pile, when a nearby drop is merged into it.
+	FORCEINLINE void AddAmmo(int32 Amount) { AmmoAmount += Amount; }
+
+	//Returns "true" if this pickup is a pile of reserve ammo.
+	FORCEINLINE bool IsAmmo() const { return !IsValid(WeaponClass); }
+
+	FORCEINLINE EWeaponType GetAmmoType() const { return AmmoType; }
+
+	FORCEINLINE int32 GetAmmoAmount() const { return AmmoAmount; }
+
+	//Returns the class of weapon that the player receives when they pick this up, if it's a weapon.
+	FORCEINLINE TSubclassOf<AOPWeapon> GetWeaponClass() const { return WeaponClass; }
+
+	//Returns the mesh that represents this pile, if it's reserve ammo.
+	UStaticMesh* GetAmmoMesh() const;
+
+protected:
+	/* Actor and scene components */
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPLootPickup|Components")
+		TObjectPtr<USceneComponent> PickupRoot;
+
+	//Represents reserve ammo.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPLootPickup|Components")
+		TObjectPtr<UStaticMeshComponent> AmmoMesh;
+
+	//Represents weapons. Never animates, or ticks.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPLootPickup|Components")
+		TObjectPtr<USkeletalMeshComponent> WeaponMesh;
+
+	UPROPERTY()
+		TSubclassOf<AOPWeapon> WeaponClass;
+
+	EWeaponType AmmoType;
+	int32 AmmoAmount;
+};
\ No newline at end of file
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "OPTurret.generated.h"
+
+//Forward declarations.
+class AOPWeapon;
+class UOPTurretSubsystem;
+
+/*
+A placeable defensive turret. Turrets never tick, and have no timers of their own: every turret in the level is aimed and fired by the turret subsystem in a single batched pass.
+Shots are fired through a regular weapon, so turrets share damage, impact effects and kill rewards with everything else.
+*/
+UCLASS()
+class OUTPOST_API AOPTurret : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AOPTurret();
+
+	//Turns the turret's head towards a location. Only the yaw is changed.
+	void AimAt(const FVector& TargetLocation);
+
+	//Returns the location that the turret's head turns around. Line of sight checks start from here.
+	FVector GetPivotLocation() const;
+
+	FORCEINLINE AOPWeapon* GetWeapon() const { return Weapon; }
+
+	/* Targeting */
+
+	//How far away the turret can acquire and shoot at enemies.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPTurret|Targeting")
+		float Range = 3000.f;
+
+	//How far, in degrees, from the direction that the turret was placed facing it can turn. 180 lets it turn all the way around.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPTurret|Targeting", meta = (ClampMin = 0.f, ClampMax = 180.f))
+		float ArcHalfAngle = 180.f;
+
+	//Multiplies the weapon's spread. Higher values make the turret less accurate.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPTurret|Targeting")
+		float AccuracyModifier = 1.f;
+
+	//How far above an enemy's origin the turret aims.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPTurret|Targeting")
+		float AimHeightOffset = 40.f;
+
+	/* Weapon */
+
+	//The weapon that the turret fires.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPTurret|Weapon")
+		TSubclassOf<AOPWeapon> WeaponClass;
+
+	//The amount of time it takes for the turret to refill its weapon's magazine, once it's empty.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OPTurret|Weapon")
+		float ReloadTime = 2.f;
+
+	//The turret's position in the turret subsystem's arrays. Only the turret subsystem should change this.
+	int32 TurretIndex = INDEX_NONE;
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when the turret is removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Actor and scene components */
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPTurret|Components")
+		TObjectPtr<UStaticMeshComponent> BaseMesh;
+
+	//The part of the turret that turns to face its target. The weapon is attached to it.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "OPTurret|Components")
+		TObjectPtr<UStaticMeshComponent> HeadMesh;
+
+	//The socket on the head mesh that the weapon is attached to.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPTurret|Components")
+		FName WeaponSocket = FName("Weapon");
+
+	UPROPERTY()
+		TObjectPtr<AOPWeapon> Weapon;
+
+	UPROPERTY()
+		TObjectPtr<UOPTurretSubsystem> TurretSubsystem;
+};
\ No newline at end of file
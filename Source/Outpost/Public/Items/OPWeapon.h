@@ -10,6 +10,7 @@
 
 //Forward declarations.
 class UOPWorldSubsystem;
+class UOPTraceBatchSubsystem;
 
 UCLASS()
 class OUTPOST_API AOPWeapon : public AActor, public IOPInteractInterface
@@ -80,6 +81,34 @@ public:
 	
 	void Shoot();
 
+	/*
+	Fires the weapon from its muzzle towards a target, for use by AI. Doesn't rely on a camera, or on the owner's point of view.
+	Shots are queued into the batched trace system, so their results and damage land on the next frame.
+	@param	TargetLocation	The location that the AI is aiming at.
+	@param	AccuracyModifier	Multiplies the weapon's spread. Higher values make the shot less accurate.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPWeapon")
+		void AIShoot(const FVector& TargetLocation, float AccuracyModifier = 1.f);
+
+	/*
+	Fires the weapon from its muzzle the same way as AIShoot, but without starting a cooldown timer. For callers that keep track of fire rate themselves.
+	@param	TargetLocation	The location that is being aimed at.
+	@param	AccuracyModifier	Multiplies the weapon's spread. Higher values make the shot less accurate.
+	@return	Was the weapon fired? Only fails if the magazine is empty.
+	*/
+	bool FireFromMuzzle(const FVector& TargetLocation, float AccuracyModifier = 1.f);
+
+	//The socket on the weapon's mesh that AI shots are fired from.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPWeapon|AI")
+		FName MuzzleSocket = FName("Muzzle");
+
+	//Multiplies the weapon's spread when it's fired by AI, on top of any accuracy modifier that the AI passes in.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OPWeapon|AI")
+		float AISpreadMultiplier = 1.f;
+
+	//Refills the weapon's magazine and clears any active cooldowns, so that it can be reused by a pooled character.
+	void ResetWeaponState();
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -98,12 +127,17 @@ protected:
 		void CheckInfiniteAmmoStatus();
 	
 	void WeaponLineTrace();
+	void QueueAIWeaponTrace(const FVector& MuzzleLocation, const FVector& AimDirection, float SpreadRadius);
+	void OnAIWeaponTraceComplete(const FHitResult& HitResult, bool bBlockingHit);
 	FVector CalculateWeaponSpread();
 	void ApplyDamageToTarget();
 	void SpawnParticleEffectOnTarget();
 
 	void EndFiringCooldown();
 
+	//Returns the controller of the weapon's owner. Cached, and only looked up again when the owner or its controller changes.
+	AController* GetOwnerController();
+
 	FTimerHandle FiringCooldownHandle;
 
 	FHitResult WeaponHitResult;
@@ -113,6 +147,17 @@ protected:
 	FRotator CameraRotation;
 
 	TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+	TObjectPtr<UOPTraceBatchSubsystem> TraceBatchSubsystem;
+
+	//The owner and controller that the cached pointers and query parameters below were built for.
+	UPROPERTY()
+		TObjectPtr<AActor> CachedOwner;
+
+	UPROPERTY()
+		TObjectPtr<AController> CachedController;
+
+	//Query parameters for AI shots, which ignore the weapon and its owner.
+	FCollisionQueryParams AITraceParams;
 
 	int32 BurstCount;
 };
\ No newline at end of file
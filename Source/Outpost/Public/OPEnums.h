@@ -41,4 +41,56 @@ enum class EInteractType : uint8
 	NONE	UMETA(DisplayName = "NONE"),
 	Item	UMETA(DisplayName = "Item"),
 	Switch	UMETA(DisplayName = "Switch")
+};
+
+//Determines which part of a character's body was hit.
+UENUM(BlueprintType)
+enum class EHitZone : uint8
+{
+	Body	UMETA(DisplayName = "Body"),
+	Head	UMETA(DisplayName = "Head"),
+	Limb	UMETA(DisplayName = "Limb")
+};
+
+//Determines what caused a change in the player's cash.
+UENUM(BlueprintType)
+enum class EEconomyEvent : uint8
+{
+	Kill	UMETA(DisplayName = "Kill"),
+	WaveCleared	UMETA(DisplayName = "Wave Cleared"),
+	NoDamageBonus	UMETA(DisplayName = "No Damage Bonus"),
+	DamageTaken	UMETA(DisplayName = "Damage Taken"),
+	Purchase	UMETA(DisplayName = "Purchase"),
+	Refund	UMETA(DisplayName = "Refund")
+};
+
+//Determines which stage of level generation a placement was made by. Each stage draws from its own random stream.
+UENUM(BlueprintType)
+enum class EGenerationStage : uint8
+{
+	Terrain	UMETA(DisplayName = "Terrain Features"),
+	Cover	UMETA(DisplayName = "Cover"),
+	Foliage	UMETA(DisplayName = "Foliage"),
+	Loot	UMETA(DisplayName = "Loot"),
+	Outpost	UMETA(DisplayName = "Outpost Layout")
+};
+
+//Determines how much of a streaming cell of the generated area is loaded.
+UENUM(BlueprintType)
+enum class ECellDetail : uint8
+{
+	Unloaded	UMETA(DisplayName = "Unloaded"),
+	Proxy	UMETA(DisplayName = "Proxy"),
+	Full	UMETA(DisplayName = "Full")
+};
+
+//Determines what the combat benchmark is currently doing.
+UENUM(BlueprintType)
+enum class EBenchmarkPhase : uint8
+{
+	Idle	UMETA(DisplayName = "Idle"),
+	Prewarming	UMETA(DisplayName = "Prewarming"),
+	WarmingUp	UMETA(DisplayName = "Warming Up"),
+	Running	UMETA(DisplayName = "Running"),
+	Finished	UMETA(DisplayName = "Finished")
 };
\ No newline at end of file
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+//Profiling is compiled out of shipping builds entirely.
+#define OP_PROFILING_ENABLED !UE_BUILD_SHIPPING
+
+//The gameplay systems whose cost is timed while profiling is running.
+enum class EOPProfiledSystem : uint8
+{
+	//Firing a weapon, by the player or by AI.
+	Shoot,
+
+	//Resolving a weapon's line trace, including the damage and impact effect that it causes.
+	WeaponTrace,
+
+	//Spawning the effect where a shot landed.
+	ImpactEffect,
+
+	//The player's line trace for whatever they're looking at.
+	InteractTrace,
+
+	//Checking whether the actor that the player is looking at can be interacted with.
+	CheckInteractables,
+
+	//An enemy taking damage from a shot.
+	TakePointDamage,
+
+	//An enemy dying, including starting its ragdoll and rolling its loot.
+	CharacterDeath,
+
+	//Sweeping for everything that a melee attack hits.
+	MeleeTrace,
+
+	//Applying a melee attack's damage to everything that it hit.
+	MeleeHit,
+
+	Count
+};
+
+#if OP_PROFILING_ENABLED
+
+/*
+Every profiled system has a cycle counter in the "Outpost" stats group, which can be shown in game with "stat Outpost",
+and a CPU event on the "Outpost" trace channel, which shows up in Unreal Insights. Both are only recorded while profiling is turned on,
+either from the debug options in UOPWorldSubsystem, or by launching with "-trace=cpu,Outpost".
+*/
+DECLARE_STATS_GROUP(TEXT("Outpost"), STATGROUP_Outpost, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shoot"), STAT_OPShoot, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon Line Trace"), STAT_OPWeaponTrace, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact Effect"), STAT_OPImpactEffect, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interact Line Trace"), STAT_OPInteractTrace, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check For Interactables"), STAT_OPCheckInteractables, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Take Point Damage"), STAT_OPTakePointDamage, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Death"), STAT_OPCharacterDeath, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Melee Trace"), STAT_OPMeleeTrace, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Melee Hit"), STAT_OPMeleeHit, STATGROUP_Outpost, OUTPOST_API);
+
+//Counters that are reset every frame.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_OPTraces, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Impact Effects"), STAT_OPImpactEffects, STATGROUP_Outpost, OUTPOST_API);
+
+//Counters that hold their value from frame to frame.
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Enemies"), STAT_OPLiveEnemies, STATGROUP_Outpost, OUTPOST_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ragdolls"), STAT_OPRagdolls, STATGROUP_Outpost, OUTPOST_API);
+
+UE_TRACE_CHANNEL_EXTERN(OutpostChannel, OUTPOST_API);
+
+/*
+Keeps track of how much time is spent in each profiled system, and how often it runs. Only used on the game thread.
+Timing is used by the combat benchmark, while profiling feeds the stats group and trace channel. Each can be turned on without the other.
+Times are inclusive, so a system that calls into another (such as TakePointDamage into CharacterDeath) also counts the time spent in it.
+*/
+struct OUTPOST_API FOPProfiler
+{
+	//Starts or stops timing every profiled system. Nothing is timed while this is off, so profiled scopes cost a single branch.
+	static void SetTimingEnabled(bool bEnabled);
+
+	static FORCEINLINE bool IsTimingEnabled() { return bTimingEnabled; }
+
+	//Starts or stops recording the stats group and the trace channel.
+	static void SetProfilingEnabled(bool bEnabled);
+
+	static FORCEINLINE bool IsProfilingEnabled() { return bProfilingEnabled; }
+
+	//Clears everything that has been timed so far.
+	static void Reset();
+
+	static void AddTime(EOPProfiledSystem System, uint64 Cycles);
+
+	//Returns the total time spent in a system, in seconds.
+	static double GetTotalSeconds(EOPProfiledSystem System);
+
+	//Returns the longest that a single run of a system took, in seconds.
+	static double GetMaxSeconds(EOPProfiledSystem System);
+
+	static int64 GetCallCount(EOPProfiledSystem System);
+
+	static const TCHAR* GetSystemName(EOPProfiledSystem System);
+
+	/* Counters */
+
+	static FORCEINLINE void CountTrace()
+	{
+		if (bProfilingEnabled)
+		{
+			INC_DWORD_STAT(STAT_OPTraces);
+		}
+	}
+
+	static FORCEINLINE void CountImpactEffect()
+	{
+		if (bProfilingEnabled)
+		{
+			INC_DWORD_STAT(STAT_OPImpactEffects);
+		}
+	}
+
+	//The live enemy and ragdoll counts are always kept up to date, so that they're already right when profiling is turned on.
+	static void SetLiveEnemyCount(int32 Count);
+	static void AdjustRagdollCount(int32 Delta);
+
+private:
+	static bool bTimingEnabled;
+	static bool bProfilingEnabled;
+
+	static uint64 TotalCycles[(int32)EOPProfiledSystem::Count];
+	static uint64 MaxCycles[(int32)EOPProfiledSystem::Count];
+	static int64 CallCounts[(int32)EOPProfiledSystem::Count];
+
+	static int32 LiveEnemyCount;
+	static int32 RagdollCount;
+};
+
+//Times everything from where it is declared until the end of the enclosing scope, for the combat benchmark.
+struct FOPProfilerScope
+{
+	FORCEINLINE explicit FOPProfilerScope(EOPProfiledSystem InSystem) : System(InSystem), StartCycles(FOPProfiler::IsTimingEnabled() ? FPlatformTime::Cycles64() : 0) {}
+
+	FORCEINLINE ~FOPProfilerScope()
+	{
+		if (StartCycles != 0) FOPProfiler::AddTime(System, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+	EOPProfiledSystem System;
+	uint64 StartCycles;
+};
+
+//Profiles everything from where it is declared until the end of the enclosing scope: for the combat benchmark, the stats group and the trace channel.
+#define OP_PROFILE_SCOPE(System) \
+	FOPProfilerScope ANONYMOUS_VARIABLE(OPProfilerScope)(EOPProfiledSystem::System); \
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(STAT_OP##System, FOPProfiler::IsProfilingEnabled()); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR("Outpost::" #System, OutpostChannel)
+
+#define OP_COUNT_TRACE() FOPProfiler::CountTrace()
+#define OP_COUNT_IMPACT_EFFECT() FOPProfiler::CountImpactEffect()
+#define OP_SET_LIVE_ENEMIES(Count) FOPProfiler::SetLiveEnemyCount(Count)
+#define OP_ADJUST_RAGDOLLS(Delta) FOPProfiler::AdjustRagdollCount(Delta)
+
+#else
+
+#define OP_PROFILE_SCOPE(System)
+
+//The counters still expand to a statement, so that they can be the body of an if.
+#define OP_COUNT_TRACE() ((void)0)
+#define OP_COUNT_IMPACT_EFFECT() ((void)0)
+#define OP_SET_LIVE_ENEMIES(Count) ((void)0)
+#define OP_ADJUST_RAGDOLLS(Delta) ((void)0)
+
+#endif
\ No newline at end of file
@@ -8,6 +8,12 @@ This class contains all of the custom structs that will be used in the Outpost p
 #include "NiagaraSystem.h"
 #include "OPStructs.generated.h"
 
+//Forward declarations.
+class AOPEnemy;
+class AOPWeapon;
+class UStaticMesh;
+class UMaterialInterface;
+
 //A struct for weapon attributes.
 USTRUCT(BlueprintType)
 struct FWeaponStats
@@ -122,4 +128,238 @@ struct FCharacterMaterials
 	//The physical material that determines if a character receives limb damage.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
 		TObjectPtr<UPhysicalMaterial> LimbMaterial;
+};
+
+//A struct for a group of enemies that appear in a wave.
+USTRUCT(BlueprintType)
+struct FWaveEnemyGroup
+{
+	GENERATED_BODY()
+
+	//The class of enemy that this group is made up of.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TSoftClassPtr<AOPEnemy> EnemyClass;
+
+	//The number of enemies in this group.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		int32 Count = 1;
+};
+
+//A struct for performance and progress information about a single wave.
+USTRUCT(BlueprintType)
+struct FWaveTelemetry
+{
+	GENERATED_BODY()
+
+	//The index of the wave that this information belongs to.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 WaveIndex = INDEX_NONE;
+
+	//The number of enemies that have been spawned by this wave so far.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 EnemiesSpawned;
+
+	//The number of enemies that are currently alive.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 EnemiesAlive;
+
+	//The time, in seconds, between the wave starting and its last enemy being spawned.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		float SpawnLatency;
+
+	//The time, in seconds, between the wave starting and its last enemy being killed.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		float TimeToClear;
+
+	//The longest time, in milliseconds, that spawning took in any single frame.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		float PeakSpawnFrameMs;
+
+	//The number of frames that spawning was spread across.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 SpawnFrames;
+};
+
+//A struct for a single item that a character might drop when they die.
+USTRUCT(BlueprintType)
+struct FLootDrop
+{
+	GENERATED_BODY()
+
+	//The chance, between 0 and 1, that this item is dropped.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		float DropChance = 1.f;
+
+	//If set, this item is a weapon of this class. Otherwise, it's a pile of reserve ammo.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TSubclassOf<AOPWeapon> WeaponClass;
+
+	//The category of weapon that the reserve ammo belongs to.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		EWeaponType AmmoType;
+
+	//The least amount of reserve ammo that can be dropped.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		int32 MinAmmo = 1;
+
+	//The most amount of reserve ammo that can be dropped.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		int32 MaxAmmo = 1;
+
+	//The mesh that represents the reserve ammo, while it's lying on the ground.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TObjectPtr<UStaticMesh> AmmoMesh;
+};
+
+//A struct for a single change in the player's cash. Every reward of the same kind, from the same source, in the same frame is combined into one of these.
+USTRUCT(BlueprintType)
+struct FEconomyTransaction
+{
+	GENERATED_BODY()
+
+	//The position of this transaction in the log. Starts at 0, and goes up by 1 for each transaction.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 Sequence;
+
+	//The index of the wave that this transaction happened during.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 WaveIndex = INDEX_NONE;
+
+	//What caused the change in cash.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		EEconomyEvent Event;
+
+	//The number of events that were combined into this transaction. For example, the number of enemies killed by a single shotgun blast.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 Count;
+
+	//The number of the combined kills that were headshots.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 Headshots;
+
+	//The change in cash. Negative for purchases and penalties.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 Amount;
+
+	//The player's cash, after this transaction was applied.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 BalanceAfter;
+};
+
+//A struct for a single item that can be bought from the shop.
+USTRUCT(BlueprintType)
+struct FShopItem
+{
+	GENERATED_BODY()
+
+	//The name of this item, as shown in the shop.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		FText DisplayName = FText::FromString("Item");
+
+	//The amount of cash this item costs.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		int32 Price = 100;
+
+	//If set, this item is a weapon of this class. Otherwise, it's reserve ammo. Only loaded once the item is hovered in the shop.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TSoftClassPtr<AOPWeapon> WeaponClass;
+
+	//The category of weapon that the reserve ammo belongs to.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		EWeaponType AmmoType;
+
+	//The amount of reserve ammo the player receives.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		int32 AmmoAmount = 30;
+
+	//Any other assets that should be loaded along with this item, such as ones that the weapon only references softly.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TArray<TSoftObjectPtr<UObject>> AdditionalAssets;
+};
+
+//A struct for a single weapon in the player's inventory, as it's written to a save game.
+USTRUCT(BlueprintType)
+struct FSavedWeapon
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		TSoftClassPtr<AOPWeapon> WeaponClass;
+
+	//The amount of ammo that was left in the weapon's magazine.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 CurrentMagazine;
+
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		EFireMode CurrentFireMode;
+};
+
+//A struct for a single generated gameplay object that has changed since the area was generated, as it's written to a save game.
+USTRUCT(BlueprintType)
+struct FSavedCellActor
+{
+	GENERATED_BODY()
+
+	//The streaming cell that the object is in.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		FIntPoint Cell;
+
+	//The object's index among the cell's records. The same seed always generates the same records, so this always finds the same object again.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		int32 RecordIndex = INDEX_NONE;
+
+	//Whether the object was used up, such as a crate that was looted.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		bool bIsConsumed;
+
+	//The health of each chunk, if the object is a barricade that has been damaged. Empty if it's intact.
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
+		TArray<uint8> ChunkHealth;
+};
+
+//A struct for one kind of object that level generation scatters around the area.
+USTRUCT(BlueprintType)
+struct FGenerationRule
+{
+	GENERATED_BODY()
+
+	//The mesh that is placed. Meshes are drawn with instancing, and are the cheapest way to fill out the area.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TObjectPtr<UStaticMesh> Mesh;
+
+	//If set, an actor of this class is spawned instead of the mesh. Should only be used for objects that need their own behaviour, such as loot crates, which are registered as interactables.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TSubclassOf<AActor> ActorClass;
+
+	//The number of copies that generation tries to place. Fewer may be placed if the area is too crowded.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		int32 Count = 20;
+
+	//The minimum distance between a copy of this object and anything else placed by the same stage.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		float Spacing = 200.f;
+
+	//The smallest random scale that a copy can have.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		float MinScale = 1.f;
+
+	//The largest random scale that a copy can have.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		float MaxScale = 1.f;
+
+	//Determines whether each copy is given a random yaw, or not.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		bool bRandomYaw = true;
+
+	//If set, copies of the mesh are drawn with this material instead of the mesh's own.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		TObjectPtr<UMaterialInterface> MaterialOverride;
+
+	//How far away copies of the mesh stop being drawn. If 0, they are always drawn.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		float CullDistance;
+
+	//Determines whether copies of the mesh block characters and weapon traces, or not. Has no effect on actors.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
+		bool bHasCollision = true;
 };
\ No newline at end of file
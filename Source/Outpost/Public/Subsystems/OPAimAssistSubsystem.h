@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPAimAssistSubsystem.generated.h"
+
+//Forward declarations.
+class UUASAimAssistTargetComponent;
+class UOPEnemyGridSubsystem;
+
+/**
+ * Decides which enemies the aim assist system is allowed to consider. Every enemy's aim assist target starts out disabled when it enters play,
+ * and is only enabled while the enemy is inside of the player's view cone and within assist range.
+ * This keeps the cost of aim assist tied to the enemies on screen, rather than every enemy in the level.
+ */
+UCLASS()
+class OUTPOST_API UOPAimAssistSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	//Returns the number of aim assist targets that are currently enabled.
+	UFUNCTION(BlueprintPure, Category = "OPAimAssistSubsystem")
+		FORCEINLINE int32 GetEnabledTargetCount() const { return EnabledTargets.Num(); }
+
+	//Enemies further away than this are never considered for aim assist.
+	UPROPERTY(BlueprintReadWrite, Category = "OPAimAssistSubsystem")
+		float AssistRange = 5000.f;
+
+	//Enemies further than this angle, in degrees, from the center of the player's view are never considered for aim assist.
+	UPROPERTY(BlueprintReadWrite, Category = "OPAimAssistSubsystem")
+		float AssistHalfAngle = 30.f;
+
+	//The maximum number of aim assist targets that can be enabled at once. The ones closest to the center of the player's view win.
+	UPROPERTY(BlueprintReadWrite, Category = "OPAimAssistSubsystem")
+		int32 MaxEnabledTargets = 12;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPEnemyGridSubsystem> EnemyGrid;
+
+	//Every aim assist target that is currently enabled.
+	UPROPERTY()
+		TArray<TObjectPtr<UUASAimAssistTargetComponent>> EnabledTargets;
+
+	void OnEnemyRegistered(AActor* Enemy);
+	void OnEnemyUnregistered(AActor* Enemy);
+
+	UUASAimAssistTargetComponent* GetAimAssistTarget(AActor* Enemy) const;
+};
\ No newline at end of file
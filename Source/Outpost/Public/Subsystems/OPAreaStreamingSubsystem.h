@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPEnums.h"
+#include "OPAreaStreamingSubsystem.generated.h"
+
+//Forward declarations.
+class UHierarchicalInstancedStaticMeshComponent;
+class UStaticMesh;
+class UMaterialInterface;
+class UOPWorldSubsystem;
+class UOPSaveGame;
+struct FGenerationRule;
+
+//Every copy of a single mesh and material in a streaming cell. Drawn by one component while the cell is loaded.
+struct FOPInstanceBatch
+{
+	UStaticMesh* Mesh = nullptr;
+	UMaterialInterface* Material = nullptr;
+
+	TArray<FTransform> Transforms;
+
+	//The furthest cull distance of every rule in the batch. If 0, the batch is always drawn.
+	float CullDistance = 0.f;
+
+	bool bHasCollision = false;
+};
+
+//A gameplay object in a streaming cell, along with whatever happened to it the last time the cell was loaded.
+struct FOPCellActor
+{
+	TSubclassOf<AActor> ActorClass;
+	FTransform Transform;
+
+	//The health of each chunk, if the object is a barricade that has been damaged. Empty if it's intact.
+	TArray<uint8> ChunkHealth;
+
+	//Whether the object was used up, such as a crate that was looted, and should never be spawned again.
+	bool bIsConsumed = false;
+};
+
+//A single square of the generated area. Only its records are kept while it's unloaded.
+USTRUCT()
+struct FOPStreamingCell
+{
+	GENERATED_BODY()
+
+	//One component for every batch, while the cell is loaded.
+	UPROPERTY()
+		TArray<TObjectPtr<UHierarchicalInstancedStaticMeshComponent>> Components;
+
+	//One actor for every actor record, while the cell is loaded at full detail. Consumed records have no actor.
+	UPROPERTY()
+		TArray<TObjectPtr<AActor>> Actors;
+
+	TArray<FOPInstanceBatch> Batches;
+	TArray<FOPCellActor> ActorRecords;
+
+	//Where enemy reinforcements can arrive from, inside of this cell.
+	TArray<FVector> SpawnZones;
+
+	FBox2D Bounds = FBox2D(ForceInit);
+
+	ECellDetail Detail = ECellDetail::Unloaded;
+};
+
+/**
+ * Streams the generated area in and out in square cells, based on how far away they are from the player.
+ * Cells near the player are loaded at full detail, with collision and every gameplay object. Cells further away are drawn with their lowest level of detail, without any gameplay objects.
+ * Cells that are further still are unloaded entirely, and only keep a compact record of what happened in them, such as crates that were looted and barricades that were damaged.
+ */
+UCLASS()
+class OUTPOST_API UOPAreaStreamingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	//Removes every cell, and everything that was loaded from them. Should be called before a new area is added.
+	void ClearCells();
+
+	//Sets the width of each cell. Must be called before anything is added.
+	void SetCellSize(float NewCellSize);
+
+	//Adds a copy of a generated mesh to the cell that it's in.
+	void AddInstance(const FGenerationRule& Rule, const FTransform& Transform);
+
+	//Adds a generated gameplay object to the cell that it's in.
+	void AddActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform);
+
+	//Adds a spawn zone to the cell that it's in. Cells with spawn zones are never fully unloaded, so enemies always arrive through solid ground.
+	void AddSpawnZone(const FVector& Location);
+
+	//Starts streaming cells in and out, and loads every cell around the player straight away. Should be called once everything has been added.
+	void StartStreaming(FVector PlayerLocation);
+
+	/*
+	Writes the gameplay objects that differ from how they were generated to a save game.
+	@param	SaveGame	The save game to write to.
+	@param	bOnlyDirty	If "true", only the objects that changed since the last time ClearDirtyRecords() was called are written.
+	*/
+	void WriteToSaveGame(UOPSaveGame* SaveGame, bool bOnlyDirty);
+
+	//Applies the gameplay objects in a save game to the area. Should be called once the area has been generated from the save game's seed.
+	void ReadFromSaveGame(const UOPSaveGame* SaveGame);
+
+	//Forgets which gameplay objects have changed. Should be called once they have been written to a save game.
+	void ClearDirtyRecords();
+
+	//Returns the number of gameplay objects that have changed since ClearDirtyRecords() was last called.
+	FORCEINLINE int32 GetDirtyRecordCount() const { return DirtyRecords.Num(); }
+
+	//Returns how much of the cell at a location is currently loaded.
+	UFUNCTION(BlueprintPure, Category = "OPAreaStreamingSubsystem")
+		ECellDetail GetCellDetail(FVector Location) const;
+
+	//Cells closer to the player than this are loaded at full detail.
+	UPROPERTY(BlueprintReadWrite, Category = "OPAreaStreamingSubsystem")
+		float FullDetailDistance = 12000.f;
+
+	//Cells closer to the player than this, but outside of the full detail distance, are loaded as proxies. Cells further away are unloaded.
+	UPROPERTY(BlueprintReadWrite, Category = "OPAreaStreamingSubsystem")
+		float ProxyDistance = 30000.f;
+
+	//The most time, in milliseconds, that loading and unloading cells is allowed to take in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPAreaStreamingSubsystem")
+		float StreamingBudgetMs = 1.f;
+
+	/* Stats */
+
+	UPROPERTY(BlueprintReadOnly, Category = "OPAreaStreamingSubsystem|Stats")
+		int32 FullCells;
+
+	UPROPERTY(BlueprintReadOnly, Category = "OPAreaStreamingSubsystem|Stats")
+		int32 ProxyCells;
+
+	//The number of instanced components that are currently loaded, across every cell.
+	UPROPERTY(BlueprintReadOnly, Category = "OPAreaStreamingSubsystem|Stats")
+		int32 LoadedComponents;
+
+	//The number of gameplay objects that are currently loaded, across every cell.
+	UPROPERTY(BlueprintReadOnly, Category = "OPAreaStreamingSubsystem|Stats")
+		int32 LoadedActors;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+
+	//The actor that owns every instanced mesh component. It never ticks, and is spawned the first time a cell is loaded.
+	UPROPERTY()
+		TObjectPtr<AActor> CellOwner;
+
+	UPROPERTY()
+		TMap<FIntPoint, FOPStreamingCell> Cells;
+
+	//The cell and record index of every gameplay object that is currently loaded, so that it can be found again when it's destroyed.
+	TMap<TObjectKey<AActor>, TPair<FIntPoint, int32>> ActorRecordLookup;
+
+	//The cell and record index of every gameplay object that has changed since the last save.
+	TSet<TPair<FIntPoint, int32>> DirtyRecords;
+
+	//Scratch space for the cells that need to change this frame, with their new detail and distance to the player.
+	TArray<TTuple<FIntPoint, ECellDetail, float>> PendingChanges;
+
+	float CellSize = 8000.f;
+
+	bool bIsStreaming;
+
+	FIntPoint GetCellCoordinates(const FVector& Location) const;
+
+	FOPStreamingCell& FindOrAddCell(const FVector& Location);
+
+	//Returns the detail that a cell should be loaded at, for the player's current location.
+	ECellDetail GetTargetDetail(const FIntPoint& CellCoordinates, const FOPStreamingCell& Cell, const FVector& PlayerLocation, const FVector& OutpostLocation) const;
+
+	//Moves every cell towards the detail it should be loaded at, closest to the player first. If bUseBudget is "false", every cell is changed at once.
+	void UpdateCells(const FVector& PlayerLocation, bool bUseBudget);
+
+	void SetCellDetail(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell, ECellDetail NewDetail);
+
+	void LoadComponents(FOPStreamingCell& Cell);
+	void UnloadComponents(FOPStreamingCell& Cell);
+
+	void LoadActors(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell);
+
+	//Records the state of every gameplay object in a cell, and then removes them.
+	void UnloadActors(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell);
+
+	//Copies the current state of a loaded gameplay object into its record, and marks the record as dirty if anything changed.
+	void UpdateRecord(const FIntPoint& CellCoordinates, FOPStreamingCell& Cell, int32 RecordIndex);
+
+	//Marks a gameplay object's record as consumed, if it's destroyed by anything other than streaming.
+	UFUNCTION()
+		void OnCellActorDestroyed(AActor* DestroyedActor);
+
+	//Returns the actor that owns every instanced mesh component, spawning it if it doesn't exist yet.
+	AActor* GetCellOwner();
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPBarricadeSubsystem.generated.h"
+
+//Forward declarations.
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+//Every instance of a single mesh that barricade chunks are drawn with.
+USTRUCT()
+struct FOPBarricadeMeshInstances
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	//Instances that have been hidden, and can be reused. Instances are never removed, so the indices held by barricades never shift.
+	TArray<int32> FreeInstances;
+};
+
+/**
+ * Draws every barricade chunk in the level, with one instanced mesh component per chunk mesh.
+ * Changing a chunk's damage state moves it from one mesh's instances to another's, so intact and damaged barricades alike cost a handful of draw calls in total.
+ */
+UCLASS()
+class OUTPOST_API UOPBarricadeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	/*
+	Adds an instance of a chunk mesh to the level.
+	@param	Mesh	The mesh that the chunk is drawn with.
+	@param	Transform	Where the chunk should be drawn.
+	@return	The index of the new instance, or INDEX_NONE if it couldn't be added.
+	*/
+	int32 AddChunkInstance(UStaticMesh* Mesh, const FTransform& Transform);
+
+	/*
+	Hides an instance of a chunk mesh, so that it can be reused by another chunk.
+	@param	Mesh	The mesh that the chunk was drawn with.
+	@param	InstanceIndex	The index returned by AddChunkInstance.
+	*/
+	void RemoveChunkInstance(UStaticMesh* Mesh, int32 InstanceIndex);
+
+protected:
+	//The actor that owns every instanced mesh component. It never ticks, and is spawned the first time a chunk is added.
+	UPROPERTY()
+		TObjectPtr<AActor> BarricadeOwner;
+
+	UPROPERTY()
+		TMap<TObjectPtr<UStaticMesh>, FOPBarricadeMeshInstances> MeshInstances;
+
+	FOPBarricadeMeshInstances* GetMeshInstances(UStaticMesh* Mesh);
+};
\ No newline at end of file
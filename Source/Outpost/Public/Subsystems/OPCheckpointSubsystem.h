@@ -0,0 +1,140 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Subsystems/OPSaveSubsystem.h"
+#include "Data/OPCheckpoint.h"
+#include "OPCheckpointSubsystem.generated.h"
+
+//Forward declarations.
+class AOPPlayer;
+class AOutpostGameModeBase;
+class UOPWorldSubsystem;
+class UOPEnemyPoolSubsystem;
+class UOPCrowdSubsystem;
+class UOPLootSubsystem;
+class UOPPerceptionSubsystem;
+class UOPEconomySubsystem;
+
+/**
+ * Takes snapshots of a wave partway through, so that it can be retried from that point: every live enemy, every crowd entity, every pickup, the player, and the wave's progress.
+ * Capturing is a single pass on the game thread that copies everything into flat arrays. The most recent checkpoint is kept in memory for quick retries,
+ * and can also be packed and handed to the save subsystem, which compresses and writes it in the background.
+ * Restoring puts enemies back through the enemy pool, so retrying a wave never spawns anything that the pool already has.
+ */
+UCLASS()
+class OUTPOST_API UOPCheckpointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/*
+	Takes a checkpoint of the wave that is currently being fought, and keeps it for quick retries.
+	@param	SlotName	If set, the checkpoint is also written to this save slot in the background.
+	@return	Was a checkpoint taken? Checkpoints are only taken partway through a wave, while the player is alive.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPCheckpointSubsystem")
+		bool CaptureCheckpoint(const FString& SlotName);
+
+	/*
+	Puts the level back to how it was when the most recent checkpoint was taken.
+	@return	Was the checkpoint restored? It can only be restored into the wave that it was taken in, once that wave's assets have loaded, while the player is alive.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPCheckpointSubsystem")
+		bool RestoreCheckpoint();
+
+	/*
+	Starts reading a checkpoint from a save slot in the background. OnCheckpointLoaded is broadcast once it has been read,
+	after which it replaces the checkpoint in memory and can be restored as soon as its wave has been prepared.
+	@param	SlotName	The name of the save slot to read from.
+	@return	Was reading started?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPCheckpointSubsystem")
+		bool LoadCheckpoint(const FString& SlotName);
+
+	//Returns "true" if there is a checkpoint in memory that can be restored.
+	UFUNCTION(BlueprintPure, Category = "OPCheckpointSubsystem")
+		FORCEINLINE bool HasCheckpoint() const { return bHasCheckpoint; }
+
+	//Returns the index of the wave that the checkpoint in memory was taken in, or INDEX_NONE if there isn't one.
+	UFUNCTION(BlueprintPure, Category = "OPCheckpointSubsystem")
+		FORCEINLINE int32 GetCheckpointWaveIndex() const { return bHasCheckpoint ? Checkpoint.WaveIndex : INDEX_NONE; }
+
+	//Forgets about the checkpoint in memory. Should be called once its wave has been cleared.
+	UFUNCTION(BlueprintCallable, Category = "OPCheckpointSubsystem")
+		void ClearCheckpoint();
+
+	/* Stats */
+
+	//How long the most recent capture took on the game thread, in milliseconds, including packing it for disk.
+	UPROPERTY(BlueprintReadOnly, Category = "OPCheckpointSubsystem|Stats")
+		float LastCaptureMs;
+
+	//How long the most recent restore took, in milliseconds.
+	UPROPERTY(BlueprintReadOnly, Category = "OPCheckpointSubsystem|Stats")
+		float LastRestoreMs;
+
+	//The size of the most recent checkpoint that was written, in bytes, before it was compressed.
+	UPROPERTY(BlueprintReadOnly, Category = "OPCheckpointSubsystem|Stats")
+		int32 LastCheckpointSize;
+
+	//The number of enemies and crowd entities in the most recent checkpoint.
+	UPROPERTY(BlueprintReadOnly, Category = "OPCheckpointSubsystem|Stats")
+		int32 LastEnemyCount;
+
+	/* Delegates */
+
+	//Broadcast on the game thread once a checkpoint has been read from a save slot.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPCheckpointSubsystem|Delegates")
+		FSaveGameDelegate OnCheckpointLoaded;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+
+	UPROPERTY()
+		TObjectPtr<UOPEnemyPoolSubsystem> EnemyPool;
+
+	UPROPERTY()
+		TObjectPtr<UOPCrowdSubsystem> Crowd;
+
+	UPROPERTY()
+		TObjectPtr<UOPLootSubsystem> Loot;
+
+	UPROPERTY()
+		TObjectPtr<UOPPerceptionSubsystem> Perception;
+
+	UPROPERTY()
+		TObjectPtr<UOPEconomySubsystem> Economy;
+
+	//The most recent checkpoint. Its arrays are reused by every capture, so taking checkpoints doesn't allocate once they have grown.
+	FOPCheckpoint Checkpoint;
+
+	bool bHasCheckpoint;
+
+	UOPSaveSubsystem* GetSaveSubsystem() const;
+
+	//Returns the game mode and the player, if there is a wave in progress that checkpoints can be taken of or restored into.
+	bool GetCheckpointActors(AOutpostGameModeBase*& OutGameMode, AOPPlayer*& OutPlayer) const;
+
+	void WritePlayer(AOPPlayer* Player);
+	void WriteEnemies();
+
+	void ReadPlayer(AOPPlayer* Player);
+
+	//Returns every live enemy to the enemy pool, and then brings back the ones in the checkpoint.
+	void ReadEnemies();
+
+	/*
+	Unpacks a checkpoint that was read and decompressed in the background.
+	@param	Bytes	The checkpoint, without its header. Empty if it couldn't be read.
+	@param	Version	The version of the format that the checkpoint was written in.
+	*/
+	void OnCheckpointRead(const TArray<uint8>& Bytes, int32 Version, FString SlotName);
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPCorpseSubsystem.generated.h"
+
+//Forward declarations.
+class UPoseableMeshComponent;
+
+/**
+ *
+ */
+UCLASS()
+class OUTPOST_API UOPCorpseSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	/*
+	Snapshots the current pose of a skeletal mesh into a lightweight corpse, that persists for the rest of the match.
+	The character that owned the mesh can be cleared from the level as soon as this returns.
+	@param	SourceMesh	The (usually ragdolled) skeletal mesh whose pose should be copied.
+	@return	Was a corpse created?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPCorpseSubsystem")
+		bool BakeCorpse(USkeletalMeshComponent* SourceMesh);
+
+	//Hides every corpse in the level, and returns them all to the pool.
+	UFUNCTION(BlueprintCallable, Category = "OPCorpseSubsystem")
+		void ClearAllCorpses();
+
+	//Returns the number of corpses that are currently visible in the level.
+	UFUNCTION(BlueprintPure, Category = "OPCorpseSubsystem")
+		FORCEINLINE int32 GetCorpseCount() { return CorpseCount; }
+
+	/*
+	The maximum number of corpses that can be in the level at once.
+	Once this limit is reached, the oldest corpse is recycled for the newest one.
+	*/
+	UPROPERTY(BlueprintReadWrite, Category = "OPCorpseSubsystem")
+		int32 MaxCorpses = 128;
+
+protected:
+	//The actor that owns every corpse component. It never ticks, and is spawned the first time a corpse is baked.
+	UPROPERTY()
+		TObjectPtr<AActor> CorpseOwner;
+
+	//Every corpse component that has been created so far, used as a ring buffer.
+	UPROPERTY()
+		TArray<TObjectPtr<UPoseableMeshComponent>> CorpsePool;
+
+	UPoseableMeshComponent* GetNextCorpseComponent();
+
+	//The index of the pooled corpse component that will be used next.
+	int32 NextCorpseIndex;
+
+	int32 CorpseCount;
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPCrowdSubsystem.generated.h"
+
+//Forward declarations.
+class AOPEnemy;
+class UInstancedStaticMeshComponent;
+class UOPWorldSubsystem;
+class UOPEnemyPoolSubsystem;
+class UOPFlowFieldSubsystem;
+struct FOPCheckpoint;
+
+//Every crowd entity of a single enemy class, stored as parallel arrays so that they can be moved in one tight loop.
+USTRUCT()
+struct FOPCrowdType
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TSubclassOf<AOPEnemy> EnemyClass;
+
+	//Draws every entity of this class, one instance per entity, in the same order as the arrays below.
+	UPROPERTY()
+		TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+	TArray<FVector> Locations;
+	TArray<FVector> Directions;
+	TArray<int32> Health;
+
+	float MoveSpeed = 0.f;
+	float HalfHeight = 0.f;
+};
+
+/**
+ * Simulates distant enemy reinforcements as lightweight crowd entities, instead of full enemy actors.
+ * Entities follow the flow field and are drawn with instanced meshes. They are promoted to real enemies once they come within engagement range,
+ * and real enemies are demoted back into entities once they are far away again.
+ */
+UCLASS()
+class OUTPOST_API UOPCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Adds an enemy to the level. Enemies that spawn within engagement range are spawned as real enemies, and everything else becomes a crowd entity.
+	@param	EnemyClass	The class of enemy that should be spawned.
+	@param	SpawnTransform	Where the enemy should be placed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPCrowdSubsystem")
+		void SpawnEnemy(TSubclassOf<AOPEnemy> EnemyClass, const FTransform& SpawnTransform);
+
+	//Returns the number of crowd entities that are still approaching.
+	UFUNCTION(BlueprintPure, Category = "OPCrowdSubsystem")
+		int32 GetEntityCount() const;
+
+	//Removes every crowd entity, without promoting them.
+	UFUNCTION(BlueprintCallable, Category = "OPCrowdSubsystem")
+		void ClearAllEntities();
+
+	//Adds every crowd entity to a checkpoint. Each crowd type is already stored as parallel arrays, so it's copied across in blocks.
+	void WriteToCheckpoint(FOPCheckpoint& Checkpoint) const;
+
+	//Replaces every crowd entity with the ones in a checkpoint.
+	void ReadFromCheckpoint(const FOPCheckpoint& Checkpoint);
+
+	//Crowd entities that come within this distance of the player or the outpost are promoted to real enemies.
+	UPROPERTY(BlueprintReadWrite, Category = "OPCrowdSubsystem|Promotion")
+		float PromotionRadius = 6000.f;
+
+	//Real enemies that are further than this from both the player and the outpost are demoted to crowd entities. Should be larger than the promotion radius.
+	UPROPERTY(BlueprintReadWrite, Category = "OPCrowdSubsystem|Promotion")
+		float DemotionRadius = 9000.f;
+
+	//The maximum number of real enemies that can be in the level at once. Entities wait at the edge of engagement range until there's room.
+	UPROPERTY(BlueprintReadWrite, Category = "OPCrowdSubsystem|Promotion")
+		int32 MaxPromotedEnemies = 48;
+
+	//The maximum number of entities that can be promoted, or enemies demoted, in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPCrowdSubsystem|Promotion")
+		int32 MaxPromotionsPerFrame = 4;
+
+	//The number of entities that were promoted to real enemies, since the level started.
+	UPROPERTY(BlueprintReadOnly, Category = "OPCrowdSubsystem|Stats")
+		int32 TotalPromotions;
+
+	//The number of real enemies that were demoted to entities, since the level started.
+	UPROPERTY(BlueprintReadOnly, Category = "OPCrowdSubsystem|Stats")
+		int32 TotalDemotions;
+
+protected:
+	UPROPERTY()
+		TArray<FOPCrowdType> CrowdTypes;
+
+	//Owns every instanced mesh component. Spawned the first time that it's needed.
+	UPROPERTY()
+		TObjectPtr<AActor> CrowdOwner;
+
+	UPROPERTY()
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+
+	UPROPERTY()
+		TObjectPtr<UOPEnemyPoolSubsystem> EnemyPool;
+
+	UPROPERTY()
+		TObjectPtr<UOPFlowFieldSubsystem> FlowField;
+
+	void MoveEntities(float DeltaTime);
+	void PromoteEntities();
+	void DemoteEnemies();
+	void UpdateInstances();
+
+	//Returns "true" if a location is close enough to the player or the outpost to need a real enemy.
+	bool IsWithinRadius(const FVector& Location, float Radius) const;
+
+	int32 AddEntity(TSubclassOf<AOPEnemy> EnemyClass, const FVector& Location, int32 Health);
+	AOPEnemy* PromoteEntity(FOPCrowdType& CrowdType, int32 EntityIndex);
+	FOPCrowdType* FindOrAddCrowdType(TSubclassOf<AOPEnemy> EnemyClass);
+
+	//The player's location this frame, used for every distance check.
+	FVector PlayerLocation;
+	bool bHasPlayerLocation;
+};
\ No newline at end of file
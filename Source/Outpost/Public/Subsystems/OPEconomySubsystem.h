@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPStructs.h"
+#include "OPEconomySubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FEconomyDelegate, int32, Balance, const TArray<FEconomyTransaction>&, Transactions);
+
+//A reward or penalty that has been recorded this frame, but not yet applied to the player's cash.
+struct FOPLedgerEntry
+{
+	EEconomyEvent Event;
+
+	//The object that caused the event, such as the weapon that made a kill. Events from the same source in the same frame are combined.
+	TObjectKey<UObject> Source;
+
+	int32 Count = 0;
+	int32 Headshots = 0;
+	int32 Amount = 0;
+};
+
+/**
+ * Keeps track of the player's cash. Kills, wave clears and damage taken are recorded into a ledger as they happen,
+ * and the ledger is applied once per frame: the balance changes once, and the HUD is sent a single batch of transactions.
+ * Every kill made by the same weapon in the same frame, such as a single shotgun blast, is combined into one transaction.
+ * Every applied transaction is kept in a log that can be saved, restored and compared between runs.
+ */
+UCLASS()
+class OUTPOST_API UOPEconomySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/* Events */
+
+	/*
+	Records a kill made by the player.
+	@param	Source	The weapon (or other object) that made the kill.
+	@param	HitZone	The part of the enemy's body that the killing blow hit.
+	*/
+	void RecordKill(const UObject* Source, EHitZone HitZone);
+
+	/*
+	Records damage taken by the player. Taking any damage during a wave forfeits that wave's no-damage bonus.
+	@param	Damage	The amount of damage that was taken.
+	*/
+	void RecordDamageTaken(float Damage);
+
+	//Lets the economy know that a new wave has started.
+	void RecordWaveStarted(int32 WaveIndex);
+
+	//Rewards the player for clearing a wave, and for clearing it without taking damage.
+	void RecordWaveCleared(int32 WaveIndex);
+
+	/*
+	Spends some of the player's cash. Unlike rewards, purchases are checked and taken immediately, so that cash can never be spent twice.
+	Any pending rewards are applied first.
+	@param	Cost	The amount of cash to spend.
+	@return	Did the player have enough cash?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPEconomySubsystem")
+		bool SpendCash(int32 Cost);
+
+	/*
+	Gives back cash that was spent on a purchase that could not be completed. Applied immediately, the same as the purchase was.
+	@param	Amount	The amount of cash to give back.
+	*/
+	void RefundCash(int32 Amount);
+
+	//Applies every entry in the ledger right away, instead of waiting for the end of the frame.
+	UFUNCTION(BlueprintCallable, Category = "OPEconomySubsystem")
+		void FlushLedger();
+
+	/* Balance and transaction log */
+
+	//Returns the player's cash, as of the last time the ledger was applied.
+	UFUNCTION(BlueprintPure, Category = "OPEconomySubsystem")
+		FORCEINLINE int32 GetBalance() const { return Balance; }
+
+	//Returns the player's cash, including any rewards that haven't been applied yet.
+	UFUNCTION(BlueprintPure, Category = "OPEconomySubsystem")
+		int32 GetAvailableCash() const;
+
+	//Returns every transaction that has been applied, in the order that they were applied.
+	FORCEINLINE const TArray<FEconomyTransaction>& GetTransactionLog() const { return TransactionLog; }
+
+	/*
+	Replaces the transaction log, and restores the player's cash from it. Used when loading a save game.
+	@param	SavedLog	The transaction log to restore.
+	*/
+	void RestoreFromLog(const TArray<FEconomyTransaction>& SavedLog);
+
+	//Clears the transaction log, the ledger and the player's cash.
+	UFUNCTION(BlueprintCallable, Category = "OPEconomySubsystem")
+		void ResetEconomy();
+
+	/* Rewards */
+
+	//The amount of cash the player starts with.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		int32 StartingCash = 500;
+
+	//The amount of cash the player receives for each kill.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		int32 KillReward = 50;
+
+	//The extra cash the player receives when the killing blow is a headshot.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		int32 HeadshotBonus = 25;
+
+	//The extra cash the player receives for each kill past the first, when several enemies are killed by the same weapon in the same frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		int32 MultiKillBonus = 10;
+
+	//The amount of cash the player receives for clearing a wave.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		int32 WaveClearedReward = 500;
+
+	//The extra cash the player receives for clearing a wave without taking any damage.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		int32 NoDamageBonus = 250;
+
+	//The amount of cash the player loses for each point of damage taken. Usually 0.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEconomySubsystem|Rewards")
+		float DamagePenaltyPerPoint = 0.f;
+
+	/* Delegates */
+
+	//Broadcast at most once per frame, with every transaction that was applied that frame.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPEconomySubsystem|Delegates")
+		FEconomyDelegate OnBalanceUpdated;
+
+protected:
+	//Every reward and penalty that has been recorded this frame.
+	TArray<FOPLedgerEntry> Ledger;
+
+	//Every transaction that has been applied, in order.
+	TArray<FEconomyTransaction> TransactionLog;
+
+	//Adds an event to the ledger, combining it with an earlier event of the same kind from the same source if there is one.
+	FOPLedgerEntry& RecordEvent(EEconomyEvent Event, const UObject* Source);
+
+	//Applies a single transaction to the player's cash, and adds it to the log. Debits must never be larger than the balance.
+	FEconomyTransaction& ApplyTransaction(EEconomyEvent Event, int32 Count, int32 Headshots, int32 Amount);
+
+	int32 Balance;
+	int32 CurrentWaveIndex = INDEX_NONE;
+
+	//The index of the first transaction that hasn't been sent to the HUD yet.
+	int32 FirstUnbroadcastTransaction;
+
+	bool bTookDamageThisWave;
+};
\ No newline at end of file
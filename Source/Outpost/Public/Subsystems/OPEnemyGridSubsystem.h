@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPEnemyGridSubsystem.generated.h"
+
+//Forward declarations.
+class UOPWorldSubsystem;
+
+/**
+ * Sorts every live enemy into a uniform grid once per frame, so that other systems can find the enemies near a location
+ * without looping over the whole enemy array.
+ */
+UCLASS()
+class OUTPOST_API UOPEnemyGridSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Finds every enemy within a radius of a location, as of the start of this frame.
+	@param	Center	The location to search around.
+	@param	Radius	How far away from the center enemies can be.
+	@param	OutEnemies	Filled with every enemy that was found. Not sorted.
+	*/
+	void QueryRadius(const FVector& Center, float Radius, TArray<AActor*>& OutEnemies) const;
+
+	//The size of each cell in the grid. Should be roughly the radius of the most common query.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEnemyGridSubsystem")
+		float CellSize = 1000.f;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+
+	void RebuildGrid();
+
+	FORCEINLINE FIntPoint GetCell(const FVector& Location) const { return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize)); }
+
+	//Every enemy in each occupied cell. Emptied cells keep their memory, so rebuilding the grid each frame doesn't reallocate.
+	TMap<FIntPoint, TArray<TObjectPtr<AActor>>> Cells;
+};
\ No newline at end of file
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPEnemyPoolSubsystem.generated.h"
+
+//Forward declarations.
+class AOPEnemy;
+
+//All of the dormant enemies of a single class, along with how many more still need to be pre-spawned.
+USTRUCT()
+struct FOPEnemyPoolEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+		TArray<TObjectPtr<AOPEnemy>> DormantEnemies;
+
+	int32 PendingPrewarmCount = 0;
+};
+
+/**
+ *
+ */
+UCLASS()
+class OUTPOST_API UOPEnemyPoolSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Queues up dormant enemies to be pre-spawned, a few at a time, over the next several frames.
+	Meant to be called during the prep time before a wave, so that the wave itself never has to spawn actors.
+	@param	EnemyClass	The class of enemy that should be pre-spawned.
+	@param	Count	The number of dormant enemies of this class that should be available.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPEnemyPoolSubsystem")
+		void PrewarmPool(TSubclassOf<AOPEnemy> EnemyClass, int32 Count);
+
+	/*
+	Takes a dormant enemy out of the pool, and places it in the level. A new enemy is only spawned if the pool is empty.
+	@param	EnemyClass	The class of enemy that should be returned.
+	@param	SpawnTransform	Where the enemy should be placed.
+	@return	The enemy that is now active in the level.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPEnemyPoolSubsystem")
+		AOPEnemy* AcquireEnemy(TSubclassOf<AOPEnemy> EnemyClass, const FTransform& SpawnTransform);
+
+	/*
+	Makes an enemy dormant, and returns it to the pool so that it can be reused by a later wave.
+	@param	Enemy	The enemy that should be returned to the pool.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPEnemyPoolSubsystem")
+		void ReleaseEnemy(AOPEnemy* Enemy);
+
+	//Returns the number of dormant enemies of a particular class that are ready to be used.
+	UFUNCTION(BlueprintPure, Category = "OPEnemyPoolSubsystem")
+		int32 GetDormantCount(TSubclassOf<AOPEnemy> EnemyClass) const;
+
+	//Returns "true" if there are no dormant enemies left to pre-spawn.
+	UFUNCTION(BlueprintPure, Category = "OPEnemyPoolSubsystem")
+		bool IsPrewarmComplete() const;
+
+	//The maximum number of dormant enemies that can be pre-spawned in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEnemyPoolSubsystem")
+		int32 MaxPrewarmSpawnsPerFrame = 2;
+
+	//Where dormant enemies are kept, while they are out of play.
+	UPROPERTY(BlueprintReadWrite, Category = "OPEnemyPoolSubsystem")
+		FVector ParkingLocation = FVector(0.f, 0.f, -100000.f);
+
+	//The number of times an enemy had to be spawned, because the pool was empty.
+	UPROPERTY(BlueprintReadOnly, Category = "OPEnemyPoolSubsystem|Stats")
+		int32 PoolMisses;
+
+protected:
+	//Every dormant enemy in the level, sorted by class.
+	UPROPERTY()
+		TMap<TSubclassOf<AOPEnemy>, FOPEnemyPoolEntry> Pools;
+
+	AOPEnemy* SpawnEnemy(TSubclassOf<AOPEnemy> EnemyClass, const FTransform& SpawnTransform, bool bSpawnDormant);
+};
\ No newline at end of file
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPFlowFieldSubsystem.generated.h"
+
+//Forward declarations.
+class ACharacter;
+
+//A single goal, and the integration field that leads every cell of the grid towards it.
+struct FOPFlowField
+{
+	FVector GoalLocation;
+	int32 GoalCell;
+
+	//The cost of the cheapest path from each cell to the goal. Unreachable cells are left at MAX_flt.
+	TArray<float> Integration;
+
+	//The neighbour that each cell steers towards, as an index into the direction table. Also used to find which cells depend on which.
+	TArray<uint8> Directions;
+};
+
+/**
+ * Steers large numbers of enemies towards shared goals, such as the outpost, using a flow field laid over the navmesh.
+ * Each goal has one integration field, so the cost of pathfinding is paid per goal instead of per enemy.
+ * Blocking or unblocking part of the grid only recalculates the cells whose paths were affected.
+ */
+UCLASS()
+class OUTPOST_API UOPFlowFieldSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Lays the grid over an area of the level, and works out which cells are walkable by checking them against the navmesh.
+	Every existing goal is recalculated for the new grid.
+	@param	NewFieldArea	The area that the flow field should cover. Should include the outpost, and every spawn location.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPFlowFieldSubsystem")
+		void SetFieldArea(const FBox& NewFieldArea);
+
+	//Returns "true" if the grid has been laid over an area of the level.
+	UFUNCTION(BlueprintPure, Category = "OPFlowFieldSubsystem")
+		FORCEINLINE bool HasFieldArea() const { return Costs.Num() > 0; }
+
+	/*
+	Adds a new goal, and calculates its integration field.
+	@param	GoalLocation	The location that agents using this goal should head towards.
+	@return	The ID of the new goal.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPFlowFieldSubsystem")
+		int32 AddGoal(const FVector& GoalLocation);
+
+	/*
+	Blocks or unblocks every cell inside of an area, such as when a barricade is built or destroyed.
+	Changes are collected, and the affected parts of each integration field are recalculated together on the next tick.
+	@param	Region	The area whose cells have changed.
+	@param	bBlocked	Should the cells be blocked, or unblocked?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPFlowFieldSubsystem")
+		void SetRegionBlocked(const FBox& Region, bool bBlocked);
+
+	/*
+	Starts steering a character along a goal's flow field, using its character movement component.
+	@param	Agent	The character that should be steered.
+	@param	GoalId	The goal that the character should head towards. If left invalid, the character heads towards the outpost.
+	*/
+	void RegisterAgent(ACharacter* Agent, int32 GoalId = INDEX_NONE);
+
+	//Stops steering a character.
+	void UnregisterAgent(ACharacter* Agent);
+
+	/*
+	Returns the direction that the flow field would steer a character in, at a particular location.
+	@param	Location	The location that should be sampled.
+	@param	GoalId	The goal that should be headed towards.
+	@return	A flat, normalized direction. Zero if the location is outside of the grid, or can't reach the goal.
+	*/
+	UFUNCTION(BlueprintPure, Category = "OPFlowFieldSubsystem")
+		FVector GetFlowDirection(const FVector& Location, int32 GoalId) const;
+
+	/*
+	Returns the height of the navmesh at a particular location, as found when the grid was built.
+	@param	Location	The location that should be sampled.
+	@param	OutHeight	The height of the navmesh at the location's cell.
+	@return	"true" if the location is on a walkable cell of the grid.
+	*/
+	bool GetGroundHeight(const FVector& Location, float& OutHeight) const;
+
+	//Returns the ID of the outpost's goal, adding it if it doesn't exist yet. Invalid until the grid has been built.
+	int32 GetOutpostGoal();
+
+	//The size of each cell in the grid.
+	UPROPERTY(BlueprintReadWrite, Category = "OPFlowFieldSubsystem|Grid")
+		float CellSize = 200.f;
+
+	//The maximum number of cells along either axis of the grid. Large areas use bigger cells instead of going over this.
+	UPROPERTY(BlueprintReadWrite, Category = "OPFlowFieldSubsystem|Grid")
+		int32 MaxCellsPerAxis = 256;
+
+	//Once an agent is this close to its goal, it stops being steered so that its AI can take over.
+	UPROPERTY(BlueprintReadWrite, Category = "OPFlowFieldSubsystem|Steering")
+		float GoalAcceptanceRadius = 600.f;
+
+	//The number of cells that were recalculated, the last time part of the grid was blocked or unblocked.
+	UPROPERTY(BlueprintReadOnly, Category = "OPFlowFieldSubsystem|Stats")
+		int32 CellsUpdatedLastChange;
+
+protected:
+	void OnEnemyRegistered(AActor* Enemy);
+	void OnEnemyUnregistered(AActor* Enemy);
+
+	void BuildIntegrationField(FOPFlowField& Field);
+	void UpdateIntegrationField(FOPFlowField& Field, const TArray<int32>& ChangedCells);
+	void PropagateIntegrationField(FOPFlowField& Field, TArray<TPair<float, int32>>& OpenCells);
+	void SteerAgents();
+	int32 GetCellIndex(const FVector& Location) const;
+
+	//Finds the cells that a region covers on the grid. Returns "false" if the region doesn't overlap the grid at all.
+	bool GetRegionCells(const FBox& Region, FIntPoint& MinCell, FIntPoint& MaxCell) const;
+
+	FORCEINLINE bool IsCellBlocked(int32 CellIndex) const { return Costs[CellIndex] == BlockedCost || BlockerCounts[CellIndex] > 0; }
+
+	//Every goal's integration field, by ID.
+	TArray<FOPFlowField> Fields;
+
+	//The cost of walking through each cell. Cells that aren't on the navmesh are blocked.
+	TArray<uint8> Costs;
+
+	//The height of the navmesh at the center of each cell.
+	TArray<float> Heights;
+
+	//The number of blocking regions, such as barricades, that are covering each cell.
+	TArray<uint8> BlockerCounts;
+
+	//Every region that is currently blocked, so that they can be applied again if the grid is rebuilt.
+	TArray<FBox> BlockedRegions;
+
+	//Every cell that has been blocked or unblocked since the last tick.
+	TSet<int32> PendingChangedCells;
+
+	//The characters being steered, and the goal that each one is heading towards.
+	TArray<TWeakObjectPtr<ACharacter>> Agents;
+	TArray<int32> AgentGoals;
+
+	FVector GridOrigin;
+	float GridCellSize;
+	int32 NumCellsX;
+	int32 NumCellsY;
+	int32 OutpostGoal = INDEX_NONE;
+
+	static constexpr uint8 BlockedCost = 255;
+	static constexpr uint8 NoDirection = 255;
+};
\ No newline at end of file
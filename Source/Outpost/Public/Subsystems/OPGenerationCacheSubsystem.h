@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPGenerationCacheSubsystem.generated.h"
+
+//Forward declarations.
+struct FOPGeneratedLayout;
+
+/**
+ * Keeps the results of level generation on disk, so that an area only ever has to be generated once for a given seed.
+ * Each layout is written to its own compact binary file, named after its seed and generator version, in the background.
+ * Cached layouts are read back through a memory-mapped file, and are thrown away if the generation settings have changed since they were written.
+ */
+UCLASS()
+class OUTPOST_API UOPGenerationCacheSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	/*
+	Reads a generated layout back from the cache.
+	@param	Seed	The seed that the layout was generated from.
+	@param	GeneratorVersion	The version of the generator that the layout must have been generated by.
+	@param	SettingsHash	A hash of the generation settings. Layouts that were generated from different settings are thrown away.
+	@param	OutLayout	The cached layout, if there was one.
+	@return	Was a matching layout found?
+	*/
+	bool LoadLayout(int32 Seed, int32 GeneratorVersion, uint32 SettingsHash, FOPGeneratedLayout& OutLayout);
+
+	/*
+	Writes a generated layout to the cache. The file is written on a background thread.
+	@param	Layout	The layout to cache. Its placements should already be on the ground.
+	@param	SettingsHash	A hash of the generation settings that the layout was generated from.
+	*/
+	void SaveLayout(const FOPGeneratedLayout& Layout, uint32 SettingsHash);
+
+	//Deletes every cached layout.
+	UFUNCTION(BlueprintCallable, Category = "OPGenerationCacheSubsystem")
+		void ClearCache();
+
+	//The most layouts that are kept on disk. Once this limit is reached, the layouts that were written longest ago are deleted.
+	UPROPERTY(BlueprintReadWrite, Category = "OPGenerationCacheSubsystem")
+		int32 MaxCachedLayouts = 8;
+
+	/* Stats */
+
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationCacheSubsystem|Stats")
+		int32 CacheHits;
+
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationCacheSubsystem|Stats")
+		int32 CacheMisses;
+
+	//The number of cached layouts that were thrown away because the generation settings or the file format had changed.
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationCacheSubsystem|Stats")
+		int32 CacheInvalidations;
+
+protected:
+	//Writes that are still running in the background. They are waited for before the world goes away.
+	TArray<TFuture<void>> PendingWrites;
+
+	//Returns the folder that every cached layout is written to.
+	FString GetCacheDirectory() const;
+
+	FString GetCachePath(int32 Seed, int32 GeneratorVersion) const;
+
+	//Deletes the layouts that were written longest ago, until there are no more than MaxCachedLayouts left. Runs on a background thread.
+	static void TrimCache(const FString& CacheDirectory, int32 MaxLayouts);
+};
\ No newline at end of file
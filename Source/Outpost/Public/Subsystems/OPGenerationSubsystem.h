@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "OPEnums.h"
+#include "OPGenerationSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FGenerationProgressDelegate, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FGenerationDelegate);
+
+//Forward declarations.
+class UOPGenerationSettings;
+class UOPGenerationCacheSubsystem;
+class UOPAreaStreamingSubsystem;
+
+//A single object that level generation decided to place.
+struct FOPGeneratedPlacement
+{
+	EGenerationStage Stage = EGenerationStage::Terrain;
+
+	//The index of the rule in its stage's array, in the generation settings.
+	int32 RuleIndex = INDEX_NONE;
+
+	FTransform Transform;
+};
+
+//Everything that level generation decided on. Placements are made on flat ground, and are moved onto the real ground as they are added to the world.
+struct FOPGeneratedLayout
+{
+	int32 Seed = 0;
+	int32 GeneratorVersion = 0;
+
+	FVector PlayerStart = FVector::ZeroVector;
+	FVector OutpostLocation = FVector::ZeroVector;
+
+	//Where each wave of enemy reinforcements can arrive from.
+	TArray<FVector> SpawnZones;
+
+	//Every placement from every stage, in stage order.
+	TArray<FOPGeneratedPlacement> Placements;
+
+	//Whether the placements have already been moved onto the ground, such as when the layout was read back from the cache.
+	bool bIsOnGround = false;
+};
+
+//A copy of a generation rule, with only what the worker threads need.
+struct FOPGenerationRuleParams
+{
+	int32 Count = 0;
+	float Spacing = 0.f;
+	float MinScale = 1.f;
+	float MaxScale = 1.f;
+	bool bRandomYaw = true;
+};
+
+//A copy of the generation settings, so that the worker threads never touch the settings asset itself.
+struct FOPGenerationParams
+{
+	int32 Seed = 0;
+	FVector Origin = FVector::ZeroVector;
+
+	float AreaHalfExtent = 0.f;
+	float OutpostDistance = 0.f;
+	float OutpostClearRadius = 0.f;
+	float PlayerClearRadius = 0.f;
+	float CoverBandWidth = 0.f;
+	int32 SpawnZoneCount = 0;
+	float SpawnZoneDistance = 0.f;
+	int32 MaxPlacementAttempts = 1;
+
+	//The rules for each stage, indexed by stage.
+	TArray<TArray<FOPGenerationRuleParams>> StageRules;
+};
+
+/**
+ * Generates the area that the player fights in from a single seed, without blocking the game thread.
+ * The layout is decided first, and then every stage scatters its objects on a worker thread, drawing from its own random stream so that stages never affect each other.
+ * Once every stage has finished, the results are added to the world in small batches, a few milliseconds each frame.
+ * Everything that is placed is handed to the area streaming subsystem, which groups it into cells and only loads the cells around the player.
+ */
+UCLASS()
+class OUTPOST_API UOPGenerationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Starts generating an area. Anything generated previously is removed first.
+	@param	NewSettings	Describes how the area is laid out.
+	@param	Seed	The seed that every random choice is derived from. The same settings and seed always produce the same area.
+	@param	Origin	Where the player starts. The area is centered on this location.
+	@return	Was generation started? If the same area has been generated before, it's read back from the cache instead.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPGenerationSubsystem")
+		bool StartGeneration(UOPGenerationSettings* NewSettings, int32 Seed, FVector Origin);
+
+	//Removes everything that was generated from the world.
+	UFUNCTION(BlueprintCallable, Category = "OPGenerationSubsystem")
+		void ClearGeneratedArea();
+
+	//Returns "true" if an area is currently being generated, or added to the world.
+	UFUNCTION(BlueprintPure, Category = "OPGenerationSubsystem")
+		FORCEINLINE bool IsGenerating() const { return bIsGenerating; }
+
+	//Returns "true" if an area has been generated, and everything in it has been added to the world.
+	UFUNCTION(BlueprintPure, Category = "OPGenerationSubsystem")
+		FORCEINLINE bool IsGenerationComplete() const { return bGenerationComplete; }
+
+	//Returns how far along generation is, between 0 and 1.
+	UFUNCTION(BlueprintPure, Category = "OPGenerationSubsystem")
+		float GetProgress() const;
+
+	//Returns the layout of the most recently generated area. Only complete once generation has finished.
+	FORCEINLINE const FOPGeneratedLayout& GetGeneratedLayout() const { return Layout; }
+
+	//Returns the bounds of the area that is being generated, from the lowest to the highest that the ground can be.
+	FBox GetAreaBounds() const;
+
+	//Returns the seed for a single stage of generation, derived from the area's seed.
+	static int32 GetStageSeed(int32 Seed, int32 StageIndex);
+
+	//The most time, in milliseconds, that adding generated objects to the world is allowed to take in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPGenerationSubsystem")
+		float CommitBudgetMs = 2.f;
+
+	//The number of random locations that are tried for each placement, before it's given up on.
+	UPROPERTY(BlueprintReadWrite, Category = "OPGenerationSubsystem")
+		int32 MaxPlacementAttempts = 8;
+
+	/* Stats */
+
+	//How long the worker threads took to decide on every placement, in milliseconds.
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationSubsystem|Stats")
+		float GenerationTimeMs;
+
+	//The number of frames that adding the generated objects to the world was spread across.
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationSubsystem|Stats")
+		int32 CommitFrames;
+
+	//The number of generated objects that have been added to the world.
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationSubsystem|Stats")
+		int32 PlacementsCommitted;
+
+	//Whether the most recent area was read back from the cache, rather than generated.
+	UPROPERTY(BlueprintReadOnly, Category = "OPGenerationSubsystem|Stats")
+		bool bLoadedFromCache;
+
+	/* Delegates */
+
+	//Broadcast at most once per frame while generating, for loading screens.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPGenerationSubsystem|Delegates")
+		FGenerationProgressDelegate OnGenerationProgress;
+
+	//Broadcast once everything that was generated has been added to the world.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPGenerationSubsystem|Delegates")
+		FGenerationDelegate OnGenerationComplete;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPGenerationSettings> Settings;
+
+	UPROPERTY()
+		TObjectPtr<UOPGenerationCacheSubsystem> Cache;
+
+	UPROPERTY()
+		TObjectPtr<UOPAreaStreamingSubsystem> Streaming;
+
+	FOPGenerationParams Params;
+	FOPGeneratedLayout Layout;
+
+	//A hash of everything in the settings that affects the layout, so that cached layouts are thrown away when any of it changes.
+	uint32 SettingsHash;
+
+	UE::Tasks::TTask<FOPGeneratedLayout> LayoutTask;
+
+	//One task for every stage, indexed by stage.
+	TArray<UE::Tasks::TTask<TArray<FOPGeneratedPlacement>>> StageTasks;
+
+	double GenerationStartTime;
+
+	//The index of the next placement that will be added to the world.
+	int32 NextCommitIndex;
+
+	float LastBroadcastProgress;
+
+	bool bIsGenerating;
+	bool bIsCommitting;
+	bool bGenerationComplete;
+
+	//Decides where the player, the outpost and the spawn zones are. Runs on a worker thread.
+	static FOPGeneratedLayout GenerateLayout(const FOPGenerationParams& InParams);
+
+	//Decides where everything in a single stage is placed. Runs on a worker thread.
+	static TArray<FOPGeneratedPlacement> GenerateStage(const FOPGenerationParams& InParams, const FOPGeneratedLayout& InLayout, EGenerationStage Stage);
+
+	//Picks a random location on flat ground, inside of the region that a stage scatters its objects in.
+	static FVector2D SampleStageLocation(FRandomStream& Stream, const FOPGenerationParams& InParams, const FOPGeneratedLayout& InLayout, EGenerationStage Stage);
+
+	//Returns "true" if a location is outside of every area that a stage has to keep clear.
+	static bool IsLocationClear(const FVector2D& Location, const FOPGenerationParams& InParams, const FOPGeneratedLayout& InLayout, EGenerationStage Stage);
+
+	//Gathers the results of every stage, once they have all finished.
+	void OnStagesComplete();
+
+	//Adds as many placements to the world as fit inside of the commit budget.
+	void CommitPlacements();
+
+	//Adds a single placement to the world. Its transform is updated to where it ended up, or its rule is cleared if it couldn't be placed.
+	void CommitPlacement(FOPGeneratedPlacement& Placement);
+
+	//Hands every spawn zone in the layout to the streaming subsystem, once they are on the ground.
+	void AddSpawnZones();
+
+	//Finishes generation, and writes the layout to the cache if it was newly generated.
+	void FinishGeneration();
+
+	uint32 GetSettingsHash() const;
+
+	//Moves a location onto the ground below or above it. Returns "false" if there is no ground.
+	bool SnapToGround(FVector& Location) const;
+
+	void WaitForTasks();
+};
\ No newline at end of file
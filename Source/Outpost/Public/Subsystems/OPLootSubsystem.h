@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPEnums.h"
+#include "OPLootSubsystem.generated.h"
+
+//Forward declarations.
+class AOPLootPickup;
+class AOPWeapon;
+class UOPLootTable;
+class UStaticMesh;
+struct FOPCheckpoint;
+
+//A drop that has been rolled, but not yet placed in the level.
+struct FOPPendingLoot
+{
+	FVector Location;
+
+	//If this is set, the drop is a weapon. Otherwise, it is a pile of reserve ammo.
+	TSubclassOf<AOPWeapon> WeaponClass;
+
+	EWeaponType AmmoType = EWeaponType::NONE;
+	int32 Amount = 0;
+
+	TObjectPtr<UStaticMesh> Mesh;
+};
+
+/**
+ * Places everything that characters drop when they die. Drops are rolled immediately, but only a few are placed each frame,
+ * so that a large multi-kill doesn't spawn a burst of pickups all at once.
+ * The number of pickups in the level is capped: nearby piles of the same ammo are merged together, and the oldest pickup is recycled once the cap is reached.
+ * Every roll and scatter is drawn from a seeded stream, so the same kills always drop the same loot in the same places.
+ */
+UCLASS()
+class OUTPOST_API UOPLootSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Rolls every drop in a loot table, and queues up the ones that succeed.
+	@param	LootTable	The loot table to roll.
+	@param	Location	Where the character died.
+	@param	EquippedWeapon	The class of weapon that the character had equipped, if any.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPLootSubsystem")
+		void DropLoot(const UOPLootTable* LootTable, const FVector& Location, TSubclassOf<AOPWeapon> EquippedWeapon);
+
+	/*
+	Queues up a single weapon drop, regardless of any loot table.
+	@param	WeaponClass	The class of weapon to drop.
+	@param	Location	Where the weapon should be dropped.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPLootSubsystem")
+		void DropWeapon(TSubclassOf<AOPWeapon> WeaponClass, const FVector& Location);
+
+	//Reseeds the stream that every drop is rolled from. Called at the start of every wave.
+	void SetSeed(int32 Seed);
+
+	//Takes a pickup out of play, and returns it to the pool.
+	void ReleasePickup(AOPLootPickup* Pickup);
+
+	//Returns every live pickup to the pool, and throws away every drop that hasn't been placed yet.
+	UFUNCTION(BlueprintCallable, Category = "OPLootSubsystem")
+		void ClearAllLoot();
+
+	//Adds every pickup in the level to a checkpoint. Drops that are still waiting to be placed are added where they were dropped.
+	void WriteToCheckpoint(FOPCheckpoint& Checkpoint) const;
+
+	//Replaces every pickup in the level with the ones in a checkpoint, placed exactly where they were.
+	void ReadFromCheckpoint(const FOPCheckpoint& Checkpoint);
+
+	//Returns the number of pickups that are currently in the level.
+	UFUNCTION(BlueprintPure, Category = "OPLootSubsystem")
+		FORCEINLINE int32 GetLiveLootCount() const { return LivePickups.Num(); }
+
+	//The maximum number of pickups that can be in the level at once. Once this limit is reached, the oldest pickup is recycled for the newest one.
+	UPROPERTY(BlueprintReadWrite, Category = "OPLootSubsystem")
+		int32 MaxLiveLoot = 48;
+
+	//The maximum number of queued drops that are placed in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPLootSubsystem")
+		int32 MaxDropsPerFrame = 4;
+
+	//The maximum number of drops that can be waiting to be placed. Once this limit is reached, the oldest waiting drop is thrown away.
+	UPROPERTY(BlueprintReadWrite, Category = "OPLootSubsystem")
+		int32 MaxPendingDrops = 96;
+
+	//Ammo dropped within this distance of a pile of the same type is added to that pile, instead of becoming a new one.
+	UPROPERTY(BlueprintReadWrite, Category = "OPLootSubsystem")
+		float MergeRadius = 300.f;
+
+	//Drops are scattered randomly within this distance of where the character died, so that they don't all stack on top of each other.
+	UPROPERTY(BlueprintReadWrite, Category = "OPLootSubsystem")
+		float DropScatterRadius = 75.f;
+
+	/* Stats */
+
+	//The number of drops that were merged into an existing pile of ammo.
+	UPROPERTY(BlueprintReadOnly, Category = "OPLootSubsystem|Stats")
+		int32 MergedDrops;
+
+	//The number of live pickups that were recycled, because the cap was reached.
+	UPROPERTY(BlueprintReadOnly, Category = "OPLootSubsystem|Stats")
+		int32 RecycledDrops;
+
+	//The number of waiting drops that were thrown away, because the queue was full.
+	UPROPERTY(BlueprintReadOnly, Category = "OPLootSubsystem|Stats")
+		int32 DiscardedDrops;
+
+protected:
+	//Every pickup that is currently in the level, from oldest to newest.
+	UPROPERTY()
+		TArray<TObjectPtr<AOPLootPickup>> LivePickups;
+
+	//Every pickup that is hidden, and waiting to be reused.
+	UPROPERTY()
+		TArray<TObjectPtr<AOPLootPickup>> DormantPickups;
+
+	TArray<FOPPendingLoot> PendingDrops;
+
+	//Every drop chance, ammo amount and scatter offset is drawn from this.
+	FRandomStream LootStream;
+
+	void QueueDrop(FOPPendingLoot&& Drop);
+
+	//Places a single queued drop in the level.
+	void PlaceDrop(const FOPPendingLoot& Drop);
+
+	//Returns a live pile of the given ammo type within MergeRadius of the location, if there is one.
+	AOPLootPickup* FindMergeablePile(EWeaponType AmmoType, const FVector& Location) const;
+
+	//Returns a pickup that is free to be placed, reusing a dormant one or recycling the oldest live one if needed.
+	AOPLootPickup* GetFreePickup();
+
+	//Moves a location down onto the ground beneath it, if there is any.
+	FVector SnapToGround(const FVector& Location) const;
+};
\ No newline at end of file
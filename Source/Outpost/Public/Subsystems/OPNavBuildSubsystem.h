@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPNavBuildSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FNavBuildProgressDelegate, float, Progress);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FNavBuildDelegate);
+
+//Forward declarations.
+class UOPWorldSubsystem;
+class UNavigationSystemV1;
+
+/**
+ * Controls when and in what order the navmesh is rebuilt, so that it never has to be built all at once.
+ * While an area is being generated, navigation building is held back. Afterwards, the area is handed to the navigation system one tile at a time,
+ * starting with the tiles closest to the player and the outpost, and only a few tiles are ever waiting to be built.
+ * Small changes, such as a barricade being breached, skip the queue, so they are never stuck behind the rest of the area.
+ */
+UCLASS()
+class OUTPOST_API UOPNavBuildSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	//Stops the navmesh from being rebuilt while an area is being generated. Should be followed by BuildArea once generation has finished.
+	void DeferNavigationBuild();
+
+	//Lets navigation be built again, without rebuilding the area. Small changes that were held back are still rebuilt. Used when generation never starts.
+	void EndDeferredBuild();
+
+	/*
+	Rebuilds every navmesh tile inside of an area, a few at a time, nearest to the player and the outpost first.
+	@param	Bounds	The area to rebuild. Usually the whole generated area.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPNavBuildSubsystem")
+		void BuildArea(const FBox& Bounds);
+
+	/*
+	Rebuilds the navmesh tiles under a small change, such as a defense being placed or destroyed, ahead of everything else.
+	@param	Bounds	The bounds of whatever changed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPNavBuildSubsystem")
+		void RebuildDirtyArea(const FBox& Bounds);
+
+	//Returns "true" if an area is still being rebuilt.
+	UFUNCTION(BlueprintPure, Category = "OPNavBuildSubsystem")
+		FORCEINLINE bool IsBuilding() const { return bIsBuilding; }
+
+	//Returns how far along rebuilding the current area is, between 0 and 1.
+	UFUNCTION(BlueprintPure, Category = "OPNavBuildSubsystem")
+		float GetProgress() const;
+
+	//The most tiles that are handed to the navigation system in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPNavBuildSubsystem")
+		int32 MaxTilesPerFrame = 4;
+
+	//The most tiles that are allowed to be waiting in the navigation system at once. Keeping this low means new changes are never stuck behind a long queue.
+	UPROPERTY(BlueprintReadWrite, Category = "OPNavBuildSubsystem")
+		int32 MaxQueuedTiles = 16;
+
+	//The most tiles that the navmesh builds on worker threads at the same time.
+	UPROPERTY(BlueprintReadWrite, Category = "OPNavBuildSubsystem")
+		int32 MaxTileGenerationJobs = 4;
+
+	/* Stats */
+
+	//The number of tiles in the current area.
+	UPROPERTY(BlueprintReadOnly, Category = "OPNavBuildSubsystem|Stats")
+		int32 TotalTiles;
+
+	//The number of tiles in the current area that have been handed to the navigation system.
+	UPROPERTY(BlueprintReadOnly, Category = "OPNavBuildSubsystem|Stats")
+		int32 SubmittedTiles;
+
+	/* Delegates */
+
+	//Broadcast at most once per frame while an area is being rebuilt, for loading screens.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPNavBuildSubsystem|Delegates")
+		FNavBuildProgressDelegate OnNavBuildProgress;
+
+	//Broadcast once every tile in the area has been rebuilt.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPNavBuildSubsystem|Delegates")
+		FNavBuildDelegate OnNavBuildComplete;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPWorldSubsystem> WorldSubsystem;
+
+	//The bounds of every tile that is still waiting to be handed to the navigation system, sorted so that the nearest tile is last.
+	TArray<FBox> PendingTiles;
+
+	//Small changes that were made while navigation building was held back.
+	TArray<FBox> DeferredDirtyAreas;
+
+	//Where the player was when the pending tiles were last sorted.
+	FVector LastSortLocation;
+
+	//The number of frames in a row that the navigation system has had nothing left to build.
+	int32 IdleFrames;
+
+	float LastBroadcastProgress;
+
+	bool bIsBuildDeferred;
+	bool bIsBuilding;
+
+	UNavigationSystemV1* GetNavigationSystem() const;
+
+	//Returns the location of the player's pawn, or the outpost if there is no pawn.
+	FVector GetPlayerLocation() const;
+
+	//Sorts the pending tiles by their distance to the player or the outpost, whichever is closer.
+	void SortPendingTiles();
+
+	void FinishBuild();
+};
\ No newline at end of file
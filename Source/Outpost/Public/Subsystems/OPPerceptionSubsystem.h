@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPPerceptionSubsystem.generated.h"
+
+//Forward declarations.
+class UOPTraceBatchSubsystem;
+
+//What a single enemy currently knows about the player.
+struct FOPVisibilityEntry
+{
+	//Where the player was, the last time that this enemy saw them.
+	FVector LastKnownPlayerLocation = FVector::ZeroVector;
+
+	//When this enemy last saw the player, or a negative value if they never have.
+	float LastSeenTime = -1.f;
+
+	bool bCanSeePlayer = false;
+};
+
+/**
+ * Runs every enemy's line of sight check against the player as part of a single trace batch each frame, instead of each enemy tracing on its own.
+ * Checks are handed out round-robin under a fixed budget, with more significant enemies checked more often.
+ * Results are written into a visibility table that the AI can read at any time, without tracing.
+ */
+UCLASS()
+class OUTPOST_API UOPPerceptionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	//Returns "true" if the enemy could see the player, as of its most recent line of sight check.
+	UFUNCTION(BlueprintPure, Category = "OPPerceptionSubsystem")
+		bool CanSeePlayer(const AActor* Enemy) const;
+
+	/*
+	Returns where an enemy last saw the player.
+	@param	Enemy	The enemy that is being asked.
+	@param	OutLocation	Where the player was, the last time the enemy saw them.
+	@param	OutTimeSinceSeen	How many seconds ago that was.
+	@return	"true" if the enemy has ever seen the player.
+	*/
+	UFUNCTION(BlueprintPure, Category = "OPPerceptionSubsystem")
+		bool GetLastKnownPlayerLocation(const AActor* Enemy, FVector& OutLocation, float& OutTimeSinceSeen) const;
+
+	/*
+	Tells an enemy where it last saw the player. Used when restoring a checkpoint, so that enemies remember what they knew.
+	@param	Enemy	The enemy to update. Must already be in play.
+	@param	Location	Where the player was, the last time the enemy saw them.
+	@param	TimeSinceSeen	How many seconds ago that was.
+	*/
+	void RestoreLastKnownPlayerLocation(const AActor* Enemy, const FVector& Location, float TimeSinceSeen);
+
+	//The maximum number of line of sight checks that can be sent out in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPPerceptionSubsystem")
+		int32 MaxChecksPerFrame = 24;
+
+	//Enemies can't see the player if they're further away than this.
+	UPROPERTY(BlueprintReadWrite, Category = "OPPerceptionSubsystem")
+		float SightRadius = 8000.f;
+
+	//Enemies can't see the player if they're further than this angle, in degrees, from where the enemy is facing.
+	UPROPERTY(BlueprintReadWrite, Category = "OPPerceptionSubsystem")
+		float SightHalfAngle = 70.f;
+
+	//Enemies closer than this are always checked as often as possible, no matter what other enemies need checking.
+	UPROPERTY(BlueprintReadWrite, Category = "OPPerceptionSubsystem")
+		float HighSignificanceRadius = 1500.f;
+
+	//The number of line of sight checks that were sent out last frame.
+	UPROPERTY(BlueprintReadOnly, Category = "OPPerceptionSubsystem|Stats")
+		int32 ChecksLastFrame;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPTraceBatchSubsystem> TraceBatchSubsystem;
+
+	void OnEnemyRegistered(AActor* Enemy);
+	void OnEnemyUnregistered(AActor* Enemy);
+	void OnSightTraceComplete(const FHitResult& HitResult, bool bBlockingHit, TWeakObjectPtr<AActor> Enemy, FVector PlayerLocation);
+
+	void UpdateVisibility(int32 AgentIndex, bool bCanSeePlayer, const FVector& PlayerLocation);
+
+	//Removes an enemy from the arrays below, by swapping the last enemy into its place.
+	void RemoveAgent(int32 AgentIndex);
+
+	//Forgets whichever enemy is at an index. Used for enemies that were destroyed without being unregistered, which can't be looked up by key.
+	void RemoveAgentIndexEntry(int32 AgentIndex);
+
+	//Every enemy that is being checked, along with how overdue its next check is, and what it currently knows.
+	TArray<TWeakObjectPtr<AActor>> Agents;
+	TArray<float> CheckPriorities;
+	TArray<FOPVisibilityEntry> VisibilityTable;
+
+	//Where each enemy is in the arrays above.
+	TMap<TObjectKey<AActor>, int32> AgentIndices;
+
+	//The significance of enemies within the high significance radius, and of enemies that have never been checked.
+	static constexpr float MaxSignificance = 1000.f;
+};
\ No newline at end of file
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Subsystems/OPSaveSubsystem.h"
+#include "Data/OPReplay.h"
+#include "OPReplaySubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FReplayFinishedDelegate, int32, FrameCount);
+
+//Forward declarations.
+class AOPPlayer;
+class UEnhancedInputComponent;
+struct FInputActionInstance;
+
+/**
+ * Records every input action that reaches the player's handlers, so that a run can be played back exactly, frame for frame, to compare performance between builds.
+ * A recording starts once the area is ready and the first wave is being prepared, since everything before that takes a different number of frames on every machine.
+ * It keeps the seed that the area was generated from, the seed that the global random number generator was reset to, and how long every frame took.
+ * Replays run at a fixed timestep from those frame times, with the player's own input ignored, and can skip rendering the world entirely.
+ */
+UCLASS()
+class OUTPOST_API UOPReplaySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Prepares to record the run. Nothing is recorded until StartSession() is called, and the player's input is held back until then.
+	@param	SlotName	The save slot that the recording is written to, once it's stopped.
+	@return	Was recording prepared? Nothing can be recorded while a replay is loaded.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPReplaySubsystem")
+		bool StartRecording(const FString& SlotName);
+
+	//Stops recording, and writes the recording in the background. Called automatically when the level closes.
+	UFUNCTION(BlueprintCallable, Category = "OPReplaySubsystem")
+		bool StopRecording();
+
+	/*
+	Starts reading a replay in the background. OnReplayLoaded is broadcast once it has been read, and the replay starts playing once StartSession() is called.
+	The player's input is held back from now on, until the replay has finished.
+	@param	SlotName	The save slot to read the replay from.
+	@return	Was reading started?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPReplaySubsystem")
+		bool LoadReplay(const FString& SlotName);
+
+	//Starts recording or playing back, if either was prepared. Should be called by the game mode once the area is ready.
+	void StartSession();
+
+	//Records the seed that the area was generated from, if the run is being recorded.
+	void SetSeed(int32 NewSeed);
+
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE bool IsRecording() const { return bIsRecording; }
+
+	//Returns "true" if a replay has been loaded, whether or not it has started playing yet.
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE bool HasReplay() const { return bHasReplay; }
+
+	//Returns "true" if a replay is currently playing.
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE bool IsReplaying() const { return bHasReplay && bIsSessionRunning; }
+
+	//Returns "true" if a replay is being loaded.
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE bool IsLoadingReplay() const { return bIsLoadingReplay; }
+
+	//Returns the seed that the loaded replay's area was generated from, or 0 if there isn't one.
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE int32 GetReplaySeed() const { return bHasReplay ? Replay.Seed : 0; }
+
+	//Returns the number of frames that have been recorded or played back so far.
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE int32 GetCurrentFrame() const { return CurrentFrame; }
+
+	//Returns the number of frames in the loaded replay.
+	UFUNCTION(BlueprintPure, Category = "OPReplaySubsystem")
+		FORCEINLINE int32 GetReplayFrameCount() const { return bHasReplay ? Replay.GetFrameCount() : 0; }
+
+	//If "false", the world isn't rendered while a replay plays, so that only the game thread's work is measured.
+	UPROPERTY(BlueprintReadWrite, Category = "OPReplaySubsystem")
+		bool bRenderReplay = true;
+
+	/* Stats */
+
+	//The number of events in the most recent recording, or in the loaded replay.
+	UPROPERTY(BlueprintReadOnly, Category = "OPReplaySubsystem|Stats")
+		int32 EventCount;
+
+	//The size of the most recent recording that was written, in bytes, before it was compressed.
+	UPROPERTY(BlueprintReadOnly, Category = "OPReplaySubsystem|Stats")
+		int32 LastRecordingSize;
+
+	/* Delegates */
+
+	//Broadcast on the game thread once a replay has been read from a save slot.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPReplaySubsystem|Delegates")
+		FSaveGameDelegate OnReplayLoaded;
+
+	//Broadcast once every frame of a replay has been played back.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPReplaySubsystem|Delegates")
+		FReplayFinishedDelegate OnReplayFinished;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<AOPPlayer> Player;
+
+	//The recording that is being made, or the replay that is being played back.
+	FOPReplay Replay;
+
+	FString RecordingSlotName;
+
+	//The handle of every binding that was added to the player's input component to record it, so that they can be removed again.
+	TArray<uint32> RecordingBindings;
+
+	int32 CurrentFrame;
+
+	//The next event in the replay that hasn't been played back yet.
+	int32 NextEventIndex;
+
+	bool bIsRecording;
+	bool bHasReplay;
+	bool bIsLoadingReplay;
+	bool bIsSessionRunning;
+
+	//The engine's timestep settings from before the replay started, so that they can be put back once it finishes.
+	double PreviousFixedDeltaTime;
+	bool bWasUsingFixedTimeStep;
+
+	UOPSaveSubsystem* GetSaveSubsystem() const;
+
+	UEnhancedInputComponent* GetPlayerInput() const;
+
+	//Stops the player's own input from reaching them, or lets it through again.
+	void SetPlayerInputHeld(bool bHeld);
+
+	//Records an event, as it reaches the player's handlers.
+	void RecordEvent(const FInputActionInstance& Instance);
+
+	//Sends every event that was recorded on a given frame to the player's handlers, and sets up the engine to run that frame with its recorded frame time.
+	void PlayFrame(int32 Frame);
+
+	//Stops playing back, and puts the engine's timestep and rendering back to how they were.
+	void FinishReplay();
+
+	/*
+	Unpacks a replay that was read and decompressed in the background.
+	@param	Bytes	The replay, without its header. Empty if it couldn't be read.
+	@param	Version	The version of the format that the replay was written in.
+	*/
+	void OnReplayRead(const TArray<uint8>& Bytes, int32 Version, FString SlotName);
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "OPSaveSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FSaveGameDelegate, const FString&, SlotName, bool, bSuccess);
+DECLARE_DELEGATE_TwoParams(FOPSlotReadDelegate, const TArray<uint8>& /*Bytes*/, int32 /*Version*/);
+
+//Forward declarations.
+class UOPSaveGame;
+
+//A save game that has been packed on the game thread, waiting to be compressed and written.
+struct FOPPendingSave
+{
+	FString SlotName;
+
+	//Written in the slot's header, so that a slot is only ever read back as the kind of data that was written to it.
+	uint32 Magic = 0;
+	int32 Version = 0;
+
+	TArray<uint8> Bytes;
+};
+
+//What has been written to a save slot since its last full save.
+struct FOPSaveJournal
+{
+	//The ID of the full save that every delta in the journal belongs to.
+	FGuid BaseId;
+
+	int32 DeltaCount = 0;
+
+	//The size of the full save and of every delta after it, in bytes, before they were compressed.
+	int32 BaseSize = 0;
+	int32 JournalSize = 0;
+
+	//The length of the transaction log when the last save was made. The next delta only holds the transactions after it.
+	int32 TransactionCount = 0;
+
+	//The world that the journal was written from. Deltas only hold what changed in this world, so a different world always starts a new full save.
+	TWeakObjectPtr<UWorld> World;
+};
+
+/**
+ * Saves and loads the player's run. Lives on the game instance, so that a save that was loaded from the menu is still there once the level has opened.
+ * The game's state is packed into a small binary archive on the game thread, and then compressed and written to disk on a background thread.
+ * Loading works the other way around: the file is read and decompressed in the background, and only unpacked on the game thread.
+ * Every save starts with the version of the format it was written in, so that saves from older versions of the game keep loading.
+ * Most saves are small deltas that only hold what changed since the save before them, written to their own slots next to the last full save.
+ * Once the deltas grow too many or too large, the next save is a full one again, and the deltas before it are ignored from then on.
+ */
+UCLASS()
+class OUTPOST_API UOPSaveSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	/*
+	Saves the current state of the game. Only packing it happens right away; it's compressed and written in the background.
+	If the slot was saved to earlier in this world, only what changed since then is written.
+	@param	SlotName	The name of the save slot to write to.
+	@return	Was there a game to save? If a save is already being written, this one is written as soon as it finishes.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPSaveSubsystem")
+		bool SaveGame(const FString& SlotName);
+
+	/*
+	Starts loading a save game in the background, along with every delta that was written after it. OnLoadComplete is broadcast once they have all been read.
+	@param	SlotName	The name of the save slot to read from.
+	@return	Was loading started?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPSaveSubsystem")
+		bool LoadGame(const FString& SlotName);
+
+	UFUNCTION(BlueprintPure, Category = "OPSaveSubsystem")
+		bool DoesSaveExist(const FString& SlotName) const;
+
+	/*
+	Compresses and writes data that has already been packed to a save slot, in the background. Used for everything that is written to disk, not just save games.
+	Only one slot is written at a time. If a write is already running, this one is written as soon as it finishes.
+	@param	Save	The packed data, along with the slot, magic number and version to write it with.
+	*/
+	void WriteSlot(FOPPendingSave&& Save);
+
+	/*
+	Reads and decompresses a save slot in the background.
+	@param	SlotName	The name of the save slot to read from.
+	@param	Magic	The magic number that the slot must have been written with.
+	@param	MaxVersion	The newest version of the format that the caller understands. Slots written with a newer version are rejected.
+	@param	OnRead	Called on the game thread with the decompressed data and its version. The data is empty if the slot couldn't be read.
+	@return	Was reading started? Only one slot is read at a time.
+	*/
+	bool ReadSlot(const FString& SlotName, uint32 Magic, int32 MaxVersion, FOPSlotReadDelegate OnRead);
+
+	/*
+	Collects everything about the player and their progress from the current world.
+	@param	FirstTransaction	The first transaction to include. Earlier transactions are left out, for deltas.
+	@return	The save game, or nothing if there is no game in progress.
+	*/
+	UOPSaveGame* CaptureGameState(int32 FirstTransaction = 0);
+
+	//Returns the save game that was loaded most recently, if it hasn't been applied yet.
+	UFUNCTION(BlueprintPure, Category = "OPSaveSubsystem")
+		FORCEINLINE UOPSaveGame* GetLoadedSave() const { return LoadedSave; }
+
+	//Forgets about the loaded save game. Should be called once it has been applied, so that it isn't applied again.
+	UFUNCTION(BlueprintCallable, Category = "OPSaveSubsystem")
+		void ClearLoadedSave();
+
+	UFUNCTION(BlueprintPure, Category = "OPSaveSubsystem")
+		FORCEINLINE bool IsSaving() const { return bIsWriting; }
+
+	//The index of the local user that save games are written for.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSaveSubsystem")
+		int32 UserIndex;
+
+	/* Journal */
+
+	//The most deltas that are written after a full save, before the next save is a full one again. If 0, every save is a full save.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSaveSubsystem|Journal")
+		int32 MaxJournalDeltas = 8;
+
+	//Once the deltas after a full save add up to more than this fraction of its size, the next save is a full one again.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSaveSubsystem|Journal")
+		float MaxJournalFraction = 0.5f;
+
+	/* Stats */
+
+	//The size of the most recent save, in bytes, before it was compressed.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveSubsystem|Stats")
+		int32 LastSaveSize;
+
+	//The size of the most recent save, in bytes, as it was written to disk.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveSubsystem|Stats")
+		int32 LastCompressedSize;
+
+	//How long compressing and writing the most recent save took on the background thread, in milliseconds.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveSubsystem|Stats")
+		float LastWriteTimeMs;
+
+	//Whether the most recent save was a delta, rather than a full save.
+	UPROPERTY(BlueprintReadOnly, Category = "OPSaveSubsystem|Stats")
+		bool bLastSaveWasDelta;
+
+	/* Delegates */
+
+	//Broadcast on the game thread once a save slot has been written, whether it held a save game or anything else.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPSaveSubsystem|Delegates")
+		FSaveGameDelegate OnSaveComplete;
+
+	//Broadcast on the game thread once a save game has been read. If it succeeded, the save game can be found with GetLoadedSave.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPSaveSubsystem|Delegates")
+		FSaveGameDelegate OnLoadComplete;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPSaveGame> LoadedSave;
+
+	//The full save that is being loaded, with every delta that has been read so far applied to it.
+	UPROPERTY()
+		TObjectPtr<UOPSaveGame> PendingLoad;
+
+	//The journal of every slot that has been saved to or loaded from, by slot name.
+	TMap<FString, FOPSaveJournal> Journals;
+
+	//The journal of the save game that is being loaded, until every delta has been read.
+	FOPSaveJournal PendingJournal;
+
+	//The slot that LoadedSave was read from.
+	FString LoadedSlotName;
+
+	//The write and read that are running in the background, if any. They are waited for before the game instance goes away.
+	TFuture<void> WriteTask;
+	TFuture<void> ReadTask;
+
+	//Every save that was made while another was being written. Only the latest one for each slot is kept, since it replaces the others anyway.
+	TArray<FOPPendingSave> QueuedSaves;
+
+	bool bIsWriting;
+	bool bIsReading;
+
+	//Compresses and writes a packed save game on a background thread.
+	void StartWrite(FOPPendingSave&& Save);
+
+	void OnWriteComplete(const FString& SlotName, bool bSuccess, int32 CompressedSize, float WriteTimeMs);
+
+	//Returns the name of the slot that a delta is written to.
+	static FString GetDeltaSlotName(const FString& SlotName, int32 DeltaIndex);
+
+	/*
+	Unpacks a save game that was read and decompressed in the background, and starts reading the delta after it.
+	@param	Bytes	The save game, without its header. Empty if it couldn't be read.
+	@param	Version	The version of the format that the save game was written in.
+	@param	DeltaIndex	0 for the full save, or the position of the delta in the journal.
+	*/
+	void OnSaveGameRead(const TArray<uint8>& Bytes, int32 Version, FString SlotName, int32 DeltaIndex);
+
+	//Makes the full save that is being loaded available, with every delta that could be applied to it.
+	void FinishLoad(const FString& SlotName);
+};
\ No newline at end of file
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPShopSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FShopPurchaseDelegate, int32, ItemIndex, bool, bWasResident);
+
+//Forward declarations.
+class UOPShopCatalog;
+class UOPEconomySubsystem;
+struct FShopItem;
+struct FStreamableHandle;
+
+//An item that was bought before it finished loading.
+struct FOPPendingDelivery
+{
+	int32 ItemIndex = INDEX_NONE;
+
+	//The amount of cash that was paid for the item, which is refunded if it's never delivered.
+	int32 Price = 0;
+
+	//The character that the item will be given to, once it has loaded.
+	TWeakObjectPtr<AActor> Buyer;
+
+	TSharedPtr<FStreamableHandle> Handle;
+};
+
+/**
+ * The backend for the shop. Items are loaded in the background as soon as the player hovers them,
+ * so that by the time they are bought, everything they need is already in memory and spawning them never hitches.
+ * Items that are bought before they finish loading are still paid for right away, and delivered once their load completes.
+ * If a purchase can never be delivered, its cash is refunded.
+ */
+UCLASS()
+class OUTPOST_API UOPShopSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//Sets the catalog that the shop sells from, and releases everything that was preloaded from the previous one.
+	UFUNCTION(BlueprintCallable, Category = "OPShopSubsystem")
+		void SetCatalog(UOPShopCatalog* NewCatalog);
+
+	UFUNCTION(BlueprintPure, Category = "OPShopSubsystem")
+		FORCEINLINE UOPShopCatalog* GetCatalog() const { return Catalog; }
+
+	/*
+	Starts loading an item's assets in the background. Should be called when the item is hovered in the shop.
+	@param	ItemIndex	The index of the item in the catalog.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPShopSubsystem")
+		void PreloadItem(int32 ItemIndex);
+
+	/*
+	Buys an item, and gives it to the buyer.
+	@param	ItemIndex	The index of the item in the catalog.
+	@param	Buyer	The character that receives the item.
+	@return	Was the item paid for?
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPShopSubsystem")
+		bool PurchaseItem(int32 ItemIndex, AActor* Buyer);
+
+	//Returns "true" if every asset an item needs is already in memory.
+	UFUNCTION(BlueprintPure, Category = "OPShopSubsystem")
+		bool IsItemResident(int32 ItemIndex) const;
+
+	//The maximum number of items that are kept preloaded at once. Once this limit is reached, the item that was hovered longest ago is released.
+	UPROPERTY(BlueprintReadWrite, Category = "OPShopSubsystem")
+		int32 MaxPreloadedItems = 6;
+
+	/* Stats */
+
+	//The number of purchases whose assets were already in memory.
+	UPROPERTY(BlueprintReadOnly, Category = "OPShopSubsystem|Stats")
+		int32 PreloadHits;
+
+	//The number of purchases that had to wait for their assets to load.
+	UPROPERTY(BlueprintReadOnly, Category = "OPShopSubsystem|Stats")
+		int32 PreloadMisses;
+
+	//The number of preloads that were started.
+	UPROPERTY(BlueprintReadOnly, Category = "OPShopSubsystem|Stats")
+		int32 PreloadsStarted;
+
+	//The number of preloaded items that were released, to make room for more recently hovered ones.
+	UPROPERTY(BlueprintReadOnly, Category = "OPShopSubsystem|Stats")
+		int32 PreloadsEvicted;
+
+	/* Delegates */
+
+	//Broadcast when a purchased item has been given to its buyer.
+	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPShopSubsystem|Delegates")
+		FShopPurchaseDelegate OnPurchaseDelivered;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPShopCatalog> Catalog;
+
+	UPROPERTY()
+		TObjectPtr<UOPEconomySubsystem> Economy;
+
+	//The handle for every item that is currently preloaded, which keeps its assets in memory.
+	TMap<int32, TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	//The index of every preloaded item, from the one hovered longest ago to the most recent.
+	TArray<int32> PreloadOrder;
+
+	//Every item that was bought before it finished loading, by delivery ID.
+	TMap<int32, FOPPendingDelivery> PendingDeliveries;
+
+	int32 NextDeliveryId;
+
+	const FShopItem* GetItem(int32 ItemIndex) const;
+
+	//Collects the path of every asset that an item needs.
+	void GetItemAssets(const FShopItem& Item, TArray<FSoftObjectPath>& OutAssets) const;
+
+	//Releases every preloaded item, and cancels every pending delivery, refunding it.
+	void ReleaseAllHandles();
+
+	void OnPendingDeliveryLoaded(int32 DeliveryId);
+
+	/*
+	Spawns a purchased item, and gives it to the buyer. Every asset that the item needs must already be in memory.
+	@return	Was the item given to the buyer?
+	*/
+	bool DeliverItem(int32 ItemIndex, AActor* Buyer, bool bWasResident);
+};
\ No newline at end of file
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPSpawnQuerySubsystem.generated.h"
+
+/*
+Called once a spawn placement query has finished.
+@param	Placements	The best spawn locations that were found, ordered from best to worst.
+*/
+DECLARE_DELEGATE_OneParam(FOPSpawnPlacementsDelegate, const TArray<FVector>&);
+
+//Forward declarations.
+class UOPTraceBatchSubsystem;
+
+//A location that is being considered for spawning enemy reinforcements.
+struct FOPSpawnCandidate
+{
+	FVector Location;
+	float Score;
+};
+
+//A spawn placement query that is still being worked on.
+struct FOPSpawnQuery
+{
+	int32 WaveIndex;
+	int32 NumPlacements;
+	FOPSpawnPlacementsDelegate Callback;
+
+	//Every candidate that passed the cheap tests, waiting to be projected onto the navmesh.
+	TArray<FOPSpawnCandidate> Candidates;
+	int32 NextCandidateIndex;
+
+	//Every candidate that has been checked for visibility. Candidates the player can see are heavily penalized.
+	TArray<FOPSpawnCandidate> CheckedCandidates;
+
+	FVector ViewLocation;
+	int32 PendingTraceCount;
+};
+
+/**
+ * Finds spawn locations for enemy reinforcements that are on the navmesh, out of the player's sight, and far enough away from the outpost.
+ * Cheap tests are run first, and only the survivors are checked for visibility, using batched asynchronous traces.
+ */
+UCLASS()
+class OUTPOST_API UOPSpawnQuerySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Sets the area that spawn candidates are generated within. Usually the bounds of the procedurally-generated area.
+	Clears any cached placements, since they may no longer be inside the area.
+	@param	NewSpawnArea	The area that enemies are allowed to spawn in.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPSpawnQuerySubsystem")
+		void SetSpawnArea(const FBox& NewSpawnArea);
+
+	//Returns "true" if a spawn area has been set.
+	UFUNCTION(BlueprintPure, Category = "OPSpawnQuerySubsystem")
+		FORCEINLINE bool HasSpawnArea() { return SpawnArea.IsValid != 0; }
+
+	//Returns the area that spawn candidates are generated within.
+	UFUNCTION(BlueprintPure, Category = "OPSpawnQuerySubsystem")
+		FORCEINLINE FBox GetSpawnArea() { return SpawnArea; }
+
+	/*
+	Finds the best spawn locations for a wave. Results are cached per wave, so repeated requests for the same wave return immediately.
+	@param	WaveIndex	The wave that the placements are for.
+	@param	NumPlacements	The maximum number of spawn locations that should be returned.
+	@param	Callback	Called once the placements are ready, usually within a frame or two.
+	*/
+	void RequestPlacements(int32 WaveIndex, int32 NumPlacements, FOPSpawnPlacementsDelegate Callback);
+
+	//Forgets every cached placement, so that the next request for each wave is recalculated.
+	UFUNCTION(BlueprintCallable, Category = "OPSpawnQuerySubsystem")
+		void ClearCachedPlacements();
+
+	//The distance between each spawn candidate, along both axes of the spawn area.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Candidates")
+		float CandidateSpacing = 1000.f;
+
+	//The maximum number of spawn candidates that are generated for a single query.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Candidates")
+		int32 MaxCandidates = 2048;
+
+	//The maximum number of spawn candidates that are projected onto the navmesh in a single frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Candidates")
+		int32 MaxNavProjectionsPerFrame = 256;
+
+	//The size of each cell in the occupancy grid. Only one spawn location is allowed per cell, so that placements stay spread out.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Filters")
+		float OccupancyCellSize = 1500.f;
+
+	//The closest that enemies are allowed to spawn to the outpost.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Filters")
+		float MinOutpostDistance = 5000.f;
+
+	//The closest that enemies are allowed to spawn to the player.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Filters")
+		float MinPlayerDistance = 3000.f;
+
+	//The distance from the outpost that is preferred for spawning, when scoring candidates.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Scoring")
+		float PreferredOutpostDistance = 8000.f;
+
+	//How high above the ground the player's line of sight is checked against, at each candidate.
+	UPROPERTY(BlueprintReadWrite, Category = "OPSpawnQuerySubsystem|Filters")
+		float CandidateEyeHeight = 150.f;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPTraceBatchSubsystem> TraceBatchSubsystem;
+
+	void StartQuery(FOPSpawnQuery& Query);
+	void ProjectCandidatesToNavmesh(int32 QueryId, FOPSpawnQuery& Query);
+	void OnVisibilityTraceComplete(const FHitResult& HitResult, bool bBlockingHit, int32 QueryId, FOPSpawnCandidate Candidate);
+	void FinishQuery(int32 QueryId);
+
+	//Every query that is still being worked on, by ID.
+	TMap<int32, FOPSpawnQuery> ActiveQueries;
+
+	//The best spawn locations that have been found for each wave.
+	TMap<int32, TArray<FVector>> CachedPlacements;
+
+	FBox SpawnArea = FBox(ForceInit);
+
+	int32 NextQueryId;
+};
\ No newline at end of file
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPTraceBatchSubsystem.generated.h"
+
+/*
+Called once a batched line trace has finished.
+@param	HitResult	The first blocking hit, or an empty hit result if nothing was hit.
+@param	bBlockingHit	Did the trace hit anything?
+*/
+DECLARE_DELEGATE_TwoParams(FOPTraceBatchDelegate, const FHitResult&, bool);
+
+//A line trace that is waiting to be sent out with the next batch.
+struct FOPQueuedTrace
+{
+	FVector Start;
+	FVector End;
+	ECollisionChannel Channel;
+	FCollisionQueryParams Params;
+	FOPTraceBatchDelegate Callback;
+};
+
+//A line trace that has been sent out, and is waiting on its results.
+struct FOPInFlightTrace
+{
+	FTraceHandle Handle;
+
+	//The trace itself is kept, so that it can be run again on the spot if its results are lost.
+	FOPQueuedTrace Trace;
+};
+
+/**
+ * Collects line traces from every system that needs them, and sends them out as a single asynchronous batch each frame.
+ * Results are delivered on the game thread one frame later.
+ */
+UCLASS()
+class OUTPOST_API UOPTraceBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	/*
+	Queues up a line trace, to be sent out with the next batch.
+	@param	Start	The location where the line trace starts.
+	@param	End	The location where the line trace ends.
+	@param	Channel	The collision channel that the line trace uses.
+	@param	Params	The query parameters for the line trace, such as which actors it ignores.
+	@param	Callback	Called on the game thread, once the line trace's results are available.
+	*/
+	void QueueLineTrace(const FVector& Start, const FVector& End, ECollisionChannel Channel, const FCollisionQueryParams& Params, FOPTraceBatchDelegate Callback);
+
+	//Returns the number of line traces that are still waiting to be sent out.
+	UFUNCTION(BlueprintPure, Category = "OPTraceBatchSubsystem")
+		FORCEINLINE int32 GetQueuedTraceCount() { return QueuedTraces.Num(); }
+
+	//The maximum number of line traces that can be sent out in a single frame. Anything over this waits for the next frame.
+	UPROPERTY(BlueprintReadWrite, Category = "OPTraceBatchSubsystem")
+		int32 MaxTracesPerFrame = 512;
+
+	//The number of line traces that were sent out last frame.
+	UPROPERTY(BlueprintReadOnly, Category = "OPTraceBatchSubsystem|Stats")
+		int32 TracesIssuedLastFrame;
+
+	//The number of line traces that have been sent out since the level started.
+	UPROPERTY(BlueprintReadOnly, Category = "OPTraceBatchSubsystem|Stats")
+		int64 TotalTracesIssued;
+
+protected:
+	void ResolveInFlightTraces();
+	void IssueQueuedTraces();
+
+	TArray<FOPQueuedTrace> QueuedTraces;
+	TArray<FOPInFlightTrace> InFlightTraces;
+
+	//The index of the first queued trace that hasn't been sent out yet.
+	int32 NextQueuedTraceIndex;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "OPTurretSubsystem.generated.h"
+
+//Forward declarations.
+class AOPTurret;
+class UOPEnemyGridSubsystem;
+class UOPTraceBatchSubsystem;
+
+/**
+ * Aims and fires every turret in the level, in a single batched pass each frame.
+ * Each ready turret gathers nearby enemies from the enemy grid, and picks the closest one inside of its range and arc with one flat loop over packed arrays.
+ * Line of sight to the chosen enemy is checked through the trace batch, and the turret fires once the result comes back.
+ */
+UCLASS()
+class OUTPOST_API UOPTurretSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem implementation Begin
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject implementation Begin
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	//Adds a turret to the batch. Turrets call this themselves when they enter play.
+	void RegisterTurret(AOPTurret* Turret);
+
+	//Removes a turret from the batch. Turrets call this themselves when they leave play.
+	void UnregisterTurret(AOPTurret* Turret);
+
+	//Returns the number of turrets in the level.
+	UFUNCTION(BlueprintPure, Category = "OPTurretSubsystem")
+		FORCEINLINE int32 GetTurretCount() const { return Turrets.Num(); }
+
+	//How long a turret waits before looking for a new target, after its line of sight to the last one was blocked.
+	UPROPERTY(BlueprintReadWrite, Category = "OPTurretSubsystem")
+		float RetargetDelay = 0.25f;
+
+	/* Stats */
+
+	//The number of enemies whose range and angle were tested last frame, across every turret.
+	UPROPERTY(BlueprintReadOnly, Category = "OPTurretSubsystem|Stats")
+		int32 CandidatesTestedLastFrame;
+
+	//The number of line of sight checks that were queued last frame.
+	UPROPERTY(BlueprintReadOnly, Category = "OPTurretSubsystem|Stats")
+		int32 SightChecksLastFrame;
+
+protected:
+	UPROPERTY()
+		TObjectPtr<UOPEnemyGridSubsystem> EnemyGrid;
+
+	UPROPERTY()
+		TObjectPtr<UOPTraceBatchSubsystem> TraceBatch;
+
+	/* Turret data. Every array is indexed by each turret's TurretIndex. */
+
+	UPROPERTY()
+		TArray<TObjectPtr<AOPTurret>> Turrets;
+
+	//Where each turret's head turns around. Turrets never move once they are placed, so this is only read once.
+	TArray<FVector> Pivots;
+
+	//The direction that each turret was placed facing, flattened onto the ground.
+	TArray<FVector2D> Facings;
+
+	TArray<float> Ranges;
+
+	//The cosine of each turret's arc. An enemy is inside of the arc if its direction lines up with the facing at least this well.
+	TArray<float> MinAlignments;
+
+	//The time at which each turret is next allowed to look for a target.
+	TArray<float> NextFireTimes;
+
+	//Whether each turret is waiting on a line of sight check.
+	TArray<bool> AwaitingSight;
+
+	/* Scratch space, reused by every turret each frame so that targeting doesn't allocate. */
+
+	TArray<AActor*> Candidates;
+	TArray<float> CandidateX;
+	TArray<float> CandidateY;
+	TArray<float> CandidateZ;
+	TArray<float> CandidateScores;
+
+	//Returns the closest enemy inside of a turret's range and arc, or nothing if there isn't one.
+	AActor* FindTarget(int32 TurretIndex);
+
+	/*
+	Fires a turret at its target, if it still has line of sight.
+	@param	Turret	The turret that requested the line of sight check.
+	@param	Target	The enemy that the turret is trying to shoot.
+	*/
+	void OnSightTraceComplete(const FHitResult& HitResult, bool bBlockingHit, TWeakObjectPtr<AOPTurret> Turret, TWeakObjectPtr<AActor> Target);
+
+	//Returns the location a turret should aim at, on a given enemy.
+	FVector GetAimLocation(const AOPTurret* Turret, const AActor* Target) const;
+
+	//Returns "true" if a target is still alive and in play.
+	bool IsTargetValid(const AActor* Target) const;
+};
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FInfiniteAmmoWithReloadDelegate, EWeaponType, CurrentWeaponType);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FEnemyDelegate);
+DECLARE_MULTICAST_DELEGATE_OneParam(FEnemyRegistryDelegate, AActor*);
+DECLARE_MULTICAST_DELEGATE_OneParam(FInteractableRegistryDelegate, AActor*);
 
 /**
  * 
@@ -53,6 +55,17 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = "OPWorldSubsystem|Debug Options|Cheat Codes")
 		bool bInfiniteAmmoWithReloadEnabled;
 
+	/*
+	Starts or stops profiling the game's hot paths. While on, they are recorded in the "Outpost" stats group (shown with "stat Outpost"),
+	and on the "Outpost" trace channel for Unreal Insights. Does nothing in shipping builds.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPWorldSubsystem|Debug Options|Profiling")
+		void SetProfilingEnabled(bool bEnabled);
+
+	//Returns "true" if the game's hot paths are currently being profiled.
+	UFUNCTION(BlueprintPure, Category = "OPWorldSubsystem|Debug Options|Profiling")
+		bool IsProfilingEnabled() const;
+
 	/* Toggle/hold inputs */
 
 	//Determines if the mouse and keyboard input for sprinting is a "toggle" or a "hold".
@@ -71,12 +84,62 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = "OPWorldSubsystem|Toggle/Hold Inputs")
 		EInputState GamepadZoomState = EInputState::Hold;
 
+	/* Outpost */
+
+	//The location of the outpost that the player is defending. Enemy reinforcements always head here.
+	UPROPERTY(BlueprintReadWrite, Category = "OPWorldSubsystem|Outpost")
+		FVector OutpostLocation;
+
 	/* Enemies */
 
 	//An array of references to all enemies that are currently alive.
 	UPROPERTY(BlueprintReadOnly, Category = "OPWorldSubsystem|Enemies")
 		TArray<TObjectPtr<AActor>> EnemyArray;
 
+	/*
+	Adds an enemy to the global enemy array. Should be called whenever an enemy enters play, or is taken out of the enemy pool.
+	@param	Enemy	The enemy that just became active.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPWorldSubsystem|Enemies")
+		void RegisterEnemy(AActor* Enemy);
+
+	/*
+	Removes an enemy from the global enemy array, and updates enemy information. Should be called whenever an enemy dies, or is returned to the enemy pool.
+	@param	Enemy	The enemy that is no longer active.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPWorldSubsystem|Enemies")
+		void UnregisterEnemy(AActor* Enemy);
+
+	/* Interactables */
+
+	//An array of references to every interactable and destructible object that was placed at runtime, such as by level generation.
+	UPROPERTY(BlueprintReadOnly, Category = "OPWorldSubsystem|Interactables")
+		TArray<TObjectPtr<AActor>> InteractableArray;
+
+	/*
+	Adds an object to the global interactable array. Should be called for every gameplay object that is kept as its own actor, rather than drawn as an instance.
+	@param	Interactable	The object that just entered play.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPWorldSubsystem|Interactables")
+		void RegisterInteractable(AActor* Interactable);
+
+	/*
+	Removes an object from the global interactable array. Should be called whenever a registered object leaves play.
+	@param	Interactable	The object that is no longer in play.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPWorldSubsystem|Interactables")
+		void UnregisterInteractable(AActor* Interactable);
+
+	/* Component owners */
+
+	/*
+	Spawns an empty actor with a root component, that never ticks. Used to own components that share one actor instead of having one each, such as instanced meshes.
+	@param	World	The world to spawn the actor in.
+	@param	BaseName	The actor's name, which is made unique.
+	@return	The new actor, or nullptr if it couldn't be spawned.
+	*/
+	static AActor* SpawnComponentOwner(UWorld* World, FName BaseName);
+
 	/* Delegates */
 
 	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPWorldSubsystem|Delegates")
@@ -85,6 +148,14 @@ public:
 	UPROPERTY(BlueprintAssignable, BlueprintCallable, Category = "OPWorldSubsystem|Delegates")
 		FEnemyDelegate OnEnemyUpdate;
 
+	//Native-only delegates, for other systems that need to know exactly which enemy entered or left the enemy array.
+	FEnemyRegistryDelegate OnEnemyRegistered;
+	FEnemyRegistryDelegate OnEnemyUnregistered;
+
+	//Native-only delegates, for other systems that need to keep track of interactable objects.
+	FInteractableRegistryDelegate OnInteractableRegistered;
+	FInteractableRegistryDelegate OnInteractableUnregistered;
+
 protected:
 	
 };
\ No newline at end of file
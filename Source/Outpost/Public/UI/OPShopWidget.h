@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UINavWidget.h"
+#include "OPShopWidget.generated.h"
+
+//Forward declarations.
+class UOPShopSubsystem;
+
+/**
+ * The base class for the shop menu. Each button in the menu is registered with the catalog item it sells.
+ * Navigating to a button, with a mouse or a gamepad, starts preloading its item, and selecting it buys the item.
+ */
+UCLASS()
+class OUTPOST_API UOPShopWidget : public UUINavWidget
+{
+	GENERATED_BODY()
+
+public:
+	/*
+	Links a button in the menu to the catalog item that it sells.
+	@param	Component	The button in the menu.
+	@param	ItemIndex	The index of the item in the shop's catalog.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "OPShopWidget")
+		void RegisterItemComponent(UUINavComponent* Component, int32 ItemIndex);
+
+protected:
+	virtual void NativeConstruct() override;
+
+	/* Overridden from UINavWidget */
+
+	virtual void OnNavigate_Implementation(UUINavComponent* FromComponent, UUINavComponent* ToComponent) override;
+	virtual void OnSelect_Implementation(UUINavComponent* Component) override;
+
+	UPROPERTY()
+		TObjectPtr<UOPShopSubsystem> ShopSubsystem;
+
+	//The catalog item that each button in the menu sells.
+	UPROPERTY()
+		TMap<TObjectPtr<UUINavComponent>, int32> ItemComponents;
+};
\ No newline at end of file